@@ -0,0 +1,122 @@
+#ifndef IIWA_KDL_BATCH_KINEMATICS_H
+#define IIWA_KDL_BATCH_KINEMATICS_H
+
+#include <vector>
+
+#include <kdl/chain.hpp>
+#include <kdl/frames.hpp>
+#include <kdl/jntarray.hpp>
+
+#include "iiwa_kdl/worker_pool.h"
+
+namespace iiwa_kdl {
+
+//N joint configurations in SoA layout: q(j)[s] is the joint j of the sample s
+//	Each joint is a contiguous array, so the loops over the samples vectorize
+class JointBatch {
+	public:
+		JointBatch( unsigned int nj = 0, size_t n = 0 ) { resize( nj, n ); }
+
+		void resize( unsigned int nj, size_t n ) { _nj = nj; _n = n; _data.assign( (size_t)nj*n, 0.0 ); }
+
+		size_t size() const { return _n; }
+		unsigned int joints() const { return _nj; }
+
+		double *q( unsigned int j ) { return _data.data() + j*_n; }
+		const double *q( unsigned int j ) const { return _data.data() + j*_n; }
+
+		void set( size_t s, const KDL::JntArray &q ) { for(unsigned int j=0; j<_nj; j++) _data[ j*_n + s ] = q(j); }
+		void get( size_t s, KDL::JntArray &q ) const { for(unsigned int j=0; j<_nj; j++) q(j) = _data[ j*_n + s ]; }
+
+	private:
+		unsigned int _nj;
+		size_t _n;
+		std::vector<double> _data;
+};
+
+
+//N poses in SoA layout: 9 arrays for the rotation matrix (row major) and 3 for the position
+class PoseBatch {
+	public:
+		static const int R = 0;
+		static const int P = 9;
+
+		explicit PoseBatch( size_t n = 0 ) { resize( n ); }
+
+		void resize( size_t n ) { _n = n; _data.assign( 12*n, 0.0 ); }
+		size_t size() const { return _n; }
+
+		//Component k of all the samples: R(i,j) is k = R + 3*i + j, p(i) is k = P + i
+		double *c( int k ) { return _data.data() + k*_n; }
+		const double *c( int k ) const { return _data.data() + k*_n; }
+
+		void set( size_t s, const KDL::Frame &f ) {
+			for(int k=0; k<9; k++) _data[ (R + k)*_n + s ] = f.M.data[k];
+			for(int k=0; k<3; k++) _data[ (P + k)*_n + s ] = f.p.data[k];
+		}
+		void get( size_t s, KDL::Frame &f ) const {
+			for(int k=0; k<9; k++) f.M.data[k] = _data[ (R + k)*_n + s ];
+			for(int k=0; k<3; k++) f.p.data[k] = _data[ (P + k)*_n + s ];
+		}
+
+	private:
+		size_t _n;
+		std::vector<double> _data;
+};
+
+
+//FK and IK of many samples at once (offline evaluation of paths, trajectory pre-computation)
+//	fk: product of exponentials model read from the chain at q = 0, evaluated on blocks
+//		of samples with the samples in the inner loop (auto-vectorized, SIMD across samples)
+//	ik: numeric solver warm started with the previous solution of the sequence
+//	The samples are split in contiguous chunks, one for each worker of the pool
+class BatchKinematics {
+	public:
+		//threads <= 0: one worker for each hardware thread
+		BatchKinematics( const KDL::Chain &chain, int threads = 0 );
+		~BatchKinematics();
+
+		//False if the chain has joints other than revolute and prismatic ones
+		bool valid() const { return _valid; }
+		int threads() const { return _pool.size(); }
+
+		void fk( const JointBatch &q, PoseBatch &f );
+
+		//IK of the targets: sample s is seeded with the solution of s-1, the first of each chunk with q_init
+		//	With threads = 1 the whole batch is a single warm start sequence
+		//	status (optional) gets the return code of each CartToJnt call
+		//	Return the number of samples solved within eps
+		size_t ik( const PoseBatch &f, const KDL::JntArray &q_init, JointBatch &q, std::vector<int> *status = 0,
+				unsigned int maxiter = 100, double eps = 1e-6 );
+
+	private:
+		BatchKinematics( const BatchKinematics & );
+		BatchKinematics &operator=( const BatchKinematics & );
+
+		static const int BLOCK = 64;
+
+		void fk_job( int worker, const JointBatch *q, PoseBatch *f );
+		void fk_block( const JointBatch &q, size_t begin, size_t n, PoseBatch &f ) const;
+		void ik_job( int worker, const PoseBatch *f, const KDL::JntArray *q_init, JointBatch *q,
+				std::vector<int> *status, unsigned int maxiter, double eps, size_t *solved );
+
+		//Contiguous range of samples of a worker
+		void chunk( int worker, size_t n, size_t &begin, size_t &end ) const;
+
+		const KDL::Chain &_chain;
+		unsigned int _nj;
+		bool _valid;
+
+		//Joint axes, points on the axes (base frame, q = 0) and joint type
+		std::vector<KDL::Vector> _w;
+		std::vector<KDL::Vector> _r;
+		std::vector<bool> _prismatic;
+		//Tip pose at q = 0
+		KDL::Frame _M;
+
+		WorkerPool _pool;
+};
+
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef IIWA_KDL_CAPSULE_MODEL_H
+#define IIWA_KDL_CAPSULE_MODEL_H
+
+#include <kdl/chain.hpp>
+#include <kdl/frames.hpp>
+
+#include "iiwa_kdl/iiwa_types.h"
+#include "iiwa_kdl/iiwa_capsules_gen.h"
+
+namespace iiwa_kdl {
+
+//lbr_iiwa_link_0 .. lbr_iiwa_link_7
+const unsigned int IIWA_NLINKS = IIWA_NJ + 1;
+static_assert( iiwa_capsules_gen::NLINKS == IIWA_NLINKS, "The capsule model must have the links of the iiwa" );
+
+//Pairs of links at least two joints apart: the closer ones always touch through their joint
+//	Except link_5 - link_7: they touch across the short link_6 for |q6| > 1.3 rad, inside the limits
+const unsigned int IIWA_CAPSULE_PAIRS = ( IIWA_NLINKS - 1 )*( IIWA_NLINKS - 2 )/2 - 1;
+//Pairs stored for the distance kernel, a multiple of the SIMD width (the padding is ignored)
+const unsigned int IIWA_CAPSULE_PAIRS_PADDED = ( IIWA_CAPSULE_PAIRS + 7 ) & ~7u;
+
+
+//Capsule approximation of the iiwa links for the self collision checks of the ik
+//	The capsules (iiwa_capsules_gen.h) enclose the link meshes, they are generated by
+//	scripts/gen_iiwa_capsules.py in the frames of the links. update(q) moves them with
+//	the chain and computes the distance of all the pairs at once: the segment-segment
+//	distance kernel runs on SoA arrays, branch free, so the pairs are vectorized.
+//	No allocations: update() and clearanceGradient() can run in the control loop
+class CapsuleModel {
+	public:
+		//Chain lbr_iiwa_link_0 -> lbr_iiwa_link_7, the segment i ends in the frame of link i + 1
+		explicit CapsuleModel( const KDL::Chain &chain );
+
+		//False if the chain does not have the 7 segments of the capsule links
+		bool valid() const { return _valid; }
+
+		//Capsules in the base frame and distances of all the pairs at q
+		void update( const Vector7d &q );
+
+		//Links of the pair k
+		unsigned int linkA( unsigned int k ) const { return _pair_a[k]; }
+		unsigned int linkB( unsigned int k ) const { return _pair_b[k]; }
+
+		//Distance between the capsule surfaces of the pair k, negative if they intersect
+		double clearance( unsigned int k ) const { return _clearance[k]; }
+		//Smallest clearance of the last update and its pair
+		double minClearance( unsigned int *pair = 0 ) const;
+
+		//Gradient of clearance(k) wrt q at the last update
+		//	Only the joints between the two links change their distance
+		void clearanceGradient( unsigned int k, Vector7d &grad ) const;
+
+	private:
+		bool _valid;
+		const KDL::Chain &_chain;
+
+		//Capsules in the link frames: end points and radius
+		KDL::Vector _p0[IIWA_NLINKS];
+		KDL::Vector _p1[IIWA_NLINKS];
+		double _radius[IIWA_NLINKS];
+
+		unsigned int _pair_a[IIWA_CAPSULE_PAIRS];
+		unsigned int _pair_b[IIWA_CAPSULE_PAIRS];
+
+		//Last update: joint axes and origins in the base frame
+		KDL::Vector _axis[IIWA_NJ];
+		KDL::Vector _origin[IIWA_NJ];
+
+		//SoA input of the kernel: start point and direction of the segments a and b of each pair
+		//	_seg[0..2][k]: start of a, [3..5]: direction of a, [6..8]: start of b, [9..11]: direction of b
+		alignas(64) double _seg[12][IIWA_CAPSULE_PAIRS_PADDED];
+		//Output: parameters of the closest points on a and b, distance of the segments
+		alignas(64) double _s[IIWA_CAPSULE_PAIRS_PADDED];
+		alignas(64) double _t[IIWA_CAPSULE_PAIRS_PADDED];
+		alignas(64) double _dist[IIWA_CAPSULE_PAIRS_PADDED];
+		double _clearance[IIWA_CAPSULE_PAIRS];
+};
+
+}
+
+#endif
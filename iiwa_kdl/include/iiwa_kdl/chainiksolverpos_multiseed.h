@@ -0,0 +1,93 @@
+#ifndef IIWA_KDL_CHAINIKSOLVERPOS_MULTISEED_H
+#define IIWA_KDL_CHAINIKSOLVERPOS_MULTISEED_H
+
+#include <atomic>
+#include <random>
+#include <vector>
+
+#include "boost/function.hpp"
+
+#include <kdl/chain.hpp>
+#include <kdl/frames.hpp>
+#include <kdl/jntarray.hpp>
+#include <kdl/chainiksolver.hpp>
+#include <kdl/chainfksolverpos_recursive.hpp>
+
+#include "iiwa_kdl/chainiksolverpos_rt.h"
+#include "iiwa_kdl/worker_pool.h"
+
+namespace iiwa_kdl {
+
+//Position ik started from several seeds in parallel, for the targets a single warm start misses
+//	The seeds are the current joints, the previous solution (q_init) and random configurations
+//	inside the joint limits, drawn again at each call. Each seed runs a ChainIkSolverPos_RT on
+//	its own worker of a persistent pool: the first seed that converges cancels the others, and
+//	the seeds converged before the cancellation are ranked by distance from the current joints.
+//	When no seed converges q_out is the iterate with the smallest residual
+class ChainIkSolverPos_MultiSeed : public KDL::ChainIkSolverPos {
+	public:
+		//Velocity ik of a seed: KDL solvers keep internal state, each seed gets its own
+		typedef boost::function<KDL::ChainIkSolverVel*( const KDL::Chain & )> VelSolverFactory;
+
+		//seeds >= 2: current joints and previous solution, the others are random
+		//deadline: maximum time (seconds) of a CartToJnt call, <= 0 to disable it
+		ChainIkSolverPos_MultiSeed( const KDL::Chain &chain, const KDL::JntArray &q_min, const KDL::JntArray &q_max,
+				const VelSolverFactory &vel_factory, unsigned int seeds = 4, unsigned int maxiter = 100,
+				double eps = 1e-6, double deadline = 0.0, unsigned int random_seed = 1 );
+		~ChainIkSolverPos_MultiSeed();
+
+		//Measured joints: first seed and reference of the ranking (default: q_init of each call)
+		void setCurrent( const KDL::JntArray &q );
+		//Iterations and tolerance of every seed, between two CartToJnt calls
+		void setMaxIter( unsigned int maxiter ) { for(size_t i=0; i<_seeds.size(); i++) _seeds[i].iksolver->setMaxIter( maxiter ); }
+		void setEps( double eps ) { for(size_t i=0; i<_seeds.size(); i++) _seeds[i].iksolver->setEps( eps ); }
+
+		virtual int CartToJnt( const KDL::JntArray &q_init, const KDL::Frame &p_in, KDL::JntArray &q_out );
+
+		unsigned int getSeeds() const { return _seeds.size(); }
+		//Seed of the last solution (0 current, 1 previous, >= 2 random)
+		int getWinner() const { return _winner; }
+		//Iterations of the winner
+		unsigned int getIterations() const { return _iter; }
+
+		virtual const char* strError( const int error ) const;
+
+	private:
+		ChainIkSolverPos_MultiSeed( const ChainIkSolverPos_MultiSeed & );
+		ChainIkSolverPos_MultiSeed &operator=( const ChainIkSolverPos_MultiSeed & );
+
+		struct Seed {
+			KDL::ChainFkSolverPos_recursive *fksolver;
+			KDL::ChainIkSolverVel *iksolver_vel;
+			ChainIkSolverPos_RT *iksolver;
+			KDL::JntArray q_seed;
+			KDL::JntArray q_out;
+			int ret;
+		};
+
+		void seed_job( int worker );
+
+		const KDL::Chain &_chain;
+		unsigned int _nj;
+		KDL::JntArray _q_lo;
+		KDL::JntArray _q_hi;
+
+		std::vector<Seed> _seeds;
+		WorkerPool _pool;
+		//Built once: no allocation when the job is handed to the pool
+		boost::function<void(int)> _job;
+		std::atomic<bool> _converged;
+		const KDL::Frame *_target;
+
+		KDL::JntArray _q_current;
+		bool _has_current;
+		std::mt19937 _gen;
+		std::uniform_real_distribution<double> _unif;
+
+		int _winner;
+		unsigned int _iter;
+};
+
+}
+
+#endif
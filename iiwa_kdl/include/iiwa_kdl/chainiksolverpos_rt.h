@@ -0,0 +1,71 @@
+#ifndef IIWA_KDL_CHAINIKSOLVERPOS_RT_H
+#define IIWA_KDL_CHAINIKSOLVERPOS_RT_H
+
+#include <atomic>
+
+#include <kdl/chain.hpp>
+#include <kdl/frames.hpp>
+#include <kdl/jntarray.hpp>
+#include <kdl/chainiksolver.hpp>
+#include <kdl/chainfksolver.hpp>
+
+namespace iiwa_kdl {
+
+//Newton-Raphson position ik with a bounded execution time
+//	Same iteration of KDL::ChainIkSolverPos_NR, plus:
+//	- early exit when the joint update falls below eps_joints
+//	- wall clock deadline for each CartToJnt call
+//	- optional cancel flag, polled at each iteration (parallel solvers of the same target)
+//	- the best iterate (smallest cartesian error) is always returned in q_out
+//	Seed the solver with the previous solution (warm start) to converge in a few iterations
+class ChainIkSolverPos_RT : public KDL::ChainIkSolverPos {
+	public:
+		//Positive codes: q_out is the best iterate but the tolerance is not reached
+		static const int E_DEADLINE_EXCEEDED = 2;
+		static const int E_STALLED = 3;
+		static const int E_CANCELED = 4;
+		static const int E_IKSOLVERVEL_FAILED = -100;
+		static const int E_FKSOLVERPOS_FAILED = -101;
+
+		//deadline: maximum time (seconds) of a CartToJnt call, <= 0 to disable it
+		ChainIkSolverPos_RT( const KDL::Chain &chain, KDL::ChainFkSolverPos &fksolver, KDL::ChainIkSolverVel &iksolver,
+				unsigned int maxiter = 100, double eps = 1e-6, double eps_joints = 1e-9, double deadline = 0.0 );
+
+		virtual int CartToJnt( const KDL::JntArray &q_init, const KDL::Frame &p_in, KDL::JntArray &q_out );
+
+		void setDeadline( double deadline ) { _deadline = deadline; }
+		void setMaxIter( unsigned int maxiter ) { _maxiter = maxiter; }
+		void setEps( double eps ) { _eps = eps; }
+		//CartToJnt stops when *cancel becomes true, 0 to disable it. The flag is not owned
+		void setCancel( const std::atomic<bool> *cancel ) { _cancel = cancel; }
+
+		//Statistics of the last CartToJnt call
+		unsigned int getIterations() const { return _iter; }
+		double getResidual() const { return _best_err; }
+
+		virtual const char* strError( const int error ) const;
+		virtual void updateInternalDataStructures();
+
+	private:
+		const KDL::Chain &_chain;
+		KDL::ChainFkSolverPos &_fksolver;
+		KDL::ChainIkSolverVel &_iksolver;
+
+		unsigned int _maxiter;
+		double _eps;
+		double _eps_joints;
+		double _deadline;
+		const std::atomic<bool> *_cancel;
+
+		KDL::JntArray _delta_q;
+		KDL::JntArray _q_best;
+		KDL::Frame _f;
+		KDL::Twist _delta_twist;
+
+		unsigned int _iter;
+		double _best_err;
+};
+
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef IIWA_KDL_CHAINIKSOLVERPOS_SRS_H
+#define IIWA_KDL_CHAINIKSOLVERPOS_SRS_H
+
+#include <string>
+
+#include <Eigen/Geometry>
+
+#include <kdl/chain.hpp>
+#include <kdl/frames.hpp>
+#include <kdl/jntarray.hpp>
+#include <kdl/chainiksolver.hpp>
+
+#include "iiwa_kdl/iiwa_types.h"
+
+namespace iiwa_kdl {
+
+//Closed form position ik of a 7 dof spherical-revolute-spherical arm (lbr iiwa)
+//	The geometry is read from the KDL chain at q = 0 (product of exponentials):
+//	joints 1-2-3 must intersect in the shoulder S, joints 5-6-7 in the wrist W.
+//	The redundancy is parameterized by the arm angle psi, the rotation of the
+//	elbow around the S-W line. For a given psi the solution is found with
+//	Paden-Kahan subproblems: no iterations, no convergence failures.
+//	Among the (up to 8) solutions within the joint limits, the closest to q_init is returned.
+//	If the chain is not an SRS arm, or no solution is within the limits, the
+//	fallback numeric solver (if any) is used
+class ChainIkSolverPos_SRS : public KDL::ChainIkSolverPos {
+	public:
+		//KEEP_CURRENT: use the arm angle of q_init (search only if it is not feasible)
+		//MIN_CHANGE: search the arm angle closest to q_init in joint space
+		enum ArmAnglePolicy { KEEP_CURRENT, MIN_CHANGE };
+
+		static const int E_OUT_OF_REACH = -100;
+		static const int E_JOINT_LIMITS = -101;
+		static const int E_NOT_SRS = -102;
+		//Positive code: the fallback solver converged. Distinct from the positive codes of
+		//	ChainIkSolverPos_RT (2..4), which are returned as they are when it does not
+		static const int E_FALLBACK = 5;
+
+		ChainIkSolverPos_SRS( const KDL::Chain &chain, const KDL::JntArray &q_min, const KDL::JntArray &q_max,
+				KDL::ChainIkSolverPos *fallback = 0, ArmAnglePolicy policy = KEEP_CURRENT );
+
+		virtual int CartToJnt( const KDL::JntArray &q_init, const KDL::Frame &p_in, KDL::JntArray &q_out );
+
+		//Closed form solution only (no fallback)
+		int solve( const Eigen::Matrix3d &R, const Eigen::Vector3d &p, const Vector7d &q_ref, Vector7d &q ) const;
+
+		//Arm angle of a configuration
+		double armAngle( const Vector7d &q ) const;
+
+		//Forward kinematics of the product of exponentials model
+		void fk( const Vector7d &q, Eigen::Matrix3d &R, Eigen::Vector3d &p ) const;
+
+		//True when the chain geometry matches a SRS arm
+		bool geometryValid() const { return _valid; }
+
+		void setArmAnglePolicy( ArmAnglePolicy policy ) { _policy = policy; }
+		static bool policyFromString( const std::string &name, ArmAnglePolicy &policy );
+
+		//Zero configuration model: joint axes / points on the axes (base frame) and tip pose
+		bool setGeometry( const Eigen::Vector3d w[IIWA_NJ], const Eigen::Vector3d r[IIWA_NJ],
+				const Eigen::Matrix3d &M_R, const Eigen::Vector3d &M_p );
+
+		virtual const char* strError( const int error ) const;
+		virtual void updateInternalDataStructures();
+
+	private:
+		bool initFromChain();
+		//Elbow solutions for a target wrist position, independent of the arm angle
+		struct Elbow {
+			int n;
+			double q4[2];
+			Eigen::Matrix3d R0[2];
+			Eigen::Matrix3d R4[2];
+			Eigen::Vector3d u;
+		};
+		bool elbow( const Eigen::Vector3d &Wd, Elbow &el ) const;
+		//Best solution for a given arm angle: returns the squared distance from q_ref, inf if none
+		double solveArmAngle( double psi, const Eigen::Matrix3d &R, const Elbow &el,
+				const Vector7d &q_ref, Vector7d &q ) const;
+		//Shoulder rotation for q3 = 0 moving the wrist of the elbow angle q4 to Wd
+		bool referenceShoulder( double q4, const Eigen::Vector3d &Wd, Eigen::Matrix3d &R0 ) const;
+		bool withinLimits( const Vector7d &q ) const;
+
+		const KDL::Chain &_chain;
+		KDL::ChainIkSolverPos *_fallback;
+		ArmAnglePolicy _policy;
+		bool _valid;
+
+		Vector7d _q_min;
+		Vector7d _q_max;
+
+		//Joint axes and points on the axes at q = 0, base frame
+		Eigen::Vector3d _w[IIWA_NJ];
+		Eigen::Vector3d _r[IIWA_NJ];
+		//Tip pose at q = 0
+		Eigen::Matrix3d _M_R;
+		Eigen::Vector3d _M_p;
+		//Shoulder, elbow and wrist centers at q = 0, wrist center in the tip frame
+		Eigen::Vector3d _S0;
+		Eigen::Vector3d _E0;
+		Eigen::Vector3d _W0;
+		Eigen::Vector3d _W_tip;
+};
+
+}
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef IIWA_KDL_CHAINIKSOLVERVEL_DLS_H
+#define IIWA_KDL_CHAINIKSOLVERVEL_DLS_H
+
+#include <Eigen/Cholesky>
+
+#include <kdl/chain.hpp>
+#include <kdl/frames.hpp>
+#include <kdl/jntarray.hpp>
+#include <kdl/jacobian.hpp>
+#include <kdl/chainiksolver.hpp>
+#include <kdl/chainjnttojacsolver.hpp>
+
+#include "iiwa_kdl/iiwa_types.h"
+
+namespace iiwa_kdl {
+
+//Cost H(q) of a secondary task, descended in the null space of the redundant dof
+class NullspaceObjective {
+	public:
+		virtual ~NullspaceObjective() {}
+		//dH/dq at q. Called in every ik iteration: no allocations
+		virtual void gradient( const Vector7d &q, Vector7d &grad ) = 0;
+};
+
+
+//Weighted damped least squares velocity ik for the 7 joints of the iiwa
+//	qdot = W^-1 J^T (J W^-1 J^T + l^2 I)^-1 v + N z
+//	- the 6x6 system is factorized with a fixed size LDLT, no SVD of the jacobian
+//	- the damping l^2 grows only near singularities: l^2 = l_max^2 (1 - (w/w0)^2) when
+//		the manipulability w = sqrt(det(J W^-1 J^T)) is below w0, 0 otherwise
+//	- N z is the projection in the null space of the redundant dof of the joint
+//		centering velocity z = -k_null (q - q_rest) and of the descent -k_obj grad H(q)
+//		of an optional secondary objective (e.g. joint limits and self collision).
+//		N = I - W^-1 J^T (J W^-1 J^T)^-1 J uses the undamped factorization, so that N z
+//		does not move the tip; at an exact singularity (rank deficient J) it falls back
+//		to the damped one and N z leaks in the task space (isNullspaceDamped())
+//	Drop-in replacement of KDL::ChainIkSolverVel_pinv (e.g. in ChainIkSolverPos_NR)
+class ChainIkSolverVel_DLS : public KDL::ChainIkSolverVel {
+	public:
+		static const int E_JAC_FAILED = -100;
+
+		ChainIkSolverVel_DLS( const KDL::Chain &chain, double lambda_max = 0.1, double manip_threshold = 0.01 );
+
+		virtual int CartToJnt( const KDL::JntArray &q_in, const KDL::Twist &v_in, KDL::JntArray &qdot_out );
+		//Not implemented, as in ChainIkSolverVel_pinv
+		virtual int CartToJnt( const KDL::JntArray &, const KDL::FrameVel &, KDL::JntArrayVel & ) { return (error = E_NOT_IMPLEMENTED); }
+
+		//Diagonal joint weights (all 1 by default): heavier joints move less
+		void setJointWeights( const Vector7d &w );
+		//Rest posture and gain of the null space joint centering, gain 0 disables it
+		void setNullspace( const Vector7d &q_rest, double gain );
+		//Secondary objective and gain of its descent, 0 disables it. The objective is not owned
+		void setNullspaceObjective( NullspaceObjective *objective, double gain );
+		void setDamping( double lambda_max, double manip_threshold );
+
+		//Damping and manipulability of the last CartToJnt call
+		double getLambdaSquared() const { return _lambda2; }
+		double getManipulability() const { return _manip; }
+		//The null space projection of the last CartToJnt call used the damped factorization
+		bool isNullspaceDamped() const { return _null_damped; }
+
+		virtual void updateInternalDataStructures();
+
+	private:
+		const KDL::Chain &_chain;
+		KDL::ChainJntToJacSolver _jac_solver;
+		KDL::Jacobian _jac;
+
+		double _lambda_max;
+		double _manip_threshold;
+		double _null_gain;
+		NullspaceObjective *_objective;
+		double _objective_gain;
+
+		Vector7d _w_inv;
+		Vector7d _q_rest;
+
+		//Preallocated fixed size work space
+		Jacobian7d _jw;
+		Matrix6d _A;
+		Eigen::LDLT<Matrix6d> _ldlt;
+		//Undamped factorization of the null space projection, copied before the damping
+		Eigen::LDLT<Matrix6d> _ldlt_null;
+		Vector6d _v;
+		Vector6d _y;
+		Vector7d _qdot;
+		Vector7d _z;
+		Vector7d _grad;
+
+		double _lambda2;
+		double _manip;
+		bool _null_damped;
+};
+
+}
+
+#endif
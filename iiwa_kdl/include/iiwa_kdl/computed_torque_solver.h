@@ -0,0 +1,59 @@
+#ifndef IIWA_KDL_COMPUTED_TORQUE_SOLVER_H
+#define IIWA_KDL_COMPUTED_TORQUE_SOLVER_H
+
+#include <string>
+
+#include <kdl/chain.hpp>
+#include <kdl/jntarray.hpp>
+#include <kdl/jntspaceinertiamatrix.hpp>
+#include <kdl/chaindynparam.hpp>
+#include <kdl/chainidsolver_recursive_newton_euler.hpp>
+
+#include "iiwa_kdl/iiwa_kernel.h"
+
+namespace iiwa_kdl {
+
+//Computed torque command: tau = M(q)*qdd_ref + C(q,dq)*dq + g(q)
+//	RNE: a single recursive Newton-Euler pass with qdd = qdd_ref gives
+//		exactly the expression above, without building M, C and g
+//	DYN_PARAM: legacy JntToMass + JntToCoriolis + JntToGravity path,
+//		kept for A/B comparisons
+//	FIXED: the same RNE pass with the generated iiwa kernel (IiwaKernel). If the
+//		kernel does not match the chain the solver falls back to RNE, see engine()
+class ComputedTorqueSolver {
+	public:
+		enum Engine { RNE, DYN_PARAM, FIXED };
+
+		ComputedTorqueSolver( const KDL::Chain &chain, const KDL::Vector &gravity, Engine engine = RNE );
+		~ComputedTorqueSolver();
+
+		//All the arrays must be sized to the number of joints of the chain
+		int compute( const KDL::JntArray &q, const KDL::JntArray &dq, const KDL::JntArray &qdd_ref, KDL::JntArray &tau );
+
+		Engine engine() const { return _engine; }
+
+		//Parse the engine name: "rne", "dyn_param" or "fixed"
+		static bool engineFromString( const std::string &name, Engine &engine );
+
+	private:
+		ComputedTorqueSolver( const ComputedTorqueSolver & );
+		ComputedTorqueSolver &operator=( const ComputedTorqueSolver & );
+
+		Engine _engine;
+		unsigned int _nj;
+
+		KDL::ChainIdSolver_RNE _id_solver;
+		KDL::Wrenches _f_ext;
+
+		KDL::ChainDynParam _dyn_param;
+		KDL::JntSpaceInertiaMatrix _M;
+		KDL::JntArray _coriol;
+		KDL::JntArray _grav;
+
+		IiwaKernel *_kernel;
+		Vector7d _tau;
+};
+
+}
+
+#endif
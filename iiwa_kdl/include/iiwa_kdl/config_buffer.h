@@ -0,0 +1,75 @@
+#ifndef IIWA_KDL_CONFIG_BUFFER_H
+#define IIWA_KDL_CONFIG_BUFFER_H
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+namespace iiwa_kdl {
+
+//Configuration written by the reconfigure callback, read by a control loop
+//	Same seqlock of the joint state snapshot: odd sequence while write() copies the
+//	configuration, even again once it is whole. read() retries on an odd or changed sequence,
+//	so the readers never see a mix of two updates. The configuration is stored as atomic
+//	words: a read concurrent with a write is not a data race, only a retry.
+//	No lock and no allocation on either side. One writer at a time (the dynamic_reconfigure
+//	server serializes its callbacks), any number of readers
+template <typename T>
+class ConfigBuffer {
+	static_assert( std::is_trivially_copyable<T>::value, "ConfigBuffer needs a plain struct" );
+
+	public:
+		ConfigBuffer() : _seq( 0 ) {
+			for(unsigned int i=0; i<WORDS; i++) _words[i].store( 0, std::memory_order_relaxed );
+		}
+
+		void write( const T &cfg ) {
+			uint64_t w[WORDS] = {};
+			memcpy( w, &cfg, sizeof(T) );
+
+			const uint64_t s = _seq.load( std::memory_order_relaxed );
+			//Odd sequence: write in progress
+			_seq.store( s + 1, std::memory_order_relaxed );
+			std::atomic_thread_fence( std::memory_order_release );
+
+			for(unsigned int i=0; i<WORDS; i++) _words[i].store( w[i], std::memory_order_relaxed );
+
+			//Even sequence: the configuration is whole again
+			_seq.store( s + 2, std::memory_order_release );
+		}
+
+		//Version of the newest configuration (number of writes), 0 before the first write
+		uint64_t version() const { return _seq.load( std::memory_order_acquire ) >> 1; }
+
+		//Copy of the newest configuration if it is newer than version (then updated)
+		bool read( T &cfg, uint64_t &version ) const {
+			uint64_t w[WORDS];
+			uint64_t s0, s1;
+			do {
+				s0 = _seq.load( std::memory_order_acquire );
+				//Wait the end of the write
+				if( s0 & 1 ) continue;
+				if( ( s0 >> 1 ) == version ) return false;
+
+				for(unsigned int i=0; i<WORDS; i++) w[i] = _words[i].load( std::memory_order_relaxed );
+
+				std::atomic_thread_fence( std::memory_order_acquire );
+				s1 = _seq.load( std::memory_order_relaxed );
+			} while( ( s0 & 1 ) || s0 != s1 );
+
+			memcpy( &cfg, w, sizeof(T) );
+			version = s0 >> 1;
+			return true;
+		}
+
+	private:
+		enum { WORDS = ( sizeof(T) + sizeof(uint64_t) - 1 )/sizeof(uint64_t) };
+
+		std::atomic<uint64_t> _seq;
+		std::atomic<uint64_t> _words[WORDS];
+};
+
+}
+
+#endif
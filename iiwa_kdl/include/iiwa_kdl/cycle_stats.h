@@ -0,0 +1,66 @@
+#ifndef IIWA_KDL_CYCLE_STATS_H
+#define IIWA_KDL_CYCLE_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "ros/ros.h"
+#include <diagnostic_msgs/DiagnosticArray.h>
+
+#include "iiwa_kdl/latency_histogram.h"
+
+namespace iiwa_kdl {
+
+//Timing statistics of a control loop
+//	One histogram for each stage (ik, dynamics, publish, cycle time, latency...)
+//	plus the counters of overruns and solver failures.
+//	The control thread records samples without locks nor allocations, a ros::Timer
+//	(spinner thread) publishes the summary on /diagnostics at low rate
+class CycleStats {
+	public:
+		//The stage names are fixed at construction: record() uses their index
+		CycleStats( const std::string &name, const std::vector<std::string> &stages );
+		~CycleStats();
+
+		//Publish every 1/rate s (rate <= 0: no publication)
+		void init( ros::NodeHandle &nh, double rate );
+
+		//Monotonic time in ns
+		static int64_t now() {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch() ).count();
+		}
+
+		void record( int stage, int64_t ns ) { _hist[stage].record( ns ); }
+		void overrun() { _overruns.fetch_add(1, std::memory_order_relaxed); }
+		void failure() { _failures.fetch_add(1, std::memory_order_relaxed); }
+
+		//Summary table (us), e.g. on shutdown
+		void dump( std::ostream &os ) const;
+
+	private:
+		CycleStats( const CycleStats & );
+		CycleStats &operator=( const CycleStats & );
+
+		void publish_cb( const ros::TimerEvent & );
+
+		std::string _name;
+		std::vector<std::string> _stages;
+		LatencyHistogram *_hist;
+		std::atomic<uint64_t> _overruns;
+		std::atomic<uint64_t> _failures;
+		//Overruns at the previous publication: the level is WARN if they grow
+		uint64_t _last_overruns;
+
+		ros::Publisher _diag_pub;
+		ros::Timer _timer;
+		diagnostic_msgs::DiagnosticArray _diag;
+};
+
+}
+
+#endif
@@ -0,0 +1,37 @@
+//Generated by scripts/gen_iiwa_capsules.py from the lbr_iiwa_description meshes: do not edit
+//	Enclosing capsules of lbr_iiwa_link_0 .. lbr_iiwa_link_7, radius padding 0.0 m
+#ifndef IIWA_KDL_IIWA_CAPSULES_GEN_H
+#define IIWA_KDL_IIWA_CAPSULES_GEN_H
+
+namespace iiwa_kdl {
+namespace iiwa_capsules_gen {
+
+constexpr unsigned int NLINKS = 8;
+constexpr const char *LINK_PREFIX = "lbr_iiwa_link_";
+//Segment end points in the frame of link i and radius (m)
+constexpr double P0[NLINKS][3] = {
+	{ -0.04261, -0.007562, 0.064784 },
+	{ 0.000383, 0.007862, 0.030387 },
+	{ 0.000429, -0.002443, 0.040637 },
+	{ -0.000211, -0.011808, 0.025852 },
+	{ -5e-06, -0.001625, 0.049277 },
+	{ 0.0, -6.7e-05, 0.023352 },
+	{ 1e-06, -0.03101, -0.005424 },
+	{ -0.000465, 4e-06, 0.00649 },
+};
+constexpr double P1[NLINKS][3] = {
+	{ 0.0081, 0.000643, 0.054523 },
+	{ -3e-06, -0.04869, 0.203757 },
+	{ 0.000869, 0.150211, -0.009115 },
+	{ 4e-06, 0.050442, 0.21803 },
+	{ 6.7e-05, 0.154516, -0.010421 },
+	{ -0.000409, 0.080152, 0.1975 },
+	{ 1e-06, 0.031898, -0.005424 },
+	{ 0.001402, 2.1e-05, 0.006491 },
+};
+constexpr double RADIUS[NLINKS] = { 0.133004, 0.098212, 0.094319, 0.083893, 0.08396, 0.071945, 0.075475, 0.052283 };
+
+}
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef IIWA_KDL_IIWA_KERNEL_H
+#define IIWA_KDL_IIWA_KERNEL_H
+
+#include <string>
+
+#include <kdl/chain.hpp>
+#include <kdl/frames.hpp>
+
+#include "iiwa_kdl/iiwa_types.h"
+#include "iiwa_kdl/iiwa_kernel_gen.h"
+
+namespace iiwa_kdl {
+
+static_assert( iiwa_gen::NJ == IIWA_NJ, "The generated kernel must have the joints of the iiwa" );
+
+//Kinematics and dynamics backend of the controllers
+//	KDL: the generic solvers built from the chain
+//	FIXED: the iiwa kernels generated from the URDF at build time (IiwaKernel)
+enum KinematicsBackend { BACKEND_KDL, BACKEND_FIXED };
+
+//Parse the backend name: "kdl" or "fixed"
+bool backendFromString( const std::string &name, KinematicsBackend &backend );
+
+//Maximum difference from the KDL solvers accepted for the fixed kernels
+const double IIWA_KERNEL_TOLERANCE = 1e-9;
+
+
+//FK, jacobian and RNEA of the iiwa, specialized for its fixed structure
+//	The code in iiwa_kernel_gen.h is generated by scripts/gen_iiwa_kernel.py: one
+//	unrolled block for each joint, with the constant geometry and inertial parameters
+//	folded in. No segment vectors, no virtual calls and fixed size storage only.
+//	The model is the one of the URDF used at build time: compare() checks it against
+//	the chain loaded at run time, use the kernel only if it matches
+class IiwaKernel {
+	public:
+		explicit IiwaKernel( const KDL::Vector &gravity = KDL::Vector( 0.0, 0.0, -9.81 ) );
+
+		//Frames of the 7 segments in the base frame, the tip is frames[6]
+		void fk( const Vector7d &q, KDL::Frame *frames ) const;
+		void fk( const Vector7d &q, KDL::Frame &tip ) const;
+
+		//Base frame jacobian of the tip, same convention of KDL::ChainJntToJacSolver
+		void jacobian( const Vector7d &q, Jacobian7d &J ) const;
+		//Jacobian from the frames computed by fk()
+		static void jacobian( const KDL::Frame *frames, Jacobian7d &J );
+
+		//tau = M(q)*qdd + C(q,dq)*dq + g(q), no external wrenches
+		void rnea( const Vector7d &q, const Vector7d &dq, const Vector7d &qdd, Vector7d &tau ) const;
+
+		//Maximum difference of fk, jacobian and rnea from the KDL solvers of the chain,
+		//	over samples random configurations. Infinite if the structure is different
+		double compare( const KDL::Chain &chain, int samples = 100, unsigned int seed = 1 ) const;
+		bool matches( const KDL::Chain &chain, double tol = IIWA_KERNEL_TOLERANCE ) const { return compare( chain ) <= tol; }
+
+	private:
+		double _gravity[3];
+};
+
+}
+
+#endif
@@ -0,0 +1,612 @@
+//Generated by scripts/gen_iiwa_kernel.py from lbr_iiwa_description/urdf/no-controllers/lbr_iiwa.urdf.xacro: do not edit
+//	Chain lbr_iiwa_link_0 -> lbr_iiwa_link_7, 7 revolute joints
+#ifndef IIWA_KDL_IIWA_KERNEL_GEN_H
+#define IIWA_KDL_IIWA_KERNEL_GEN_H
+
+#include <cmath>
+
+namespace iiwa_kdl {
+namespace iiwa_gen {
+
+constexpr unsigned int NJ = 7;
+constexpr const char *BASE_LINK = "lbr_iiwa_link_0";
+constexpr const char *TIP_LINK = "lbr_iiwa_link_7";
+//Joint axis: axis AXIS[i] of the segment frame, direction AXIS_SIGN[i]
+constexpr int AXIS[NJ] = { 2, 2, 2, 2, 2, 2, 2 };
+constexpr double AXIS_SIGN[NJ] = { 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0 };
+
+//Frames of the 7 segments in the base frame: R[i] row major and p[i]
+inline void fk( const double *q, double (*R)[9], double (*p)[3] ) {
+	//lbr_iiwa_joint_1
+	const double c0 = std::cos( q[0] ), s0 = std::sin( q[0] );
+	const double L0_1 = -s0;
+	R[0][0] = c0;
+	R[0][1] = L0_1;
+	R[0][2] = 0.0;
+	R[0][3] = s0;
+	R[0][4] = c0;
+	R[0][5] = 0.0;
+	R[0][6] = 0.0;
+	R[0][7] = 0.0;
+	R[0][8] = 1.0;
+	p[0][0] = 0.0;
+	p[0][1] = 0.0;
+	p[0][2] = 0.1575;
+	//lbr_iiwa_joint_2
+	const double c1 = std::cos( q[1] ), s1 = std::sin( q[1] );
+	const double L1_2 = -c1;
+	const double R1_3 = c0*L1_2;
+	const double R1_4 = c0*s1;
+	const double R1_5 = s0*L1_2;
+	const double R1_6 = s0*s1;
+	R[1][0] = R1_3;
+	R[1][1] = R1_4;
+	R[1][2] = L0_1;
+	R[1][3] = R1_5;
+	R[1][4] = R1_6;
+	R[1][5] = c0;
+	R[1][6] = s1;
+	R[1][7] = c1;
+	R[1][8] = 0.0;
+	p[1][0] = 0.0;
+	p[1][1] = 0.0;
+	p[1][2] = 0.36;
+	//lbr_iiwa_joint_3
+	const double c2 = std::cos( q[2] ), s2 = std::sin( q[2] );
+	const double L2_7 = -c2;
+	const double p2_8 = 0.2045*R1_4;
+	const double p2_9 = 0.2045*R1_6;
+	const double p2_10 = 0.2045*c1;
+	const double p2_11 = p2_10 + 0.36;
+	const double R2_12 = R1_3*L2_7 + L0_1*s2;
+	const double R2_13 = R1_3*s2 + L0_1*c2;
+	const double R2_14 = R1_5*L2_7 + c0*s2;
+	const double R2_15 = R1_5*s2 + c0*c2;
+	const double R2_16 = s1*L2_7;
+	const double R2_17 = s1*s2;
+	R[2][0] = R2_12;
+	R[2][1] = R2_13;
+	R[2][2] = R1_4;
+	R[2][3] = R2_14;
+	R[2][4] = R2_15;
+	R[2][5] = R1_6;
+	R[2][6] = R2_16;
+	R[2][7] = R2_17;
+	R[2][8] = c1;
+	p[2][0] = p2_8;
+	p[2][1] = p2_9;
+	p[2][2] = p2_11;
+	//lbr_iiwa_joint_4
+	const double c3 = std::cos( q[3] ), s3 = std::sin( q[3] );
+	const double L3_18 = -s3;
+	const double p3_19 = 0.2155*R1_4;
+	const double p3_20 = 0.2155*R1_6;
+	const double p3_21 = 0.2155*c1;
+	const double p3_22 = p2_8 + p3_19;
+	const double p3_23 = p2_9 + p3_20;
+	const double p3_24 = p2_11 + p3_21;
+	const double R3_25 = R2_12*c3 + R1_4*s3;
+	const double R3_26 = R2_12*L3_18 + R1_4*c3;
+	const double R3_27 = -R2_13;
+	const double R3_28 = R2_14*c3 + R1_6*s3;
+	const double R3_29 = R2_14*L3_18 + R1_6*c3;
+	const double R3_30 = -R2_15;
+	const double R3_31 = R2_16*c3 + c1*s3;
+	const double R3_32 = R2_16*L3_18 + c1*c3;
+	const double R3_33 = -R2_17;
+	R[3][0] = R3_25;
+	R[3][1] = R3_26;
+	R[3][2] = R3_27;
+	R[3][3] = R3_28;
+	R[3][4] = R3_29;
+	R[3][5] = R3_30;
+	R[3][6] = R3_31;
+	R[3][7] = R3_32;
+	R[3][8] = R3_33;
+	p[3][0] = p3_22;
+	p[3][1] = p3_23;
+	p[3][2] = p3_24;
+	//lbr_iiwa_joint_5
+	const double c4 = std::cos( q[4] ), s4 = std::sin( q[4] );
+	const double L4_34 = -c4;
+	const double p4_35 = 0.1845*R3_26;
+	const double p4_36 = 0.1845*R3_29;
+	const double p4_37 = 0.1845*R3_32;
+	const double p4_38 = p3_22 + p4_35;
+	const double p4_39 = p3_23 + p4_36;
+	const double p4_40 = p3_24 + p4_37;
+	const double R4_41 = R3_25*L4_34 + R3_27*s4;
+	const double R4_42 = R3_25*s4 + R3_27*c4;
+	const double R4_43 = R3_28*L4_34 + R3_30*s4;
+	const double R4_44 = R3_28*s4 + R3_30*c4;
+	const double R4_45 = R3_31*L4_34 + R3_33*s4;
+	const double R4_46 = R3_31*s4 + R3_33*c4;
+	R[4][0] = R4_41;
+	R[4][1] = R4_42;
+	R[4][2] = R3_26;
+	R[4][3] = R4_43;
+	R[4][4] = R4_44;
+	R[4][5] = R3_29;
+	R[4][6] = R4_45;
+	R[4][7] = R4_46;
+	R[4][8] = R3_32;
+	p[4][0] = p4_38;
+	p[4][1] = p4_39;
+	p[4][2] = p4_40;
+	//lbr_iiwa_joint_6
+	const double c5 = std::cos( q[5] ), s5 = std::sin( q[5] );
+	const double L5_47 = -s5;
+	const double p5_48 = 0.2155*R3_26;
+	const double p5_49 = 0.2155*R3_29;
+	const double p5_50 = 0.2155*R3_32;
+	const double p5_51 = p4_38 + p5_48;
+	const double p5_52 = p4_39 + p5_49;
+	const double p5_53 = p4_40 + p5_50;
+	const double R5_54 = R4_41*c5 + R3_26*s5;
+	const double R5_55 = R4_41*L5_47 + R3_26*c5;
+	const double R5_56 = -R4_42;
+	const double R5_57 = R4_43*c5 + R3_29*s5;
+	const double R5_58 = R4_43*L5_47 + R3_29*c5;
+	const double R5_59 = -R4_44;
+	const double R5_60 = R4_45*c5 + R3_32*s5;
+	const double R5_61 = R4_45*L5_47 + R3_32*c5;
+	const double R5_62 = -R4_46;
+	R[5][0] = R5_54;
+	R[5][1] = R5_55;
+	R[5][2] = R5_56;
+	R[5][3] = R5_57;
+	R[5][4] = R5_58;
+	R[5][5] = R5_59;
+	R[5][6] = R5_60;
+	R[5][7] = R5_61;
+	R[5][8] = R5_62;
+	p[5][0] = p5_51;
+	p[5][1] = p5_52;
+	p[5][2] = p5_53;
+	//lbr_iiwa_joint_7
+	const double c6 = std::cos( q[6] ), s6 = std::sin( q[6] );
+	const double L6_63 = -c6;
+	const double p6_64 = 0.081*R5_55;
+	const double p6_65 = 0.081*R5_58;
+	const double p6_66 = 0.081*R5_61;
+	const double p6_67 = p5_51 + p6_64;
+	const double p6_68 = p5_52 + p6_65;
+	const double p6_69 = p5_53 + p6_66;
+	const double R6_70 = R5_54*L6_63 + R5_56*s6;
+	const double R6_71 = R5_54*s6 + R5_56*c6;
+	const double R6_72 = R5_57*L6_63 + R5_59*s6;
+	const double R6_73 = R5_57*s6 + R5_59*c6;
+	const double R6_74 = R5_60*L6_63 + R5_62*s6;
+	const double R6_75 = R5_60*s6 + R5_62*c6;
+	R[6][0] = R6_70;
+	R[6][1] = R6_71;
+	R[6][2] = R5_55;
+	R[6][3] = R6_72;
+	R[6][4] = R6_73;
+	R[6][5] = R5_58;
+	R[6][6] = R6_74;
+	R[6][7] = R6_75;
+	R[6][8] = R5_61;
+	p[6][0] = p6_67;
+	p[6][1] = p6_68;
+	p[6][2] = p6_69;
+}
+
+
+//Inverse dynamics: tau = M(q)*qdd + C(q,dq)*dq + g(q), gravity g in the base frame
+inline void rnea( const double *q, const double *dq, const double *qdd, const double *g, double *tau ) {
+	const double ga[3] = { -g[0], -g[1], -g[2] };
+	//lbr_iiwa_joint_1
+	const double c0 = std::cos( q[0] ), s0 = std::sin( q[0] );
+	const double L0_1 = -s0;
+	const double a0_2 = c0*ga[0] + s0*ga[1];
+	const double a0_3 = L0_1*ga[0] + c0*ga[1];
+	const double F0_4 = 0.03*qdd[0];
+	const double F0_7 = a0_2 + F0_4;
+	const double F0_9 = 4.0*F0_7;
+	const double N0_12 = 0.02*qdd[0];
+	//lbr_iiwa_joint_2
+	const double c1 = std::cos( q[1] ), s1 = std::sin( q[1] );
+	const double L1_14 = -c1;
+	const double a1_15 = L1_14*a0_2 + s1*ga[2];
+	const double a1_16 = s1*a0_2 + c1*ga[2];
+	const double w1_17 = s1*dq[0];
+	const double w1_18 = c1*dq[0];
+	const double wd1_19 = s1*qdd[0];
+	const double wd1_20 = c1*qdd[0];
+	const double wd1_21 = w1_18*dq[1];
+	const double wd1_22 = -w1_17*dq[1];
+	const double wd1_23 = wd1_19 + wd1_21;
+	const double wd1_24 = wd1_20 + wd1_22;
+	const double F1_25 = 0.042*wd1_24 - 0.059*qdd[1];
+	const double F1_26 = 0.0003*qdd[1] - 0.042*wd1_23;
+	const double F1_27 = 0.059*wd1_23 - 0.0003*wd1_24;
+	const double F1_28 = 0.042*w1_18 - 0.059*dq[1];
+	const double F1_29 = 0.0003*dq[1] - 0.042*w1_17;
+	const double F1_30 = 0.059*w1_17 - 0.0003*w1_18;
+	const double F1_31 = w1_18*F1_30 - dq[1]*F1_29;
+	const double F1_32 = dq[1]*F1_28 - w1_17*F1_30;
+	const double F1_33 = w1_17*F1_29 - w1_18*F1_28;
+	const double F1_34 = a1_15 + F1_25 + F1_31;
+	const double F1_35 = a1_16 + F1_26 + F1_32;
+	const double F1_36 = a0_3 + F1_27 + F1_33;
+	const double F1_37 = 4.0*F1_34;
+	const double F1_38 = 4.0*F1_35;
+	const double F1_39 = 4.0*F1_36;
+	const double N1_40 = 0.05*wd1_23;
+	const double N1_41 = 0.018*wd1_24;
+	const double N1_42 = 0.044*qdd[1];
+	const double N1_43 = 0.05*w1_17;
+	const double N1_44 = 0.018*w1_18;
+	const double N1_45 = 0.044*dq[1];
+	const double N1_46 = w1_18*N1_45 - dq[1]*N1_44;
+	const double N1_47 = dq[1]*N1_43 - w1_17*N1_45;
+	const double N1_48 = w1_17*N1_44 - w1_18*N1_43;
+	const double N1_49 = N1_40 + N1_46;
+	const double N1_50 = N1_41 + N1_47;
+	const double N1_51 = N1_42 + N1_48;
+	//lbr_iiwa_joint_3
+	const double c2 = std::cos( q[2] ), s2 = std::sin( q[2] );
+	const double L2_52 = -c2;
+	const double a2_53 = -0.2045*qdd[1];
+	const double a2_54 = 0.2045*wd1_23;
+	const double a2_55 = -0.2045*dq[1];
+	const double a2_56 = 0.2045*w1_17;
+	const double a2_57 = w1_18*a2_56;
+	const double a2_58 = dq[1]*a2_55 - w1_17*a2_56;
+	const double a2_59 = -w1_18*a2_55;
+	const double a2_60 = a1_15 + a2_53 + a2_57;
+	const double a2_61 = a1_16 + a2_58;
+	const double a2_62 = a0_3 + a2_54 + a2_59;
+	const double a2_63 = L2_52*a2_60 + s2*a2_62;
+	const double a2_64 = s2*a2_60 + c2*a2_62;
+	const double w2_65 = L2_52*w1_17 + s2*dq[1];
+	const double w2_66 = s2*w1_17 + c2*dq[1];
+	const double wd2_67 = L2_52*wd1_23 + s2*qdd[1];
+	const double wd2_68 = s2*wd1_23 + c2*qdd[1];
+	const double w2_69 = w1_18 + dq[2];
+	const double wd2_70 = w2_66*dq[2];
+	const double wd2_71 = -w2_65*dq[2];
+	const double wd2_72 = wd2_67 + wd2_70;
+	const double wd2_73 = wd2_68 + wd2_71;
+	const double wd2_74 = wd1_24 + qdd[2];
+	const double F2_75 = 0.13*wd2_73 - 0.03*wd2_74;
+	const double F2_76 = -0.13*wd2_72;
+	const double F2_77 = 0.03*wd2_72;
+	const double F2_78 = 0.13*w2_66 - 0.03*w2_69;
+	const double F2_79 = -0.13*w2_65;
+	const double F2_80 = 0.03*w2_65;
+	const double F2_81 = w2_66*F2_80 - w2_69*F2_79;
+	const double F2_82 = w2_69*F2_78 - w2_65*F2_80;
+	const double F2_83 = w2_65*F2_79 - w2_66*F2_78;
+	const double F2_84 = a2_63 + F2_75 + F2_81;
+	const double F2_85 = a2_64 + F2_76 + F2_82;
+	const double F2_86 = a2_61 + F2_77 + F2_83;
+	const double F2_87 = 3.0*F2_84;
+	const double F2_88 = 3.0*F2_85;
+	const double F2_89 = 3.0*F2_86;
+	const double N2_90 = 0.08*wd2_72;
+	const double N2_91 = 0.075*wd2_73;
+	const double N2_92 = 0.01*wd2_74;
+	const double N2_93 = 0.08*w2_65;
+	const double N2_94 = 0.075*w2_66;
+	const double N2_95 = 0.01*w2_69;
+	const double N2_96 = w2_66*N2_95 - w2_69*N2_94;
+	const double N2_97 = w2_69*N2_93 - w2_65*N2_95;
+	const double N2_98 = w2_65*N2_94 - w2_66*N2_93;
+	const double N2_99 = N2_90 + N2_96;
+	const double N2_100 = N2_91 + N2_97;
+	const double N2_101 = N2_92 + N2_98;
+	//lbr_iiwa_joint_4
+	const double c3 = std::cos( q[3] ), s3 = std::sin( q[3] );
+	const double L3_102 = -s3;
+	const double a3_103 = 0.2155*wd2_73;
+	const double a3_104 = -0.2155*wd2_72;
+	const double a3_105 = 0.2155*w2_66;
+	const double a3_106 = -0.2155*w2_65;
+	const double a3_107 = -w2_69*a3_106;
+	const double a3_108 = w2_69*a3_105;
+	const double a3_109 = w2_65*a3_106 - w2_66*a3_105;
+	const double a3_110 = a2_63 + a3_103 + a3_107;
+	const double a3_111 = a2_64 + a3_104 + a3_108;
+	const double a3_112 = a2_61 + a3_109;
+	const double a3_113 = c3*a3_110 + s3*a3_112;
+	const double a3_114 = L3_102*a3_110 + c3*a3_112;
+	const double a3_115 = -a3_111;
+	const double w3_116 = c3*w2_65 + s3*w2_69;
+	const double w3_117 = L3_102*w2_65 + c3*w2_69;
+	const double w3_118 = -w2_66;
+	const double wd3_119 = c3*wd2_72 + s3*wd2_74;
+	const double wd3_120 = L3_102*wd2_72 + c3*wd2_74;
+	const double wd3_121 = -wd2_73;
+	const double w3_122 = w3_118 + dq[3];
+	const double wd3_123 = w3_117*dq[3];
+	const double wd3_124 = -w3_116*dq[3];
+	const double wd3_125 = wd3_119 + wd3_123;
+	const double wd3_126 = wd3_120 + wd3_124;
+	const double wd3_127 = wd3_121 + qdd[3];
+	const double F3_128 = 0.034*wd3_126 - 0.067*wd3_127;
+	const double F3_129 = -0.034*wd3_125;
+	const double F3_130 = 0.067*wd3_125;
+	const double F3_131 = 0.034*w3_117 - 0.067*w3_122;
+	const double F3_132 = -0.034*w3_116;
+	const double F3_133 = 0.067*w3_116;
+	const double F3_134 = w3_117*F3_133 - w3_122*F3_132;
+	const double F3_135 = w3_122*F3_131 - w3_116*F3_133;
+	const double F3_136 = w3_116*F3_132 - w3_117*F3_131;
+	const double F3_137 = a3_113 + F3_128 + F3_134;
+	const double F3_138 = a3_114 + F3_129 + F3_135;
+	const double F3_139 = a3_115 + F3_130 + F3_136;
+	const double F3_140 = 2.7*F3_137;
+	const double F3_141 = 2.7*F3_138;
+	const double F3_142 = 2.7*F3_139;
+	const double N3_143 = 0.03*wd3_125;
+	const double N3_144 = 0.01*wd3_126;
+	const double N3_145 = 0.029*wd3_127;
+	const double N3_146 = 0.03*w3_116;
+	const double N3_147 = 0.01*w3_117;
+	const double N3_148 = 0.029*w3_122;
+	const double N3_149 = w3_117*N3_148 - w3_122*N3_147;
+	const double N3_150 = w3_122*N3_146 - w3_116*N3_148;
+	const double N3_151 = w3_116*N3_147 - w3_117*N3_146;
+	const double N3_152 = N3_143 + N3_149;
+	const double N3_153 = N3_144 + N3_150;
+	const double N3_154 = N3_145 + N3_151;
+	//lbr_iiwa_joint_5
+	const double c4 = std::cos( q[4] ), s4 = std::sin( q[4] );
+	const double L4_155 = -c4;
+	const double a4_156 = -0.1845*wd3_127;
+	const double a4_157 = 0.1845*wd3_125;
+	const double a4_158 = -0.1845*w3_122;
+	const double a4_159 = 0.1845*w3_116;
+	const double a4_160 = w3_117*a4_159;
+	const double a4_161 = w3_122*a4_158 - w3_116*a4_159;
+	const double a4_162 = -w3_117*a4_158;
+	const double a4_163 = a3_113 + a4_156 + a4_160;
+	const double a4_164 = a3_114 + a4_161;
+	const double a4_165 = a3_115 + a4_157 + a4_162;
+	const double a4_166 = L4_155*a4_163 + s4*a4_165;
+	const double a4_167 = s4*a4_163 + c4*a4_165;
+	const double w4_168 = L4_155*w3_116 + s4*w3_122;
+	const double w4_169 = s4*w3_116 + c4*w3_122;
+	const double wd4_170 = L4_155*wd3_125 + s4*wd3_127;
+	const double wd4_171 = s4*wd3_125 + c4*wd3_127;
+	const double w4_172 = w3_117 + dq[4];
+	const double wd4_173 = w4_169*dq[4];
+	const double wd4_174 = -w4_168*dq[4];
+	const double wd4_175 = wd4_170 + wd4_173;
+	const double wd4_176 = wd4_171 + wd4_174;
+	const double wd4_177 = wd3_126 + qdd[4];
+	const double F4_178 = 0.076*wd4_176 - 0.021*wd4_177;
+	const double F4_179 = 0.0001*wd4_177 - 0.076*wd4_175;
+	const double F4_180 = 0.021*wd4_175 - 0.0001*wd4_176;
+	const double F4_181 = 0.076*w4_169 - 0.021*w4_172;
+	const double F4_182 = 0.0001*w4_172 - 0.076*w4_168;
+	const double F4_183 = 0.021*w4_168 - 0.0001*w4_169;
+	const double F4_184 = w4_169*F4_183 - w4_172*F4_182;
+	const double F4_185 = w4_172*F4_181 - w4_168*F4_183;
+	const double F4_186 = w4_168*F4_182 - w4_169*F4_181;
+	const double F4_187 = a4_166 + F4_178 + F4_184;
+	const double F4_188 = a4_167 + F4_179 + F4_185;
+	const double F4_189 = a4_164 + F4_180 + F4_186;
+	const double F4_190 = 1.7*F4_187;
+	const double F4_191 = 1.7*F4_188;
+	const double F4_192 = 1.7*F4_189;
+	const double N4_193 = 0.02*wd4_175;
+	const double N4_194 = 0.018*wd4_176;
+	const double N4_195 = 0.005*wd4_177;
+	const double N4_196 = 0.02*w4_168;
+	const double N4_197 = 0.018*w4_169;
+	const double N4_198 = 0.005*w4_172;
+	const double N4_199 = w4_169*N4_198 - w4_172*N4_197;
+	const double N4_200 = w4_172*N4_196 - w4_168*N4_198;
+	const double N4_201 = w4_168*N4_197 - w4_169*N4_196;
+	const double N4_202 = N4_193 + N4_199;
+	const double N4_203 = N4_194 + N4_200;
+	const double N4_204 = N4_195 + N4_201;
+	//lbr_iiwa_joint_6
+	const double c5 = std::cos( q[5] ), s5 = std::sin( q[5] );
+	const double L5_205 = -s5;
+	const double a5_206 = 0.2155*wd4_176;
+	const double a5_207 = -0.2155*wd4_175;
+	const double a5_208 = 0.2155*w4_169;
+	const double a5_209 = -0.2155*w4_168;
+	const double a5_210 = -w4_172*a5_209;
+	const double a5_211 = w4_172*a5_208;
+	const double a5_212 = w4_168*a5_209 - w4_169*a5_208;
+	const double a5_213 = a4_166 + a5_206 + a5_210;
+	const double a5_214 = a4_167 + a5_207 + a5_211;
+	const double a5_215 = a4_164 + a5_212;
+	const double a5_216 = c5*a5_213 + s5*a5_215;
+	const double a5_217 = L5_205*a5_213 + c5*a5_215;
+	const double a5_218 = -a5_214;
+	const double w5_219 = c5*w4_168 + s5*w4_172;
+	const double w5_220 = L5_205*w4_168 + c5*w4_172;
+	const double w5_221 = -w4_169;
+	const double wd5_222 = c5*wd4_175 + s5*wd4_177;
+	const double wd5_223 = L5_205*wd4_175 + c5*wd4_177;
+	const double wd5_224 = -wd4_176;
+	const double w5_225 = w5_221 + dq[5];
+	const double wd5_226 = w5_220*dq[5];
+	const double wd5_227 = -w5_219*dq[5];
+	const double wd5_228 = wd5_222 + wd5_226;
+	const double wd5_229 = wd5_223 + wd5_227;
+	const double wd5_230 = wd5_224 + qdd[5];
+	const double F5_231 = 0.0004*wd5_229 - 0.0006*wd5_230;
+	const double F5_232 = -0.0004*wd5_228;
+	const double F5_233 = 0.0006*wd5_228;
+	const double F5_234 = 0.0004*w5_220 - 0.0006*w5_225;
+	const double F5_235 = -0.0004*w5_219;
+	const double F5_236 = 0.0006*w5_219;
+	const double F5_237 = w5_220*F5_236 - w5_225*F5_235;
+	const double F5_238 = w5_225*F5_234 - w5_219*F5_236;
+	const double F5_239 = w5_219*F5_235 - w5_220*F5_234;
+	const double F5_240 = a5_216 + F5_231 + F5_237;
+	const double F5_241 = a5_217 + F5_232 + F5_238;
+	const double F5_242 = a5_218 + F5_233 + F5_239;
+	const double F5_243 = 1.8*F5_240;
+	const double F5_244 = 1.8*F5_241;
+	const double F5_245 = 1.8*F5_242;
+	const double N5_246 = 0.005*wd5_228;
+	const double N5_247 = 0.0036*wd5_229;
+	const double N5_248 = 0.0047*wd5_230;
+	const double N5_249 = 0.005*w5_219;
+	const double N5_250 = 0.0036*w5_220;
+	const double N5_251 = 0.0047*w5_225;
+	const double N5_252 = w5_220*N5_251 - w5_225*N5_250;
+	const double N5_253 = w5_225*N5_249 - w5_219*N5_251;
+	const double N5_254 = w5_219*N5_250 - w5_220*N5_249;
+	const double N5_255 = N5_246 + N5_252;
+	const double N5_256 = N5_247 + N5_253;
+	const double N5_257 = N5_248 + N5_254;
+	//lbr_iiwa_joint_7
+	const double c6 = std::cos( q[6] ), s6 = std::sin( q[6] );
+	const double L6_258 = -c6;
+	const double a6_259 = -0.081*wd5_230;
+	const double a6_260 = 0.081*wd5_228;
+	const double a6_261 = -0.081*w5_225;
+	const double a6_262 = 0.081*w5_219;
+	const double a6_263 = w5_220*a6_262;
+	const double a6_264 = w5_225*a6_261 - w5_219*a6_262;
+	const double a6_265 = -w5_220*a6_261;
+	const double a6_266 = a5_216 + a6_259 + a6_263;
+	const double a6_267 = a5_217 + a6_264;
+	const double a6_268 = a5_218 + a6_260 + a6_265;
+	const double a6_269 = L6_258*a6_266 + s6*a6_268;
+	const double a6_270 = s6*a6_266 + c6*a6_268;
+	const double w6_271 = L6_258*w5_219 + s6*w5_225;
+	const double w6_272 = s6*w5_219 + c6*w5_225;
+	const double wd6_273 = L6_258*wd5_228 + s6*wd5_230;
+	const double wd6_274 = s6*wd5_228 + c6*wd5_230;
+	const double w6_275 = w5_220 + dq[6];
+	const double wd6_276 = w6_272*dq[6];
+	const double wd6_277 = -w6_271*dq[6];
+	const double wd6_278 = wd6_273 + wd6_276;
+	const double wd6_279 = wd6_274 + wd6_277;
+	const double wd6_280 = wd5_229 + qdd[6];
+	const double F6_281 = 0.02*wd6_279;
+	const double F6_282 = -0.02*wd6_278;
+	const double F6_283 = 0.02*w6_272;
+	const double F6_284 = -0.02*w6_271;
+	const double F6_285 = -w6_275*F6_284;
+	const double F6_286 = w6_275*F6_283;
+	const double F6_287 = w6_271*F6_284 - w6_272*F6_283;
+	const double F6_288 = a6_269 + F6_281 + F6_285;
+	const double F6_289 = a6_270 + F6_282 + F6_286;
+	const double F6_290 = a6_267 + F6_287;
+	const double F6_291 = 0.3*F6_288;
+	const double F6_292 = 0.3*F6_289;
+	const double F6_293 = 0.3*F6_290;
+	const double N6_294 = 0.001*wd6_278;
+	const double N6_295 = 0.001*wd6_279;
+	const double N6_296 = 0.001*wd6_280;
+	const double N6_297 = 0.001*w6_271;
+	const double N6_298 = 0.001*w6_272;
+	const double N6_299 = 0.001*w6_275;
+	const double N6_300 = w6_272*N6_299 - w6_275*N6_298;
+	const double N6_301 = w6_275*N6_297 - w6_271*N6_299;
+	const double N6_302 = w6_271*N6_298 - w6_272*N6_297;
+	const double N6_303 = N6_294 + N6_300;
+	const double N6_304 = N6_295 + N6_301;
+	const double N6_305 = N6_296 + N6_302;
+	//lbr_iiwa_joint_7
+	const double n6_306 = -0.02*F6_292;
+	const double n6_307 = 0.02*F6_291;
+	const double n6_308 = N6_303 + n6_306;
+	const double n6_309 = N6_304 + n6_307;
+	tau[6] = N6_305;
+	//lbr_iiwa_joint_6
+	const double f5_310 = L6_258*F6_291 + s6*F6_292;
+	const double f5_311 = s6*F6_291 + c6*F6_292;
+	const double n5_312 = L6_258*n6_308 + s6*n6_309;
+	const double n5_313 = s6*n6_308 + c6*n6_309;
+	const double n5_314 = 0.081*f5_311;
+	const double n5_315 = -0.081*f5_310;
+	const double f5_316 = F5_243 + f5_310;
+	const double f5_317 = F5_244 + F6_293;
+	const double f5_318 = F5_245 + f5_311;
+	const double n5_319 = 0.0006*F5_245 - 0.0004*F5_244;
+	const double n5_320 = 0.0004*F5_243;
+	const double n5_321 = -0.0006*F5_243;
+	const double n5_322 = N5_255 + n5_312 + n5_319 + n5_314;
+	const double n5_323 = N5_256 + N6_305 + n5_320;
+	const double n5_324 = N5_257 + n5_313 + n5_321 + n5_315;
+	tau[5] = n5_324;
+	//lbr_iiwa_joint_5
+	const double f4_325 = c5*f5_316 + L5_205*f5_317;
+	const double f4_326 = -f5_318;
+	const double f4_327 = s5*f5_316 + c5*f5_317;
+	const double n4_328 = c5*n5_322 + L5_205*n5_323;
+	const double n4_329 = -n5_324;
+	const double n4_330 = s5*n5_322 + c5*n5_323;
+	const double n4_331 = -0.2155*f4_326;
+	const double n4_332 = 0.2155*f4_325;
+	const double f4_333 = F4_190 + f4_325;
+	const double f4_334 = F4_191 + f4_326;
+	const double f4_335 = F4_192 + f4_327;
+	const double n4_336 = 0.021*F4_192 - 0.076*F4_191;
+	const double n4_337 = 0.076*F4_190 - 0.0001*F4_192;
+	const double n4_338 = 0.0001*F4_191 - 0.021*F4_190;
+	const double n4_339 = N4_202 + n4_328 + n4_336 + n4_331;
+	const double n4_340 = N4_203 + n4_329 + n4_337 + n4_332;
+	const double n4_341 = N4_204 + n4_330 + n4_338;
+	tau[4] = n4_341;
+	//lbr_iiwa_joint_4
+	const double f3_342 = L4_155*f4_333 + s4*f4_334;
+	const double f3_343 = s4*f4_333 + c4*f4_334;
+	const double n3_344 = L4_155*n4_339 + s4*n4_340;
+	const double n3_345 = s4*n4_339 + c4*n4_340;
+	const double n3_346 = 0.1845*f3_343;
+	const double n3_347 = -0.1845*f3_342;
+	const double f3_348 = F3_140 + f3_342;
+	const double f3_349 = F3_141 + f4_335;
+	const double f3_350 = F3_142 + f3_343;
+	const double n3_351 = 0.067*F3_142 - 0.034*F3_141;
+	const double n3_352 = 0.034*F3_140;
+	const double n3_353 = -0.067*F3_140;
+	const double n3_354 = N3_152 + n3_344 + n3_351 + n3_346;
+	const double n3_355 = N3_153 + n4_341 + n3_352;
+	const double n3_356 = N3_154 + n3_345 + n3_353 + n3_347;
+	tau[3] = n3_356;
+	//lbr_iiwa_joint_3
+	const double f2_357 = c3*f3_348 + L3_102*f3_349;
+	const double f2_358 = -f3_350;
+	const double n2_360 = c3*n3_354 + L3_102*n3_355;
+	const double n2_361 = -n3_356;
+	const double n2_362 = s3*n3_354 + c3*n3_355;
+	const double n2_363 = -0.2155*f2_358;
+	const double n2_364 = 0.2155*f2_357;
+	const double f2_365 = F2_87 + f2_357;
+	const double f2_366 = F2_88 + f2_358;
+	const double n2_368 = 0.03*F2_89 - 0.13*F2_88;
+	const double n2_369 = 0.13*F2_87;
+	const double n2_370 = -0.03*F2_87;
+	const double n2_371 = N2_99 + n2_360 + n2_368 + n2_363;
+	const double n2_372 = N2_100 + n2_361 + n2_369 + n2_364;
+	const double n2_373 = N2_101 + n2_362 + n2_370;
+	tau[2] = n2_373;
+	//lbr_iiwa_joint_2
+	const double f1_374 = L2_52*f2_365 + s2*f2_366;
+	const double f1_375 = s2*f2_365 + c2*f2_366;
+	const double n1_376 = L2_52*n2_371 + s2*n2_372;
+	const double n1_377 = s2*n2_371 + c2*n2_372;
+	const double n1_378 = 0.2045*f1_375;
+	const double n1_379 = -0.2045*f1_374;
+	const double n1_383 = 0.059*F1_39 - 0.042*F1_38;
+	const double n1_384 = 0.042*F1_37 - 0.0003*F1_39;
+	const double n1_385 = 0.0003*F1_38 - 0.059*F1_37;
+	const double n1_386 = N1_49 + n1_376 + n1_383 + n1_378;
+	const double n1_387 = N1_50 + n2_373 + n1_384;
+	const double n1_388 = N1_51 + n1_377 + n1_385 + n1_379;
+	tau[1] = n1_388;
+	//lbr_iiwa_joint_1
+	const double n0_392 = s1*n1_386 + c1*n1_387;
+	const double n0_400 = 0.03*F0_9;
+	const double n0_403 = N0_12 + n0_392 + n0_400;
+	tau[0] = n0_403;
+}
+
+}
+}
+
+#endif
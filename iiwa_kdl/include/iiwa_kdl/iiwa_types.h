@@ -0,0 +1,34 @@
+#ifndef IIWA_KDL_IIWA_TYPES_H
+#define IIWA_KDL_IIWA_TYPES_H
+
+#include <Eigen/Core>
+
+namespace iiwa_kdl {
+
+//The lbr iiwa has 7 joints
+const unsigned int IIWA_NJ = 7;
+
+//Fixed size storage for the real-time loops: no heap allocation
+typedef Eigen::Matrix<double, IIWA_NJ, 1> Vector7d;
+typedef Eigen::Matrix<double, IIWA_NJ, IIWA_NJ> Matrix7d;
+typedef Eigen::Matrix<double, 6, IIWA_NJ> Jacobian7d;
+typedef Eigen::Matrix<double, 6, 1> Vector6d;
+typedef Eigen::Matrix<double, 6, 6> Matrix6d;
+
+}
+
+//Real-time section guards
+//	Debug builds define EIGEN_RUNTIME_NO_MALLOC (see CMakeLists.txt): any Eigen
+//	heap allocation between IIWA_RT_BEGIN and IIWA_RT_END fails with an assertion.
+//	The Eigen flag is process wide: an allocation of any other thread in the section
+//	asserts too. check = false disables the guard (e.g. nodelets sharing the manager),
+//	and only Eigen is checked: keep the section around the Eigen solvers
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+#define IIWA_RT_BEGIN( check ) if( check ) Eigen::internal::set_is_malloc_allowed(false)
+#define IIWA_RT_END( check ) if( check ) Eigen::internal::set_is_malloc_allowed(true)
+#else
+#define IIWA_RT_BEGIN( check )
+#define IIWA_RT_END( check )
+#endif
+
+#endif
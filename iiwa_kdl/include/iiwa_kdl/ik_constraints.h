@@ -0,0 +1,62 @@
+#ifndef IIWA_KDL_IK_CONSTRAINTS_H
+#define IIWA_KDL_IK_CONSTRAINTS_H
+
+#include <kdl/chain.hpp>
+#include <kdl/jntarray.hpp>
+#include <kdl/solveri.hpp>
+
+#include "iiwa_kdl/iiwa_types.h"
+#include "iiwa_kdl/capsule_model.h"
+#include "iiwa_kdl/chainiksolvervel_dls.h"
+
+namespace iiwa_kdl {
+
+//Joint limits and self collision of the iiwa for the redundancy of the ik
+//	As null space objective of ChainIkSolverVel_DLS the cost
+//		H(q) = w_l/2 sum( joint beyond the limit margin )^2 + w_c/2 sum( max( 0, d_act - d_k ) )^2
+//	pushes the solutions away from the limits and from the capsule pairs closer than d_act,
+//	without changing the task. check() validates the final solution
+class IkConstraints : public KDL::SolverI, public NullspaceObjective {
+	public:
+		static const int E_JOINT_LIMIT = -110;
+		static const int E_SELF_COLLISION = -111;
+
+		IkConstraints( const KDL::Chain &chain, const KDL::JntArray &q_min, const KDL::JntArray &q_max );
+
+		//False if the chain is not the capsule model of the iiwa: no collision terms
+		bool collisionModel() const { return _capsules.valid(); }
+
+		//Cost active within margin (rad) of the limits, weight of the joint error
+		void setLimitCost( double margin, double weight );
+		//Cost active below the clearance d_act (m), weight of the distance error
+		void setCollisionCost( double activation, double weight );
+		//Clearances below min_clearance (m) are collisions for check()
+		void setMinClearance( double min_clearance ) { _min_clearance = min_clearance; }
+
+		virtual void gradient( const Vector7d &q, Vector7d &grad );
+
+		//E_NOERROR, E_JOINT_LIMIT or E_SELF_COLLISION
+		int check( const Vector7d &q );
+
+		//Smallest clearance and its pair of links at the last gradient() or check()
+		double minClearance( unsigned int *link_a = 0, unsigned int *link_b = 0 ) const;
+
+		virtual const char* strError( const int error ) const;
+
+	private:
+		CapsuleModel _capsules;
+		Vector7d _q_min;
+		Vector7d _q_max;
+
+		double _limit_margin;
+		double _limit_weight;
+		double _collision_activation;
+		double _collision_weight;
+		double _min_clearance;
+
+		Vector7d _grad_k;
+};
+
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef IIWA_KDL_JERK_LIMITED_OTG_H
+#define IIWA_KDL_JERK_LIMITED_OTG_H
+
+#include "ros/ros.h"
+
+#include "iiwa_kdl/iiwa_types.h"
+
+namespace iiwa_kdl {
+
+//Online jerk limited trajectory generator in joint space
+//	From the current reference state (q, qd, qdd) of each joint to a target at rest in minimum
+//	time with |qd| <= max_velocity, |qdd| <= max_acceleration and |qddd| <= max_jerk.
+//	Each joint gets the time optimal profile of up to 7 constant jerk segments: reach the peak
+//	velocity (found by bisection, the limit when there is a cruise), then stop on the target.
+//	The joints are not synchronized: each one reaches the target in its own minimum time.
+//	A new target can be set at any time, the profiles restart from the current reference:
+//	q, qd and qdd stay continuous. No allocation, update() only evaluates the segments
+class JerkLimitedOtg {
+	public:
+		JerkLimitedOtg();
+
+		//Limits of each joint (> 0)
+		void setLimits( const double *max_velocity, const double *max_acceleration, const double *max_jerk );
+
+		//Reference state, e.g. the measured joints (qd and qdd can be null: at rest)
+		void reset( const double *q, const double *qd = 0, const double *qdd = 0 );
+		//New target at rest, from the current reference state
+		void setTarget( const double *q_target );
+
+		//Advance the reference by dt (s). False once all the joints are on the target
+		bool update( double dt );
+
+		const double *q() const { return _q; }
+		const double *qd() const { return _qd; }
+		const double *qdd() const { return _qdd; }
+		bool finished() const { return _time >= _duration; }
+		//Time of the current motion, from setTarget to the last joint on the target
+		double duration() const { return _duration; }
+
+	private:
+		enum { MAX_SEGMENTS = 7 };
+
+		//Constant jerk segments from the start state
+		struct Profile {
+			double p0, v0, a0;
+			double target;
+			double t[MAX_SEGMENTS];
+			double j[MAX_SEGMENTS];
+			int n;
+			double duration;
+		};
+
+		void plan( unsigned int i );
+		void sample( const Profile &pr, double t, double &p, double &v, double &a ) const;
+
+		double _v_max[IIWA_NJ];
+		double _a_max[IIWA_NJ];
+		double _j_max[IIWA_NJ];
+
+		Profile _profile[IIWA_NJ];
+		double _q[IIWA_NJ];
+		double _qd[IIWA_NJ];
+		double _qdd[IIWA_NJ];
+		double _time;
+		double _duration;
+};
+
+
+//Limits of the parameters otg/max_velocity, otg/max_acceleration and otg/max_jerk in nh:
+//	one value for all the joints or a list of 7. Defaults: iiwa 14 joint speeds, 2 rad/s^2, 10 rad/s^3
+void loadOtgLimits( const ros::NodeHandle &nh, JerkLimitedOtg &otg );
+
+}
+
+#endif
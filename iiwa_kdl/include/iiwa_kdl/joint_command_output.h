@@ -0,0 +1,105 @@
+#ifndef IIWA_KDL_JOINT_COMMAND_OUTPUT_H
+#define IIWA_KDL_JOINT_COMMAND_OUTPUT_H
+
+#include <string>
+#include <vector>
+
+#include "ros/ros.h"
+#include <std_msgs/Float64.h>
+#include <std_msgs/Float64MultiArray.h>
+
+#include "iiwa_kdl/message_pool.h"
+
+namespace iiwa_kdl {
+
+//Output stage of the joint commands
+//	PER_JOINT: one std_msgs::Float64 for each joint controller (JointPositionController, ...)
+//	GROUP: a single std_msgs::Float64MultiArray for a JointGroup*Controller,
+//		all the joints are applied in the same controller update
+//	zero_copy: the messages are published as shared pointers of a MessagePool, the
+//		subscribers in the same process (nodelet manager) get them without serialization
+template <unsigned int N>
+class JointCommandOutput {
+	public:
+		enum Mode { PER_JOINT, GROUP };
+
+		JointCommandOutput() : _mode(PER_JOINT), _zero_copy(false) {}
+
+		//mode: "joint" or "group"
+		bool init( ros::NodeHandle &nh, const std::string &mode,
+				const std::vector<std::string> &joint_topics, const std::string &group_topic, int queue_size, bool zero_copy = false ) {
+
+			_zero_copy = zero_copy;
+
+			if( mode == "group" ) {
+				_mode = GROUP;
+				_group_pub = nh.advertise< std_msgs::Float64MultiArray >( group_topic, queue_size );
+
+				//The message is allocated once and reused in every cycle
+				_group_msg.layout.dim.resize(1);
+				_group_msg.layout.dim[0].label = "joints";
+				_group_msg.layout.dim[0].size = N;
+				_group_msg.layout.dim[0].stride = N;
+				_group_msg.layout.data_offset = 0;
+				_group_msg.data.resize(N);
+				if( _zero_copy ) _group_pool.init( _group_msg );
+			}
+			else if( mode == "joint" ) {
+				_mode = PER_JOINT;
+				if( joint_topics.size() != N ) return false;
+				for(unsigned int i=0; i<N; i++) {
+					_joint_pub[i] = nh.advertise< std_msgs::Float64 >( joint_topics[i], queue_size );
+					if( _zero_copy ) _joint_pool[i].init( _joint_msg[i] );
+				}
+			}
+			else {
+				ROS_ERROR("Unknown command mode: %s (use joint or group)", mode.c_str());
+				return false;
+			}
+			return true;
+		}
+
+		//Send the command of all the joints
+		void publish( const double *cmd ) {
+			if( _zero_copy && _mode == GROUP ) {
+				const boost::shared_ptr< std_msgs::Float64MultiArray > &m = _group_pool.get();
+				for(unsigned int i=0; i<N; i++)
+					m->data[i] = cmd[i];
+				_group_pub.publish( m );
+			}
+			else if( _zero_copy ) {
+				for(unsigned int i=0; i<N; i++) {
+					const boost::shared_ptr< std_msgs::Float64 > &m = _joint_pool[i].get();
+					m->data = cmd[i];
+					_joint_pub[i].publish( m );
+				}
+			}
+			else if( _mode == GROUP ) {
+				for(unsigned int i=0; i<N; i++)
+					_group_msg.data[i] = cmd[i];
+				_group_pub.publish( _group_msg );
+			}
+			else {
+				for(unsigned int i=0; i<N; i++) {
+					_joint_msg[i].data = cmd[i];
+					_joint_pub[i].publish( _joint_msg[i] );
+				}
+			}
+		}
+
+		Mode mode() const { return _mode; }
+
+	private:
+		Mode _mode;
+		ros::Publisher _joint_pub[N];
+		std_msgs::Float64 _joint_msg[N];
+		ros::Publisher _group_pub;
+		std_msgs::Float64MultiArray _group_msg;
+		bool _zero_copy;
+		MessagePool< std_msgs::Float64 > _joint_pool[N];
+		MessagePool< std_msgs::Float64MultiArray > _group_pool;
+};
+
+}
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef IIWA_KDL_JOINT_LIMITS_H
+#define IIWA_KDL_JOINT_LIMITS_H
+
+#include <string>
+#include <vector>
+
+#include <kdl/chain.hpp>
+#include <kdl/jntarray.hpp>
+
+namespace iiwa_kdl {
+
+//Names of the movable joints of the chain, in chain order
+std::vector<std::string> chainJointNames( const KDL::Chain &chain );
+
+//Position limits of the chain joints, read from the URDF robot description
+//	Continuous joints get [-inf, inf]. Return false if a joint is missing in the model
+bool jointLimitsFromUrdf( const std::string &robot_description, const KDL::Chain &chain,
+		KDL::JntArray &q_min, KDL::JntArray &q_max );
+
+}
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef IIWA_KDL_JOINT_STATE_EVENT_H
+#define IIWA_KDL_JOINT_STATE_EVENT_H
+
+#include <errno.h>
+#include <semaphore.h>
+#include <stdint.h>
+#include <time.h>
+
+namespace iiwa_kdl {
+
+//Wake up of the control thread on the arrival of a new joint state
+//	The writer posts a semaphore: it never blocks and no notification is lost.
+//	Only one thread should wait on the event (the control loop), the other
+//	readers of the snapshot keep polling it
+class JointStateEvent {
+	public:
+		JointStateEvent() { sem_init( &_sem, 0, 0 ); }
+		~JointStateEvent() { sem_destroy( &_sem ); }
+
+		//Called by the joint_states callback after each write
+		void notify() { sem_post( &_sem ); }
+
+		//Wait until the snapshot reaches the given version (e.g. last + decimation)
+		//	Return false if the timeout (seconds) expires before
+		template <class Snapshot>
+		bool wait( const Snapshot &snapshot, uint64_t version, double timeout ) {
+
+			timespec ts;
+			clock_gettime( CLOCK_REALTIME, &ts );
+			const long long ns = ts.tv_nsec + (long long)( timeout*1e9 );
+			ts.tv_sec += ns / 1000000000LL;
+			ts.tv_nsec = ns % 1000000000LL;
+
+			while( snapshot.version() < version ) {
+				if( sem_timedwait( &_sem, &ts ) != 0 && errno == ETIMEDOUT )
+					return snapshot.version() >= version;
+			}
+			//Drop the pending notifications: they refer to samples already available
+			while( sem_trywait( &_sem ) == 0 );
+			return true;
+		}
+
+	private:
+		sem_t _sem;
+};
+
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef IIWA_KDL_JOINT_STATE_MAP_H
+#define IIWA_KDL_JOINT_STATE_MAP_H
+
+#include <string>
+#include <vector>
+
+#include "sensor_msgs/JointState.h"
+#include <kdl/chain.hpp>
+
+namespace iiwa_kdl {
+
+//Map between the joints of a sensor_msgs::JointState and the joints of a KDL::Chain
+//	The joint names are resolved only once, on the first message. After that the
+//	extraction is a plain copy of N doubles: no string compare and no heap allocation
+template <unsigned int N>
+class JointStateMap {
+	public:
+		JointStateMap() : _resolved(false), _msg_size(0) {}
+
+		//Store the names of the movable joints of the chain, in chain order
+		bool init( const KDL::Chain &chain ) {
+			_names.clear();
+			for(unsigned int s=0; s<chain.getNrOfSegments(); s++) {
+				const KDL::Joint &j = chain.getSegment(s).getJoint();
+				if( j.getType() != KDL::Joint::None )
+					_names.push_back( j.getName() );
+			}
+			_resolved = false;
+			return _names.size() == N;
+		}
+
+		//Copy position and velocity of the chain joints from the message
+		//	Return false if the message does not contain all the chain joints
+		bool extract( const sensor_msgs::JointState &js, double *q, double *dq ) {
+
+			if( !_resolved || js.position.size() != _msg_size ) {
+				if( !resolve( js ) ) return false;
+			}
+
+			//The velocity field is optional in the JointState message
+			const bool has_vel = js.velocity.size() == _msg_size;
+			for(unsigned int i=0; i<N; i++) {
+				q[i] = js.position[_idx[i]];
+				dq[i] = has_vel ? js.velocity[_idx[i]] : 0.0;
+			}
+			return true;
+		}
+
+		bool resolved() const { return _resolved; }
+		const std::vector<std::string> & names() const { return _names; }
+
+	private:
+		//Search the chain joint names in the message
+		bool resolve( const sensor_msgs::JointState &js ) {
+			_resolved = false;
+			if( _names.size() != N || js.name.size() != js.position.size() ) return false;
+
+			for(unsigned int i=0; i<N; i++) {
+				unsigned int k=0;
+				while( k < js.name.size() && js.name[k] != _names[i] ) k++;
+				if( k == js.name.size() ) return false;
+				_idx[i] = k;
+			}
+
+			_msg_size = js.position.size();
+			_resolved = true;
+			return true;
+		}
+
+		std::vector<std::string> _names;
+		unsigned int _idx[N];
+		bool _resolved;
+		size_t _msg_size;
+};
+
+}
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef IIWA_KDL_JOINT_STATE_SNAPSHOT_H
+#define IIWA_KDL_JOINT_STATE_SNAPSHOT_H
+
+#include <atomic>
+#include <stdint.h>
+
+#include <kdl/jntarray.hpp>
+
+#include "iiwa_kdl/iiwa_types.h"
+
+namespace iiwa_kdl {
+
+//Single-writer / multi-reader snapshot of the robot joint state (seqlock)
+//	The writer (the joint_states callback) never waits, the readers
+//	(fk thread, control loop) retry until they get a consistent copy of
+//	q, dq and stamp. No mutex is involved, so the ROS spinner is never
+//	blocked by the control threads and viceversa
+//	Payload words are relaxed atomics: on x86/ARM they compile to plain
+//	loads and stores, but keep the copy well defined for the compiler
+template <unsigned int N>
+class JointStateSnapshot {
+	public:
+		JointStateSnapshot() : _seq(0) {
+			for(unsigned int i=0; i<N; i++) {
+				_q[i].store(0.0, std::memory_order_relaxed);
+				_dq[i].store(0.0, std::memory_order_relaxed);
+			}
+			_stamp.store(0.0, std::memory_order_relaxed);
+		}
+
+		//Publish a new joint state. Only one thread is allowed to call this method
+		void write( const double *q, const double *dq, double stamp ) {
+			const uint64_t s = _seq.load(std::memory_order_relaxed);
+			//Odd sequence: write in progress
+			_seq.store(s + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			for(unsigned int i=0; i<N; i++) {
+				_q[i].store(q[i], std::memory_order_relaxed);
+				_dq[i].store(dq[i], std::memory_order_relaxed);
+			}
+			_stamp.store(stamp, std::memory_order_relaxed);
+
+			//Even sequence: data are consistent again
+			_seq.store(s + 2, std::memory_order_release);
+		}
+
+		//Copy a consistent joint state in the output arrays
+		//	Return the version of the copied sample (number of writes so far),
+		//	0 if no joint state has been received yet
+		uint64_t read( double *q, double *dq, double &stamp ) const {
+			uint64_t s0, s1;
+			do {
+				s0 = _seq.load(std::memory_order_acquire);
+				//Wait the end of the write
+				if( s0 & 1 ) continue;
+
+				for(unsigned int i=0; i<N; i++) {
+					q[i] = _q[i].load(std::memory_order_relaxed);
+					dq[i] = _dq[i].load(std::memory_order_relaxed);
+				}
+				stamp = _stamp.load(std::memory_order_relaxed);
+
+				std::atomic_thread_fence(std::memory_order_acquire);
+				s1 = _seq.load(std::memory_order_relaxed);
+			} while( (s0 & 1) || s0 != s1 );
+
+			return s0 >> 1;
+		}
+
+		//Same as above, using KDL data types. The arrays must be already sized to N
+		uint64_t read( KDL::JntArray &q, KDL::JntArray &dq, double &stamp ) const {
+			return read( q.data.data(), dq.data.data(), stamp );
+		}
+
+		uint64_t read( KDL::JntArray &q ) const {
+			double dq[N];
+			double stamp;
+			return read( q.data.data(), dq, stamp );
+		}
+
+		//Version of the last complete sample, without copying the data
+		uint64_t version() const {
+			return _seq.load(std::memory_order_acquire) >> 1;
+		}
+
+		//True after the first joint state has been written
+		bool ready() const {
+			return version() > 0;
+		}
+
+	private:
+		//Keep the sequence counter in its own cache line: readers spin on it
+		alignas(64) std::atomic<uint64_t> _seq;
+		alignas(64) std::atomic<double> _q[N];
+		std::atomic<double> _dq[N];
+		std::atomic<double> _stamp;
+};
+
+typedef JointStateSnapshot<IIWA_NJ> IiwaJointStateSnapshot;
+
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef IIWA_KDL_JOINT_TRAJECTORY_CACHE_H
+#define IIWA_KDL_JOINT_TRAJECTORY_CACHE_H
+
+#include <string>
+#include <vector>
+
+#include <kdl/jntarray.hpp>
+
+namespace iiwa_kdl {
+
+//Periodic joint space trajectory, tabulated on uniform knots
+//	Each joint is a periodic cubic spline: the table stores q and the second
+//	derivative at the knots, q(t), qd(t) and qdd(t) are evaluated in closed form.
+//	The table is built once (from the ik of a periodic cartesian path) or loaded
+//	from disk, then sample() only reads it: no allocations, no ik in the loop
+class JointTrajectoryCache {
+	public:
+		JointTrajectoryCache();
+
+		//knots[k] is the configuration at t = k*period/knots.size(), over one period
+		bool build( const std::vector<KDL::JntArray> &knots, double period );
+
+		//Evaluate the trajectory at time t (taken modulo the period)
+		//	qd and qdd can be null. The arrays must have joints() elements
+		void sample( double t, double *q, double *qd = 0, double *qdd = 0 ) const;
+
+		//Binary file: the signature (path parameters, seed...) is stored in the header
+		//	and load() fails if it differs from the expected one
+		bool save( const std::string &file, const std::vector<double> &signature ) const;
+		bool load( const std::string &file, const std::vector<double> &signature );
+
+		bool valid() const { return _n > 0; }
+		unsigned int joints() const { return _nj; }
+		size_t size() const { return _n; }
+		double period() const { return _period; }
+
+	private:
+		//Second derivatives of the periodic spline of each joint
+		bool solveSpline();
+
+		unsigned int _nj;
+		size_t _n;
+		double _period;
+		double _h;
+
+		//Knot-major storage: the nj values of a knot are contiguous
+		std::vector<double> _q;
+		std::vector<double> _m;
+};
+
+}
+
+#endif
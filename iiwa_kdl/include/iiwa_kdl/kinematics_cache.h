@@ -0,0 +1,65 @@
+#ifndef IIWA_KDL_KINEMATICS_CACHE_H
+#define IIWA_KDL_KINEMATICS_CACHE_H
+
+#include <vector>
+#include <stdint.h>
+
+#include <kdl/chain.hpp>
+#include <kdl/frames.hpp>
+#include <kdl/jacobian.hpp>
+#include <kdl/jntarray.hpp>
+#include <kdl/chainfksolverpos_recursive.hpp>
+#include <kdl/chainjnttojacsolver.hpp>
+
+#include "iiwa_kdl/iiwa_kernel.h"
+
+namespace iiwa_kdl {
+
+//Kinematics of the measured configuration: frames of all the segments, tip pose,
+//	and jacobian, computed once for each joint state sample (the manipulability on demand)
+//	update() is a no-op when the version of the joint state did not change.
+//	All the outputs are allocated in the constructor. Not thread safe: it belongs
+//	to the control thread
+//	BACKEND_FIXED computes frames and jacobian with the generated iiwa kernel, if it
+//	matches the chain (KDL solvers otherwise, see backend())
+class KinematicsCache {
+	public:
+		explicit KinematicsCache( const KDL::Chain &chain, KinematicsBackend backend = BACKEND_KDL );
+		~KinematicsCache();
+
+		//Return true if the kinematics has been recomputed
+		bool update( uint64_t version, const KDL::JntArray &q );
+
+		//Version of the joint state of the cached values, 0 before the first update
+		uint64_t version() const { return _version; }
+
+		//Pose of the tip of each segment, base frame
+		const std::vector<KDL::Frame> &frames() const { return _frames; }
+		const KDL::Frame &tip() const { return _frames.back(); }
+		//Base frame jacobian of the tip
+		const KDL::Jacobian &jacobian() const { return _J; }
+		//sqrt( det( J J^T ) ), computed at the first call after each update
+		double manipulability() const;
+
+		KinematicsBackend backend() const { return _kernel ? BACKEND_FIXED : BACKEND_KDL; }
+
+	private:
+		KinematicsCache( const KinematicsCache & );
+		KinematicsCache &operator=( const KinematicsCache & );
+
+		IiwaKernel *_kernel;
+		Jacobian7d _J7;
+
+		KDL::ChainFkSolverPos_recursive _fksolver;
+		KDL::ChainJntToJacSolver _jac_solver;
+
+		std::vector<KDL::Frame> _frames;
+		KDL::Jacobian _J;
+		mutable double _manip;
+		mutable bool _manip_valid;
+		uint64_t _version;
+};
+
+}
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef IIWA_KDL_KUKA_INVDYN_CTRL_H
+#define IIWA_KDL_KUKA_INVDYN_CTRL_H
+
+#include <atomic>
+#include <vector>
+
+#include "ros/ros.h"
+#include "boost/thread.hpp"
+#include "boost/scoped_ptr.hpp"
+#include "sensor_msgs/JointState.h"
+#include <std_msgs/Float64MultiArray.h>
+#include <dynamic_reconfigure/server.h>
+
+//Include KDL libraries
+#include <kdl/chainfksolverpos_recursive.hpp>
+#include "iiwa_kdl/joint_state_snapshot.h"
+#include "iiwa_kdl/joint_state_map.h"
+#include "iiwa_kdl/joint_state_event.h"
+#include "iiwa_kdl/joint_command_output.h"
+#include "iiwa_kdl/message_pool.h"
+#include "iiwa_kdl/cycle_stats.h"
+#include "iiwa_kdl/state_recorder.h"
+//Computed torque: single RNE pass or M/C/g from KDL::ChainDynParam
+#include "iiwa_kdl/computed_torque_solver.h"
+#include "iiwa_kdl/robot_model.h"
+#include "iiwa_kdl/shm_channel.h"
+#include "iiwa_kdl/jerk_limited_otg.h"
+#include "iiwa_kdl/operational_space_solver.h"
+#include "iiwa_kdl/trajectory_stream.h"
+#include "iiwa_kdl/start_signal.h"
+#include "iiwa_kdl/config_buffer.h"
+#include "iiwa_kdl/InvDynConfig.h"
+
+class KUKA_INVDYN {
+	public:
+		//nh: namespace of the topics and callback queue of the subscriptions, nh_priv: parameters
+		KUKA_INVDYN( const ros::NodeHandle &nh, const ros::NodeHandle &nh_priv );
+		//Call stop() first: it waits for the control loop
+		~KUKA_INVDYN();
+
+		//From the run method we will start all the threads needed to accomplish the task
+		//	start(), spin until the shutdown, stop()
+		void run();
+		//Start the control loop thread
+		void start();
+		//Wait the end of the control loop, then close the log and print the timing summary
+		void stop();
+		//Function to load the model from the URDF file (parameter server)
+		bool init_robot_model();
+		//Callback for the /joint_state message to retrieve the value of the joints
+		void joint_states_cb( const sensor_msgs::JointState::ConstPtr & );
+		//Main control loop function
+		void ctrl_loop();
+		//Newest state of the shared memory channel, waiting until its step is at least min_seq
+		bool shm_wait( uint64_t min_seq, double timeout, iiwa_kdl::ShmJointState &s );
+		//dynamic_reconfigure callback: new gains and rate for the control loop
+		void reconfigure_cb( iiwa_kdl::InvDynConfig &config, uint32_t level );
+
+
+	private:
+		//Runtime parameters of the control loop (cfg/InvDyn.cfg)
+		struct LoopConfig {
+			double kp[iiwa_kdl::IIWA_NJ];
+			double kd[iiwa_kdl::IIWA_NJ];
+			double rate;
+		};
+
+		ros::NodeHandle _nh;
+		ros::NodeHandle _nh_priv;
+		boost::thread _ctrl_loop_t;
+		//Cleared by stop(): the loop also ends without ros::shutdown (nodelet unload)
+		std::atomic<bool> _running;
+		//Eigen allocation check of the solvers (IIWA_RT_BEGIN), only in a standalone process: run()
+		bool _rt_alloc_check;
+		//zero_copy = true: commands and shm_command published as shared pointers
+		//	(no serialization for the nodelets of the same manager)
+		bool _zero_copy;
+		iiwa_kdl::MessagePool<std_msgs::Float64MultiArray> _shm_monitor_pool;
+		iiwa_kdl::RobotModel _model;
+
+		KDL::Chain _k_chain;
+	
+		ros::Subscriber _js_sub;
+		ros::Publisher _cartpose_pub;
+		KDL::JntArray *_initial_q;
+		//Reference of the motion from _initial_q to initial_position (empty: hold _initial_q)
+		std::vector<double> _initial_target;
+		iiwa_kdl::JerkLimitedOtg _otg;
+		//Lock-free joint state snapshot shared between callback and control loop
+		iiwa_kdl::IiwaJointStateSnapshot _js;
+		//Chain joint index of each joint in the joint_states message
+		iiwa_kdl::JointStateMap<iiwa_kdl::IIWA_NJ> _js_map;
+		//Wake up of the control loop on new joint states (trigger = event)
+		iiwa_kdl::JointStateEvent _js_event;
+		//trigger = rate: the control loop runs at a fixed rate (default)
+		//trigger = event: the control loop runs every ctrl_decimation joint state messages
+		bool _event_trigger;
+		int _decimation;
+		//Timing of the control loop, published on /diagnostics every 1/diag_rate s
+		enum { ST_DYN, ST_PUBLISH, ST_CYCLE, ST_PERIOD, ST_LATENCY };
+		iiwa_kdl::CycleStats *_stats;
+		//record_file: binary log of each cycle (state_log_to_csv converts it)
+		iiwa_kdl::StateRecorder _recorder;
+		//End effector pose of the measured joints (cartesian trajectory start and log),
+		//	computed in the control thread
+		KDL::ChainFkSolverPos_recursive *_fksolver;
+		bool _first_fk;
+		iiwa_kdl::JointCommandOutput<iiwa_kdl::IIWA_NJ> _cmd_out;
+		KDL::	Frame _p_out;
+		iiwa_kdl::ComputedTorqueSolver *_ct_solver;
+		//Streamed joint and cartesian trajectories (same topics of kuka_invkin_ctrl)
+		iiwa_kdl::TrajectoryStream *_traj_in;
+		//~start (std_srvs/Trigger): the trajectories are followed after it is called
+		iiwa_kdl::StartSignal _start;
+		//Operational space control of the cartesian setpoints
+		iiwa_kdl::OperationalSpaceSolver *_osc;
+		//Written by the reconfigure callback (spinner), read by the control loop without locks
+		//	Destroyed first: no callback on a controller being destroyed (nodelet unload)
+		boost::scoped_ptr< dynamic_reconfigure::Server<iiwa_kdl::InvDynConfig> > _reconf_srv;
+		iiwa_kdl::ConfigBuffer<LoopConfig> _loop_cfg;
+		//shm_channel: joint states and torques through the shared memory channel of the
+		//	simulator plugin, the loop runs every _shm_decimation simulation steps
+		//	(shm_rate over the physics step published by the plugin).
+		//	The torques are published on shm_command at shm_monitor_rate Hz, for monitoring
+		bool _use_shm;
+		iiwa_kdl::ShmChannel _shm;
+		int _shm_decimation;
+		int _shm_poll_us;
+		int _shm_monitor_decimation;
+		//Cycles between two zero commands of the ros_control effort controllers
+		int _shm_zero_decimation;
+		ros::Publisher _shm_monitor_pub;
+		std_msgs::Float64MultiArray _shm_monitor_msg;
+};
+
+#endif
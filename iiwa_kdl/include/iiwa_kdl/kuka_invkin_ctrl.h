@@ -0,0 +1,211 @@
+#ifndef IIWA_KDL_KUKA_INVKIN_CTRL_H
+#define IIWA_KDL_KUKA_INVKIN_CTRL_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "ros/ros.h"
+#include "boost/thread.hpp"
+#include "boost/scoped_ptr.hpp"
+#include "geometry_msgs/PoseStamped.h"
+#include "sensor_msgs/JointState.h"
+#include <std_msgs/Int32.h>
+#include <dynamic_reconfigure/server.h>
+
+//Include KDL libraries
+#include <kdl/chainfksolverpos_recursive.hpp>
+#include <kdl/chainiksolvervel_pinv.hpp>
+
+#include "iiwa_kdl/joint_state_snapshot.h"
+#include "iiwa_kdl/joint_state_map.h"
+#include "iiwa_kdl/joint_state_event.h"
+#include "iiwa_kdl/joint_command_output.h"
+#include "iiwa_kdl/message_pool.h"
+#include "iiwa_kdl/cycle_stats.h"
+#include "iiwa_kdl/state_recorder.h"
+#include "iiwa_kdl/kinematics_cache.h"
+#include "iiwa_kdl/chainiksolverpos_rt.h"
+#include "iiwa_kdl/chainiksolverpos_multiseed.h"
+#include "iiwa_kdl/ik_constraints.h"
+#include "iiwa_kdl/robot_model.h"
+#include "iiwa_kdl/joint_trajectory_cache.h"
+#include "iiwa_kdl/trajectory_stream.h"
+#include "iiwa_kdl/start_signal.h"
+#include "iiwa_kdl/jerk_limited_otg.h"
+#include "iiwa_kdl/config_buffer.h"
+#include "iiwa_kdl/InvKinConfig.h"
+
+class KUKA_INVKIN {
+	public:
+		//name: name of the arm (diagnostics), nh: namespace of the robot topics,
+		//	nh_cfg: parameters of the arm
+		KUKA_INVKIN( const std::string &name, const ros::NodeHandle &nh, const ros::NodeHandle &nh_cfg,
+				iiwa_kdl::RobotModelRegistry &models, iiwa_kdl::StartSignal &start );
+		//Call stop() first: it waits for the control loop
+		~KUKA_INVKIN();
+
+		//Arms of ~robots (nh_priv), or the single arm of the private parameters
+		//	nh: parent of the robot namespaces, its callback queue serves the topics of the arms
+		static void create_arms( const ros::NodeHandle &nh, const ros::NodeHandle &nh_priv,
+				iiwa_kdl::RobotModelRegistry &models, iiwa_kdl::StartSignal &start, std::vector<KUKA_INVKIN*> &arms );
+
+		//Start the control loop thread
+		void start();
+		//Wait the end of the control loop, then close the log and print the timing summary
+		void stop();
+		//Function to load the model from the URDF file (parameter server)
+		bool init_robot_model();
+		//Velocity ik solver selected by the parameters, one new instance for each call
+		KDL::ChainIkSolverVel *new_ik_vel_solver( const KDL::Chain &chain );
+		//Publish the pose of the end-effector computed by the kinematics cache
+		void publish_eef_pose( double stamp );
+		//Callback for the /joint_state message to retrieve the value of the joints
+		void joint_states_cb( const sensor_msgs::JointState::ConstPtr & );
+		//Joint space positioning to set an initial position, jerk limited
+		void goto_initial_position( const double dp[7] );
+		//Main control loop function
+		void ctrl_loop();
+		//Kinematics of a new joint state sample, then the pose output
+		void update_kinematics( uint64_t version, const KDL::JntArray &q, double stamp );
+		//Target of the end effector along the circle at time t, and its velocity
+		void circle_target( double t, KDL::Frame &F, KDL::Twist &V ) const;
+		//Joint trajectory of one period of the circle: load it or solve it offline
+		bool init_traj_cache();
+		//dynamic_reconfigure callback: new frequency and ik iterations for the control loop
+		void reconfigure_cb( iiwa_kdl::InvKinConfig &config, uint32_t level );
+		//Control thread: apply the newest configuration, true if it changed
+		bool update_config();
+		
+	private:
+		//Runtime parameters of the control loop (cfg/InvKin.cfg)
+		struct LoopConfig {
+			int freq;
+			int ik_max_iter;
+			double ik_eps;
+		};
+
+		std::string _name;
+		ros::NodeHandle _nh;
+		ros::NodeHandle _nh_cfg;
+		iiwa_kdl::RobotModelRegistry &_models;
+		iiwa_kdl::StartSignal &_start;
+		boost::thread _ctrl_loop_t;
+		//Cleared by stop(): the loop also ends without ros::shutdown (nodelet unload)
+		std::atomic<bool> _running;
+
+		//Robot model, shared with the other arms of the same URDF
+		boost::shared_ptr<const iiwa_kdl::RobotModel> _model;
+		//Kinematic chain (copy of the model one, referenced by the solvers of this arm)
+		KDL::Chain _k_chain;
+	
+		//Forward kinematics solver
+		KDL::ChainFkSolverPos_recursive *_fksolver; 	
+		//Implementation of a inverse velocity kinematics algorithm based on 
+		//the generalize pseudo inverse to calculate the velocity transformation 
+		//from Cartesian to joint space of a general KDL::Chain
+		//	ik_vel_solver = pinv: KDL::ChainIkSolverVel_pinv (SVD, default)
+		//	ik_vel_solver = dls: iiwa_kdl::ChainIkSolverVel_DLS (damped least squares)
+		KDL::ChainIkSolverVel *_ik_solver_vel;   	//Inverse velocity solver
+		
+		//Implementation of a general inverse position kinematics algorithm based on Newton-Raphson 
+		//iterations to calculate the position transformation from Cartesian 
+		//to joint space of a general KDL::Chain. 
+		//	The NR iteration of the rt solver with no deadline: ik_max_iter and ik_eps
+		//	of the reconfigure server apply between two cycles
+		iiwa_kdl::ChainIkSolverPos_RT *_ik_solver_pos;
+
+		//Warm started position ik, seeded with the previous solution
+		//	rt: real-time variant of the NR solver, bounded by a deadline on each call
+		//	srs: closed form solution of the spherical-revolute-spherical arm
+		//	multiseed: rt solvers in parallel from the current, previous and random seeds
+		KDL::ChainIkSolverPos *_ik_solver_ws;
+		//Same object of _ik_solver_ws in rt mode (iterations of the reconfigure server)
+		iiwa_kdl::ChainIkSolverPos_RT *_ik_solver_rt;
+		//Same object of _ik_solver_ws in multiseed mode: it also gets the measured joints
+		iiwa_kdl::ChainIkSolverPos_MultiSeed *_ik_solver_ms;
+		//ik_mode = nr: Newton-Raphson ik seeded with the current joints (default)
+		//ik_mode = rt: iiwa_kdl::ChainIkSolverPos_RT seeded with the previous solution
+		//ik_mode = srs: iiwa_kdl::ChainIkSolverPos_SRS, analytic ik with the NR solver as fallback
+		//ik_mode = multiseed: iiwa_kdl::ChainIkSolverPos_MultiSeed, ik_seeds parallel rt solvers
+		//	with the ik_deadline, the first converged one cancels the others
+		//ik_mode = clik: closed loop differential ik, one velocity ik solution for each cycle
+		std::string _ik_mode;
+		//Gain of the cartesian error feedback in clik mode (1/s)
+		double _clik_gain;
+		//trajectory = stream: setpoints of the trajectory and cartesian_trajectory topics (default)
+		//trajectory = circle: circle of radius 0.3 at z = 1.0, identity orientation
+		iiwa_kdl::TrajectoryStream *_traj_in;
+		//traj_cache = true: the loop interpolates the precomputed joint trajectory of the circle
+		//	The numeric ik runs only when the measured joints are farther than
+		//	traj_cache_divergence (rad) from the cached ones
+		bool _use_traj_cache;
+		double _traj_divergence;
+		boost::shared_ptr<const iiwa_kdl::JointTrajectoryCache> _traj_cache;
+		//ik_constraints = true: joint limits and self collision (capsule model) as null space
+		//	objective of the dls solver, the solutions that violate them are not commanded
+		iiwa_kdl::IkConstraints *_constraints;
+		//Constraints of the other velocity solvers (multiseed mode), solver objectives only
+		std::vector<iiwa_kdl::IkConstraints*> _seed_constraints;
+
+		ros::Subscriber _js_sub;
+		ros::Publisher _cartpose_pub;
+		ros::Publisher _ik_status_pub;
+		//Joint commands: per-joint topics or a single group message
+		iiwa_kdl::JointCommandOutput<iiwa_kdl::IIWA_NJ> _cmd_out;
+		//Reference of the motion to the initial position
+		iiwa_kdl::JerkLimitedOtg _otg;
+	
+		//Lock-free snapshot of the joint configuration
+		//	written by the joint_states callback, read by fk and control threads
+		iiwa_kdl::IiwaJointStateSnapshot _js;
+		//Chain joint index of each joint in the joint_states message
+		iiwa_kdl::JointStateMap<iiwa_kdl::IIWA_NJ> _js_map;
+		//Wake up of the control loop on new joint states (trigger = event)
+		iiwa_kdl::JointStateEvent _js_event;
+		//trigger = rate: the control loop runs at 4 times _freq (default)
+		//trigger = event: the control loop runs every ctrl_decimation joint state messages
+		bool _event_trigger;
+		int _decimation;
+		//Timing of the control loop, published on /diagnostics every 1/diag_rate s
+		enum { ST_IK, ST_PUBLISH, ST_CYCLE, ST_PERIOD, ST_LATENCY };
+		iiwa_kdl::CycleStats *_stats;
+		//record_file: binary log of each cycle (state_log_to_csv converts it)
+		iiwa_kdl::StateRecorder _recorder;
+		//Frames, tip pose and jacobian of the measured joints, once for each joint state
+		//	sample (control thread)
+		iiwa_kdl::KinematicsCache *_kin;
+		//End effector pose output, from the control thread:
+		//	at most eef_max_rate Hz, only when the pose moved more than
+		//	eef_min_translation (m) or eef_min_rotation (rad) from the last one published
+		geometry_msgs::PoseStamped _eef_msg;
+		//zero_copy = true: eef_pose, ik_status and the commands are published as shared pointers
+		//	(no serialization for the nodelets of the same manager)
+		bool _zero_copy;
+		iiwa_kdl::MessagePool<geometry_msgs::PoseStamped> _eef_pool;
+		iiwa_kdl::MessagePool<std_msgs::Int32> _ik_status_pool;
+		double _eef_min_period;
+		double _eef_min_translation;
+		double _eef_min_rotation;
+		double _eef_last_stamp;
+		//Variable to store the last published end effector pose
+		KDL::Frame _p_out;
+
+		//Control flags to check 
+		//that data have been received
+		bool _start_traj;
+
+		// Frequency and time variables 
+		int _freq;
+		double _t;
+
+		//Written by the reconfigure callback (spinner), read by the control loop without locks
+		//	Destroyed first: no callback on a controller being destroyed (nodelet unload)
+		boost::scoped_ptr< dynamic_reconfigure::Server<iiwa_kdl::InvKinConfig> > _reconf_srv;
+		iiwa_kdl::ConfigBuffer<LoopConfig> _loop_cfg;
+		uint64_t _loop_cfg_version;
+	
+
+};
+
+#endif
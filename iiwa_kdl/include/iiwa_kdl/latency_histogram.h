@@ -0,0 +1,90 @@
+#ifndef IIWA_KDL_LATENCY_HISTOGRAM_H
+#define IIWA_KDL_LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <stdint.h>
+
+namespace iiwa_kdl {
+
+//Log-linear histogram of durations in ns (HDR-style)
+//	Each power of two is split in 2^SUB_BITS buckets: the relative error of a
+//	percentile is below 1/2^SUB_BITS (6%), from 1 ns to 2^MAX_EXP ns (~18 min).
+//	Buckets are fixed size atomics: record() never allocates nor blocks and can be
+//	called from the real-time loop while another thread reads the histogram
+class LatencyHistogram {
+	public:
+		static const int SUB_BITS = 4;
+		static const int SUB = 1 << SUB_BITS;
+		static const int MAX_EXP = 40;
+		static const int BUCKETS = ( MAX_EXP - SUB_BITS + 2 ) * SUB;
+
+		LatencyHistogram() { reset(); }
+
+		void reset() {
+			for(int i=0; i<BUCKETS; i++) _counts[i].store(0, std::memory_order_relaxed);
+			_total.store(0, std::memory_order_relaxed);
+			_sum.store(0, std::memory_order_relaxed);
+			_max.store(0, std::memory_order_relaxed);
+		}
+
+		//Add a sample. Only one thread is allowed to record in the same histogram
+		void record( int64_t ns ) {
+			const uint64_t v = ns > 0 ? (uint64_t)ns : 0;
+			_counts[ index(v) ].fetch_add(1, std::memory_order_relaxed);
+			_total.fetch_add(1, std::memory_order_relaxed);
+			_sum.fetch_add(v, std::memory_order_relaxed);
+			if( v > _max.load(std::memory_order_relaxed) ) _max.store(v, std::memory_order_relaxed);
+		}
+
+		uint64_t count() const { return _total.load(std::memory_order_relaxed); }
+		uint64_t max() const { return _max.load(std::memory_order_relaxed); }
+		double mean() const {
+			const uint64_t n = count();
+			return n ? (double)_sum.load(std::memory_order_relaxed) / n : 0.0;
+		}
+
+		//Upper bound of the bucket containing the p-th percentile (p in [0, 1]), 0 if empty
+		uint64_t percentile( double p ) const {
+			const uint64_t n = count();
+			if( n == 0 ) return 0;
+			uint64_t rank = (uint64_t)( p * n + 0.5 );
+			if( rank < 1 ) rank = 1;
+			uint64_t acc = 0;
+			for(int i=0; i<BUCKETS; i++) {
+				acc += _counts[i].load(std::memory_order_relaxed);
+				if( acc >= rank ) {
+					//Overflow bucket: no upper bound
+					if( i == BUCKETS - 1 ) return max();
+					const uint64_t ub = upperBound(i);
+					//The largest sample is known exactly
+					return ub < max() ? ub : max();
+				}
+			}
+			return max();
+		}
+
+	private:
+		static int index( uint64_t v ) {
+			if( v < (uint64_t)SUB ) return (int)v;
+			int e = 63 - __builtin_clzll(v);
+			if( e > MAX_EXP ) return BUCKETS - 1;
+			const int shift = e - SUB_BITS;
+			return ( shift + 1 ) * SUB + (int)( ( v >> shift ) - SUB );
+		}
+
+		static uint64_t upperBound( int i ) {
+			if( i < SUB ) return i;
+			const int shift = i / SUB - 1;
+			const uint64_t sub = i % SUB;
+			return ( ( SUB + sub + 1 ) << shift ) - 1;
+		}
+
+		std::atomic<uint64_t> _counts[BUCKETS];
+		std::atomic<uint64_t> _total;
+		std::atomic<uint64_t> _sum;
+		std::atomic<uint64_t> _max;
+};
+
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef IIWA_KDL_MESSAGE_POOL_H
+#define IIWA_KDL_MESSAGE_POOL_H
+
+#include <boost/shared_ptr.hpp>
+
+namespace iiwa_kdl {
+
+//Messages published as boost::shared_ptr, for the subscribers of the same process (nodelets)
+//	roscpp hands the pointer itself to the intra-process subscribers: the message must not
+//	change after the publish. get() returns the next of N messages, reused only when no
+//	subscriber holds it anymore, else replaced by a new copy of the prototype. With consumers
+//	faster than N cycles nothing is allocated after init()
+template <typename M, unsigned int N = 4>
+class MessagePool {
+	public:
+		MessagePool() : _next( 0 ) {}
+
+		//proto: preallocated content (array sizes, layout) of every message
+		void init( const M &proto ) {
+			_proto = proto;
+			for(unsigned int i=0; i<N; i++) _msg[i].reset( new M( _proto ) );
+		}
+
+		//Message to fill and publish, in the state left by its previous use
+		const boost::shared_ptr<M> &get() {
+			boost::shared_ptr<M> &m = _msg[_next];
+			_next = ( _next + 1 ) % N;
+			//Only the pool references it: no other thread can take a new reference
+			if( !m || !m.unique() ) m.reset( new M( _proto ) );
+			return m;
+		}
+
+	private:
+		M _proto;
+		boost::shared_ptr<M> _msg[N];
+		unsigned int _next;
+};
+
+}
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef IIWA_KDL_MODEL_CACHE_H
+#define IIWA_KDL_MODEL_CACHE_H
+
+#include <string>
+#include <stdint.h>
+
+#include <kdl/chain.hpp>
+#include <kdl/jntarray.hpp>
+
+namespace iiwa_kdl {
+
+//Hash of the robot description and of the links of the chain (64 bit FNV-1a)
+uint64_t modelHash( const std::string &robot_description, const std::string &base_link, const std::string &tip_link );
+
+//Binary cache of the robot model: the chain (segments, joints, inertias) and the joint limits
+//	Loading it skips the URDF parsing of the kdl tree and of the limits at startup.
+//	The joints are stored as kdl_parser builds them: name, type, origin and axis
+bool saveModelCache( const std::string &file, uint64_t hash, const KDL::Chain &chain,
+		const KDL::JntArray &q_min, const KDL::JntArray &q_max );
+
+//Fails if the file does not exist or was saved with a different hash
+//	hash = 0 accepts any file (no robot description to check it against)
+bool loadModelCache( const std::string &file, uint64_t hash, KDL::Chain &chain,
+		KDL::JntArray &q_min, KDL::JntArray &q_max );
+
+}
+
+#endif
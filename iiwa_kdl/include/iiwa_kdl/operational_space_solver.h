@@ -0,0 +1,89 @@
+#ifndef IIWA_KDL_OPERATIONAL_SPACE_SOLVER_H
+#define IIWA_KDL_OPERATIONAL_SPACE_SOLVER_H
+
+#include <Eigen/Cholesky>
+
+#include "ros/ros.h"
+
+#include <kdl/chain.hpp>
+#include <kdl/frames.hpp>
+#include <kdl/jacobian.hpp>
+#include <kdl/jntarray.hpp>
+#include <kdl/jntspaceinertiamatrix.hpp>
+#include <kdl/chaindynparam.hpp>
+#include <kdl/chainfksolverpos_recursive.hpp>
+#include <kdl/chainjnttojacsolver.hpp>
+
+#include "iiwa_kdl/iiwa_types.h"
+
+namespace iiwa_kdl {
+
+//Operational space (task space impedance) control of the tip pose
+//	Task acceleration: a = A_des + Kd*(V_des - J*dq) + Kp*e, e = pose error (base frame)
+//	Lambda = (J M^-1 J^T)^-1, Jbar = M^-1 J^T Lambda (dynamically consistent inverse)
+//	Null space: a0 = Kp_null*(q_null - q) - Kd_null*dq, filtered by N^T = I - J^T Jbar^T
+//	tau = J^T Lambda (a - dJ*dq) + N^T M a0 + C*dq + g is returned as the joint acceleration
+//		qdd_ref = Jbar (a - dJ*dq) + (I - Jbar J) a0
+//	so that the ComputedTorqueSolver adds M, C and g with one pass (tau = M*qdd_ref + C*dq + g).
+//	M is factorized once for each cycle (LDLT): M^-1 J^T is a solve, M is never inverted.
+//	dJ*dq is the directional derivative of the jacobian along dq (one more jacobian).
+//	Fixed size storage: nothing is allocated by compute()
+class OperationalSpaceSolver {
+	public:
+		static const int E_NOT_IIWA = -100;
+
+		struct Gains {
+			Vector6d kp;		//Linear and angular stiffness (1/s^2)
+			Vector6d kd;		//Linear and angular damping (1/s)
+			Vector7d kp_null;	//Null space posture (1/s^2)
+			Vector7d kd_null;	//Null space damping (1/s)
+			double damping;		//Added to J M^-1 J^T close to singularities
+		};
+
+		OperationalSpaceSolver( const KDL::Chain &chain, const KDL::Vector &gravity );
+
+		void setGains( const Gains &gains ) { _gains = gains; }
+		const Gains &gains() const { return _gains; }
+
+		//Joint acceleration reference towards F_des, V_des, A_des and the posture q_null (7 values)
+		int compute( const KDL::JntArray &q, const KDL::JntArray &dq, const KDL::Frame &F_des,
+				const KDL::Twist &V_des, const KDL::Twist &A_des, const double *q_null, KDL::JntArray &qdd_ref );
+
+		//Tip pose and task space inertia of the last compute()
+		const KDL::Frame &pose() const { return _F; }
+		const Matrix6d &lambda() const { return _lambda; }
+
+	private:
+		OperationalSpaceSolver( const OperationalSpaceSolver & );
+		OperationalSpaceSolver &operator=( const OperationalSpaceSolver & );
+
+		unsigned int _nj;
+		Gains _gains;
+
+		KDL::ChainFkSolverPos_recursive _fksolver;
+		KDL::ChainJntToJacSolver _jac_solver;
+		KDL::ChainDynParam _dyn_param;
+
+		KDL::JntSpaceInertiaMatrix _M;
+		KDL::Jacobian _J_kdl;
+		KDL::JntArray _q_h;
+		KDL::Frame _F;
+
+		Eigen::LDLT<Matrix7d> _M_ldlt;
+		Eigen::LDLT<Matrix6d> _lambda_ldlt;
+		Jacobian7d _J;
+		Jacobian7d _J_h;
+		Eigen::Matrix<double, IIWA_NJ, 6> _MinvJt;
+		Eigen::Matrix<double, IIWA_NJ, 6> _Jbar;
+		Matrix6d _lambda;
+};
+
+
+//Gains of the parameters in nh: osc/kp_translation, osc/kp_rotation, osc/kp_null (one value
+//	or a list of 7), osc/damping. The damping gains are critical (2*sqrt(kp)) unless
+//	osc/kd_translation, osc/kd_rotation, osc/kd_null are given
+void loadOscGains( const ros::NodeHandle &nh, OperationalSpaceSolver::Gains &gains );
+
+}
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef IIWA_KDL_PARAM_UTILS_H
+#define IIWA_KDL_PARAM_UTILS_H
+
+#include <string>
+
+#include "ros/ros.h"
+
+#include "iiwa_kdl/iiwa_types.h"
+
+namespace iiwa_kdl {
+
+//Per joint parameter: one value for all the joints or a list of IIWA_NJ values
+//	values is unchanged (defaults) if the parameter is missing or has the wrong size
+bool loadJointParam( const ros::NodeHandle &nh, const std::string &name, double *values );
+
+}
+
+#endif
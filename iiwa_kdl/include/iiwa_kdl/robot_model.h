@@ -0,0 +1,74 @@
+#ifndef IIWA_KDL_ROBOT_MODEL_H
+#define IIWA_KDL_ROBOT_MODEL_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ros/ros.h"
+#include "boost/shared_ptr.hpp"
+#include "boost/thread/mutex.hpp"
+#include <kdl/tree.hpp>
+#include <kdl/chain.hpp>
+#include <kdl/jntarray.hpp>
+
+#include "iiwa_kdl/joint_trajectory_cache.h"
+
+namespace iiwa_kdl {
+
+//Links of the controlled chain
+const char * const IIWA_BASE_LINK = "lbr_iiwa_link_0";
+const char * const IIWA_TIP_LINK = "lbr_iiwa_link_7";
+
+//Parsed robot model: URDF, kdl tree, the base_link -> tip_link chain and its joint limits
+//	Immutable once loaded, shared by the arms with the same URDF.
+//	The tree is empty when the chain comes from the model cache
+struct RobotModel {
+	std::string robot_description;
+	std::string base_link;
+	std::string tip_link;
+	KDL::Tree tree;
+	KDL::Chain chain;
+	KDL::JntArray q_min;
+	KDL::JntArray q_max;
+};
+
+
+//Load the robot description (URDF) from the robot_description param (searched from
+//	the namespace of nh upwards), extract the base_link -> tip_link chain and the limits
+//	model_cache: file of the chain and the limits (see saveModelCache, "" to disable).
+//	It is used without parsing the URDF if its hash matches the description, rewritten
+//	otherwise. Without robot_description the cache is loaded as it is
+bool loadRobotModel( const ros::NodeHandle &nh, RobotModel &model, const std::string &model_cache = std::string(),
+		const std::string &base_link = IIWA_BASE_LINK, const std::string &tip_link = IIWA_TIP_LINK );
+
+
+//Models and precomputed tables shared by the arms controlled in the same process
+//	Arms with the same URDF and the same chain links get the same RobotModel: the
+//	description is parsed only once. The joint trajectory tables are shared by the
+//	arms of the same model with the same signature (see JointTrajectoryCache::save)
+class RobotModelRegistry {
+	public:
+		//Same search and model cache of loadRobotModel
+		//	Return a null pointer if the model cannot be loaded
+		boost::shared_ptr<const RobotModel> load( const ros::NodeHandle &nh, const std::string &model_cache = std::string(),
+				const std::string &base_link = IIWA_BASE_LINK, const std::string &tip_link = IIWA_TIP_LINK );
+
+		boost::shared_ptr<const JointTrajectoryCache> trajectory( const RobotModel *model, const std::vector<double> &signature );
+		void addTrajectory( const RobotModel *model, const std::vector<double> &signature,
+				const boost::shared_ptr<const JointTrajectoryCache> &table );
+
+		size_t size();
+
+	private:
+		typedef std::pair< const RobotModel *, std::vector<double> > TrajectoryKey;
+
+		boost::mutex _mutex;
+		//Key: URDF, base and tip links (cache file if there is no URDF)
+		std::map< std::string, boost::shared_ptr<const RobotModel> > _models;
+		std::map< TrajectoryKey, boost::shared_ptr<const JointTrajectoryCache> > _trajectories;
+};
+
+}
+
+#endif
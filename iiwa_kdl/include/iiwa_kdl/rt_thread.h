@@ -0,0 +1,54 @@
+#ifndef IIWA_KDL_RT_THREAD_H
+#define IIWA_KDL_RT_THREAD_H
+
+#include <string>
+
+#include "ros/ros.h"
+#include "boost/function.hpp"
+
+namespace iiwa_kdl {
+
+//Scheduling of a thread, loaded from the private parameters <prefix>/<name>/...
+//	policy: other (default), fifo or rr
+//	priority: 1-99 for fifo/rr
+//	cpu: core to pin the thread to, -1 to leave the affinity unchanged
+struct ThreadRtConfig {
+	ThreadRtConfig() : policy("other"), priority(0), cpu(-1), stack_prefault(0) {}
+
+	std::string name;
+	std::string policy;
+	int priority;
+	int cpu;
+	//Bytes of stack touched at the start of the thread (no page faults later)
+	int stack_prefault;
+};
+
+//Read the configuration of the thread <name> (e.g. rt/ctrl/policy)
+ThreadRtConfig loadThreadRtConfig( const ros::NodeHandle &nh, const std::string &name );
+
+//Apply policy, priority and affinity to the calling thread, prefault its stack
+//	Failures (e.g. missing CAP_SYS_NICE) are reported and the thread keeps the default scheduling
+bool configureCurrentThread( const ThreadRtConfig &cfg );
+
+//Lock the current and future memory of the process in RAM, if rt/mlockall is true
+bool lockProcessMemory( const ros::NodeHandle &nh );
+
+//Thread body: configure the new thread, then run the loop
+//	boost::thread t( iiwa_kdl::RtThreadFunction( cfg, boost::bind( &CLASS::loop, this ) ) );
+class RtThreadFunction {
+	public:
+		RtThreadFunction( const ThreadRtConfig &cfg, const boost::function<void()> &fn ) : _cfg( cfg ), _fn( fn ) {}
+
+		void operator()() {
+			configureCurrentThread( _cfg );
+			_fn();
+		}
+
+	private:
+		ThreadRtConfig _cfg;
+		boost::function<void()> _fn;
+};
+
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef IIWA_KDL_SHM_CHANNEL_H
+#define IIWA_KDL_SHM_CHANNEL_H
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+#include "iiwa_kdl/iiwa_types.h"
+#include "iiwa_kdl/spsc_ring.h"
+
+namespace iiwa_kdl {
+
+//The rings live in memory shared by two processes: the atomics must not need a lock
+static_assert( ATOMIC_LLONG_LOCK_FREE == 2, "The shared memory channel needs lock free 64 bit atomics" );
+
+//Joint state of the simulator: step counter, time (s), positions, velocities and efforts
+struct ShmJointState {
+	uint64_t seq;
+	double stamp;
+	double q[IIWA_NJ];
+	double dq[IIWA_NJ];
+	double effort[IIWA_NJ];
+};
+
+//Joint command of the controller, time (s) of the state it was computed from
+struct ShmJointCommand {
+	double stamp;
+	double cmd[IIWA_NJ];
+};
+
+
+//Shared memory channel between a controller and the simulator, bypassing TCPROS on the hot path
+//	A POSIX shared memory object (/dev/shm) with two rings: joint states from the simulator
+//	and joint commands from the controller. Either side can start first: the first one
+//	creates and initializes the object, the other one waits for it. Each ring has a single
+//	writer, so a channel connects one simulated arm to one controller
+class ShmChannel {
+	public:
+		enum Role { SIMULATOR, CONTROLLER };
+		static const unsigned int RING_SIZE = 64;
+
+		ShmChannel();
+		~ShmChannel();
+
+		//name: shared memory object, e.g. /lbr_iiwa_shm. False if it cannot be created or
+		//	mapped, or if the object of the other side is not initialized within timeout (s)
+		bool open( const std::string &name, Role role, double timeout = 5.0 );
+		void close();
+		bool isOpen() const { return _layout != 0; }
+
+		//Simulator side. setStep: physics step (s) in the channel header, once after open
+		void setStep( double step );
+		bool writeState( const ShmJointState &s );
+		bool readCommand( ShmJointCommand &c );
+
+		//Controller side. readState returns the newest state, the older ones are skipped
+		bool writeCommand( const ShmJointCommand &c );
+		bool readState( ShmJointState &s );
+		//Poll readState every poll_us microseconds, false after timeout (s)
+		bool waitState( ShmJointState &s, double timeout, int poll_us = 50 );
+		//Physics step (s) of the simulator, 0 until it is set. waitStep: false after timeout (s)
+		double step() const;
+		bool waitStep( double timeout );
+
+		//Records dropped because the reader is late: states for the simulator side, commands for the controller
+		uint64_t dropped() const;
+
+		//Remove the shared memory object (the mapped processes keep it until they close it)
+		static void unlink( const std::string &name );
+
+	private:
+		ShmChannel( const ShmChannel & );
+		ShmChannel &operator=( const ShmChannel & );
+
+		struct Layout;
+
+		Layout *_layout;
+		Role _role;
+};
+
+}
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef IIWA_KDL_SPSC_RING_H
+#define IIWA_KDL_SPSC_RING_H
+
+#include <stdint.h>
+#include <atomic>
+
+namespace iiwa_kdl {
+
+//Single producer single consumer ring of N fixed size records, lock free
+//	The producer writes the record in place and then publishes the head (release), the
+//	consumer reads it and then releases the slot by moving the tail. head and tail are
+//	free running counters on their own cache lines: no false sharing between the sides.
+//	Plain data only, usable in shared memory (no pointers, no constructor needed):
+//	reset() before the first use
+template<typename T, unsigned int N>
+class SpscRing {
+	static_assert( N > 0 && ( N & ( N - 1 ) ) == 0, "The ring size must be a power of 2" );
+
+	public:
+		//Empty ring: only when no side is using it
+		void reset() {
+			_head.store( 0, std::memory_order_relaxed );
+			_tail.store( 0, std::memory_order_relaxed );
+			_dropped.store( 0, std::memory_order_relaxed );
+		}
+
+		//Producer: false if the ring is full, the record is dropped
+		bool push( const T &r ) {
+			const uint64_t h = _head.load( std::memory_order_relaxed );
+			if( h - _tail.load( std::memory_order_acquire ) >= N ) {
+				_dropped.fetch_add( 1, std::memory_order_relaxed );
+				return false;
+			}
+			_rec[ h & ( N - 1 ) ] = r;
+			_head.store( h + 1, std::memory_order_release );
+			return true;
+		}
+
+		//Consumer: oldest record, false if the ring is empty
+		bool pop( T &r ) {
+			const uint64_t t = _tail.load( std::memory_order_relaxed );
+			if( t == _head.load( std::memory_order_acquire ) ) return false;
+			r = _rec[ t & ( N - 1 ) ];
+			_tail.store( t + 1, std::memory_order_release );
+			return true;
+		}
+
+		//Consumer: oldest record without removing it, 0 if the ring is empty
+		//	The record stays valid until drop()
+		const T *peek() const {
+			const uint64_t t = _tail.load( std::memory_order_relaxed );
+			if( t == _head.load( std::memory_order_acquire ) ) return 0;
+			return &_rec[ t & ( N - 1 ) ];
+		}
+
+		//Consumer: remove the oldest record (after peek)
+		void drop() {
+			const uint64_t t = _tail.load( std::memory_order_relaxed );
+			if( t != _head.load( std::memory_order_acquire ) )
+				_tail.store( t + 1, std::memory_order_release );
+		}
+
+		//Consumer: newest record, the older ones are discarded. False if the ring is empty
+		bool popLatest( T &r ) {
+			const uint64_t t = _tail.load( std::memory_order_relaxed );
+			const uint64_t h = _head.load( std::memory_order_acquire );
+			if( t == h ) return false;
+			r = _rec[ ( h - 1 ) & ( N - 1 ) ];
+			_tail.store( h, std::memory_order_release );
+			return true;
+		}
+
+		//Records in the ring: an upper bound for the producer, a lower bound for the consumer
+		uint64_t size() const { return _head.load( std::memory_order_acquire ) - _tail.load( std::memory_order_acquire ); }
+
+		//Records pushed since the creation and records dropped because the ring was full
+		uint64_t pushed() const { return _head.load( std::memory_order_relaxed ); }
+		uint64_t dropped() const { return _dropped.load( std::memory_order_relaxed ); }
+
+	private:
+		alignas(64) std::atomic<uint64_t> _head;
+		alignas(64) std::atomic<uint64_t> _tail;
+		alignas(64) std::atomic<uint64_t> _dropped;
+		alignas(64) T _rec[N];
+};
+
+}
+
+#endif
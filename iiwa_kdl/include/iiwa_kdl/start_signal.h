@@ -0,0 +1,37 @@
+#ifndef IIWA_KDL_START_SIGNAL_H
+#define IIWA_KDL_START_SIGNAL_H
+
+#include <atomic>
+
+#include "ros/ros.h"
+#include "boost/thread.hpp"
+#include <std_srvs/Trigger.h>
+
+namespace iiwa_kdl {
+
+//Start of the trajectory execution, shared by all the arms of a process
+//	The arms wait until the start service (std_srvs/Trigger) is called, then they all start
+//	together. autostart = true: no service, the arms start as soon as they wait
+class StartSignal {
+	public:
+		StartSignal();
+
+		//nh: namespace of the start service (e.g. ~start)
+		void init( ros::NodeHandle &nh, bool autostart );
+
+		//Block until the start, false if running is cleared before (stop of the arm)
+		bool wait( const std::atomic<bool> &running );
+		bool started() const { return _started; }
+
+	private:
+		bool start_cb( std_srvs::Trigger::Request &req, std_srvs::Trigger::Response &res );
+
+		ros::ServiceServer _srv;
+		boost::mutex _mutex;
+		boost::condition_variable _cond;
+		std::atomic<bool> _started;
+};
+
+}
+
+#endif
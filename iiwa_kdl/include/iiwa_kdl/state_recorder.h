@@ -0,0 +1,97 @@
+#ifndef IIWA_KDL_STATE_RECORDER_H
+#define IIWA_KDL_STATE_RECORDER_H
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <stdint.h>
+
+#include "boost/thread.hpp"
+
+#include <kdl/frames.hpp>
+
+#include "iiwa_kdl/iiwa_types.h"
+
+namespace iiwa_kdl {
+
+//One control cycle. Plain data with a fixed layout: it is copied as it is in the log file
+struct StateRecord {
+	//Stamp of the joint state and time of the command (s)
+	double stamp;
+	double t_cmd;
+	double q[IIWA_NJ];
+	double dq[IIWA_NJ];
+	//Commanded joint positions or torques (see StateLogHeader::command)
+	double cmd[IIWA_NJ];
+	//End effector pose: position and quaternion x, y, z, w
+	double eef_p[3];
+	double eef_quat[4];
+	int32_t status;
+	uint32_t pad;
+
+	void setPose( const KDL::Frame &f ) {
+		for(int k=0; k<3; k++) eef_p[k] = f.p.data[k];
+		f.M.GetQuaternion( eef_quat[0], eef_quat[1], eef_quat[2], eef_quat[3] );
+	}
+};
+
+
+//Header of the log file, followed by capacity records
+struct StateLogHeader {
+	enum Command { POSITION = 0, EFFORT = 1 };
+
+	char magic[8];
+	uint32_t record_size;
+	uint32_t nj;
+	uint64_t capacity;
+	uint32_t command;
+	uint32_t pad;
+	//Records written so far: the last min(count, capacity) are in the file
+	std::atomic<uint64_t> count;
+};
+
+static const char STATE_LOG_MAGIC[8] = { 'I', 'I', 'W', 'A', 'L', 'O', 'G', '1' };
+
+
+//Ring of fixed size records in a memory mapped file
+//	The file is created and prefaulted by open(): write() is a memcpy in the
+//	mapping plus the update of the counter, no system calls in the control loop.
+//	A background thread asks the kernel to write the dirty pages every flush_period s.
+//	Once full, the oldest records are overwritten. Only one thread can write
+class StateRecorder {
+	public:
+		StateRecorder();
+		~StateRecorder();
+
+		bool open( const std::string &file, uint64_t capacity, StateLogHeader::Command command, double flush_period = 1.0 );
+		void close();
+
+		bool isOpen() const { return _header != 0; }
+
+		void write( const StateRecord &rec ) {
+			const uint64_t n = _header->count.load(std::memory_order_relaxed);
+			memcpy( &_records[ n % _capacity ], &rec, sizeof(StateRecord) );
+			_header->count.store(n + 1, std::memory_order_release);
+		}
+
+	private:
+		StateRecorder( const StateRecorder & );
+		StateRecorder &operator=( const StateRecorder & );
+
+		void flush_loop();
+
+		int _fd;
+		void *_map;
+		size_t _map_size;
+		StateLogHeader *_header;
+		StateRecord *_records;
+		uint64_t _capacity;
+
+		double _flush_period;
+		boost::thread _flush_thread;
+		std::atomic<bool> _stop;
+};
+
+}
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef IIWA_KDL_TRAJECTORY_STREAM_H
+#define IIWA_KDL_TRAJECTORY_STREAM_H
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "ros/ros.h"
+#include "boost/thread.hpp"
+#include <trajectory_msgs/JointTrajectory.h>
+#include <trajectory_msgs/MultiDOFJointTrajectory.h>
+
+#include <kdl/frames.hpp>
+
+#include "iiwa_kdl/iiwa_types.h"
+#include "iiwa_kdl/spsc_ring.h"
+
+namespace iiwa_kdl {
+
+//Point of a streamed trajectory, time t (s, ROS time)
+//	JOINT: pos = q, vel = qd (chain order)
+//	CARTESIAN: pos = x y z qx qy qz qw of the end effector, vel = linear and angular velocity
+//	HOLD: stop at the current setpoint (empty batch)
+struct TrajectoryPoint {
+	enum Kind { JOINT, CARTESIAN, HOLD };
+	uint32_t gen;
+	uint32_t kind;
+	uint32_t has_vel;
+	double t;
+	double pos[IIWA_NJ];
+	double vel[IIWA_NJ];
+};
+
+
+//Streamed trajectory input of a controller: joint or cartesian points sent in batches by a planner
+//	trajectory (trajectory_msgs/JointTrajectory, joints by name) and cartesian_trajectory
+//	(trajectory_msgs/MultiDOFJointTrajectory, first transform) in the namespace of the arm.
+//	The time of a point is header.stamp (receive time if 0) + time_from_start.
+//	The callbacks push the points in a preallocated lock-free ring, the control loop moves
+//	them in a small window up to lookahead seconds ahead and interpolates it at its own time:
+//	cubic Hermite of the positions (and of the rotation vector of the orientation), with the
+//	velocities of the points or finite differences of the neighbours, computed when the
+//	successor of a point enters the window. A point without a successor when its segment
+//	starts gets zero velocity: the setpoint stops smoothly on underrun.
+//	A batch that starts after the last point of the same kind is appended, any other batch
+//	preempts the current one: the queued points are dropped and the setpoint moves from the
+//	current command to the first new point. An empty batch holds the current setpoint
+class TrajectoryStream {
+	public:
+		static const unsigned int CAPACITY = 1024;
+		static const unsigned int WINDOW = 16;
+		enum Mode { NONE, JOINT, CARTESIAN };
+
+		//Setpoint of the current cycle
+		//	JOINT: q, qd, qdd. CARTESIAN: F, V and A (linear and angular acceleration)
+		struct Setpoint {
+			Mode mode;
+			double q[IIWA_NJ];
+			double qd[IIWA_NJ];
+			double qdd[IIWA_NJ];
+			KDL::Frame F;
+			KDL::Twist V;
+			KDL::Twist A;
+		};
+
+		TrajectoryStream();
+
+		//joint_names: joints of the chain, in chain order. lookahead: horizon of the window (s)
+		void init( ros::NodeHandle &nh, const std::vector<std::string> &joint_names, double lookahead );
+
+		//Producer side (callbacks, serialized by a mutex)
+		//	Return false if the ring is full and some points are dropped
+		bool pushJoint( const trajectory_msgs::JointTrajectory &traj );
+		bool pushCartesian( const trajectory_msgs::MultiDOFJointTrajectory &traj );
+
+		//Consumer side (control loop): setpoint at time t
+		//	q_cmd: last joint command, F_cmd: current pose of the end effector, start of a new batch
+		//	No lock and no allocation. NONE until the first batch
+		Mode update( double t, const double *q_cmd, const KDL::Frame &F_cmd );
+		const Setpoint &setpoint() const { return _sp; }
+
+		//The setpoint is the last point of the stream (end of the batch or underrun)
+		bool holding() const { return _holding; }
+		//Points lost because the ring was full
+		uint64_t dropped() const { return _ring.dropped(); }
+
+	private:
+		TrajectoryStream( const TrajectoryStream & );
+		TrajectoryStream &operator=( const TrajectoryStream & );
+
+		struct Knot {
+			double t;
+			double pos[IIWA_NJ];
+			double vel[IIWA_NJ];
+			bool vel_fixed;
+		};
+
+		void joint_cb( const trajectory_msgs::JointTrajectory::ConstPtr &traj );
+		void cartesian_cb( const trajectory_msgs::MultiDOFJointTrajectory::ConstPtr &traj );
+
+		//Producer: batch of kind starting at t0, true if it preempts the current one (new gen)
+		//	push: false if the ring is full, no wait
+		bool begin_batch( uint32_t kind, double t0 );
+		bool push( const TrajectoryPoint &p );
+
+		//Consumer
+		void start_batch( const TrajectoryPoint &first, double t, const double *q_cmd, const KDL::Frame &F_cmd );
+		void append( const TrajectoryPoint &p );
+		void finite_difference( unsigned int k );
+		void sample( double t );
+
+		SpscRing<TrajectoryPoint, CAPACITY> _ring;
+		//Generation of the newest batch, published before the points of a preempting batch
+		std::atomic<uint32_t> _gen;
+		double _lookahead;
+		std::vector<std::string> _joint_names;
+		ros::Subscriber _joint_sub;
+		ros::Subscriber _cart_sub;
+
+		//Producer state
+		boost::mutex _push_mutex;
+		uint32_t _push_gen;
+		uint32_t _push_kind;
+		double _push_last_t;
+
+		//Consumer state
+		uint32_t _win_gen;
+		Mode _win_mode;
+		Knot _win[WINDOW];
+		unsigned int _n;
+		bool _holding;
+		Setpoint _sp;
+};
+
+}
+
+#endif
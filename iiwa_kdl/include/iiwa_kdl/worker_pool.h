@@ -0,0 +1,47 @@
+#ifndef IIWA_KDL_WORKER_POOL_H
+#define IIWA_KDL_WORKER_POOL_H
+
+#include <stdint.h>
+
+#include "boost/thread.hpp"
+#include "boost/function.hpp"
+
+namespace iiwa_kdl {
+
+//Fixed set of worker threads for fork-join jobs
+//	run() hands the same job to every worker (job( worker_index )) and returns when all
+//	of them are done: the job splits the work using the index. The threads are
+//	created once, so a job costs a wake up instead of a thread creation
+class WorkerPool {
+	public:
+		//n_workers <= 0: one worker for each hardware thread
+		explicit WorkerPool( int n_workers = 0 );
+		~WorkerPool();
+
+		int size() const { return _n; }
+
+		//Run job(0) ... job(size()-1) in parallel and wait for their end
+		//	Only one run() at a time
+		void run( const boost::function<void(int)> &job );
+
+	private:
+		WorkerPool( const WorkerPool & );
+		WorkerPool &operator=( const WorkerPool & );
+
+		void worker( int index );
+
+		int _n;
+		boost::thread_group _threads;
+		boost::mutex _mutex;
+		boost::condition_variable _start_cv;
+		boost::condition_variable _done_cv;
+		boost::function<void(int)> _job;
+		//Incremented for each job: the workers wait for a new generation
+		uint64_t _generation;
+		int _pending;
+		bool _quit;
+};
+
+}
+
+#endif
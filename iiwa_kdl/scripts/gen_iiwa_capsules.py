@@ -0,0 +1,182 @@
+#!/usr/bin/env python
+#Generate the capsule model of the iiwa links (include/iiwa_kdl/iiwa_capsules_gen.h)
+#	Each link_N.stl (vertices in the frame of lbr_iiwa_link_N) gets the smallest
+#	enclosing capsule found over a few candidate axes: the principal axes of the
+#	vertices and the axes of the link frame. For an axis the radius is the minimum
+#	enclosing circle of the vertices projected on the normal plane, the segment is
+#	the shortest one that keeps every vertex inside the capsule.
+#
+#	gen_iiwa_capsules.py lbr_iiwa_description/meshes include/iiwa_kdl/iiwa_capsules_gen.h
+
+import argparse
+import math
+import os
+import random
+import struct
+import sys
+
+
+def read_stl( path ):
+	#Vertices of a binary or ascii STL
+	with open( path, 'rb' ) as f:
+		data = f.read()
+	points = set()
+	if len( data ) >= 84:
+		n = struct.unpack( '<I', data[ 80:84 ] )[ 0 ]
+		if len( data ) == 84 + 50*n:
+			for t in range( n ):
+				v = struct.unpack( '<12f', data[ 84 + 50*t : 84 + 50*t + 48 ] )
+				points.update( ( v[ 3:6 ], v[ 6:9 ], v[ 9:12 ] ) )
+			return list( points )
+	for line in data.decode( 'ascii', 'replace' ).splitlines():
+		words = line.split()
+		if len( words ) == 4 and words[ 0 ] == 'vertex':
+			points.add( tuple( float( w ) for w in words[ 1: ] ) )
+	return list( points )
+
+
+def dot( a, b ): return sum( x*y for x, y in zip( a, b ) )
+def scale( a, s ): return tuple( x*s for x in a )
+def add( a, b ): return tuple( x + y for x, y in zip( a, b ) )
+def sub( a, b ): return tuple( x - y for x, y in zip( a, b ) )
+def cross( a, b ): return ( a[ 1 ]*b[ 2 ] - a[ 2 ]*b[ 1 ], a[ 2 ]*b[ 0 ] - a[ 0 ]*b[ 2 ], a[ 0 ]*b[ 1 ] - a[ 1 ]*b[ 0 ] )
+def unit( a ): return scale( a, 1.0/math.sqrt( dot( a, a ) ) )
+
+
+def principal_axes( points ):
+	#Eigenvectors of the covariance, power iteration with deflation
+	n = len( points )
+	c = scale( tuple( sum( p[ k ] for p in points ) for k in range( 3 ) ), 1.0/n )
+	C = [ [ sum( ( p[ i ] - c[ i ] )*( p[ j ] - c[ j ] ) for p in points )/n for j in range( 3 ) ] for i in range( 3 ) ]
+	axes = []
+	for k in range( 2 ):
+		v = ( 1.0, 0.7, 0.3 )
+		for it in range( 200 ):
+			for a in axes: v = sub( v, scale( a, dot( v, a ) ) )
+			v = unit( tuple( dot( C[ i ], v ) for i in range( 3 ) ) )
+		axes.append( v )
+	axes.append( unit( cross( axes[ 0 ], axes[ 1 ] ) ) )
+	return axes
+
+
+def circle2( a, b ):
+	c = ( 0.5*( a[ 0 ] + b[ 0 ] ), 0.5*( a[ 1 ] + b[ 1 ] ) )
+	return c, math.hypot( a[ 0 ] - c[ 0 ], a[ 1 ] - c[ 1 ] )
+
+
+def circle3( a, b, c ):
+	d = 2.0*( a[ 0 ]*( b[ 1 ] - c[ 1 ] ) + b[ 0 ]*( c[ 1 ] - a[ 1 ] ) + c[ 0 ]*( a[ 1 ] - b[ 1 ] ) )
+	if abs( d ) < 1e-18:
+		#Collinear: the circle of the farthest pair
+		return max( ( circle2( a, b ), circle2( a, c ), circle2( b, c ) ), key = lambda cr: cr[ 1 ] )
+	a2, b2, c2 = dot( a, a ), dot( b, b ), dot( c, c )
+	x = ( a2*( b[ 1 ] - c[ 1 ] ) + b2*( c[ 1 ] - a[ 1 ] ) + c2*( a[ 1 ] - b[ 1 ] ) )/d
+	y = ( a2*( c[ 0 ] - b[ 0 ] ) + b2*( a[ 0 ] - c[ 0 ] ) + c2*( b[ 0 ] - a[ 0 ] ) )/d
+	return ( x, y ), math.hypot( a[ 0 ] - x, a[ 1 ] - y )
+
+
+def enclosing_circle( points ):
+	#Welzl, iterative: expected linear time on shuffled points
+	points = list( points )
+	random.Random( 1 ).shuffle( points )
+	inside = lambda cr, p: math.hypot( p[ 0 ] - cr[ 0 ][ 0 ], p[ 1 ] - cr[ 0 ][ 1 ] ) <= cr[ 1 ]*( 1.0 + 1e-12 ) + 1e-12
+	cr = ( points[ 0 ], 0.0 )
+	for i in range( 1, len( points ) ):
+		if inside( cr, points[ i ] ): continue
+		cr = ( points[ i ], 0.0 )
+		for j in range( i ):
+			if inside( cr, points[ j ] ): continue
+			cr = circle2( points[ i ], points[ j ] )
+			for k in range( j ):
+				if not inside( cr, points[ k ] ): cr = circle3( points[ i ], points[ j ], points[ k ] )
+	return cr
+
+
+def capsule( points, axis ):
+	#Enclosing capsule of the points along axis: end points and radius
+	u = unit( axis )
+	v = unit( cross( u, ( 1.0, 0.0, 0.0 ) if abs( u[ 0 ] ) < 0.9 else ( 0.0, 1.0, 0.0 ) ) )
+	w = cross( u, v )
+	( cv, cw ), r = enclosing_circle( [ ( dot( p, v ), dot( p, w ) ) for p in points ] )
+	lo, hi = -float( 'inf' ), float( 'inf' )
+	for p in points:
+		t = dot( p, u )
+		d2 = ( dot( p, v ) - cv )**2 + ( dot( p, w ) - cw )**2
+		h = math.sqrt( max( r*r - d2, 0.0 ) )
+		#The segment must reach t - h and start before t + h
+		lo = max( lo, t - h )
+		hi = min( hi, t + h )
+	#lo > hi: the capsule needs a segment [hi, lo], else a sphere anywhere in [lo, hi]
+	t0, t1 = ( hi, lo ) if lo > hi else ( 0.5*( lo + hi ), 0.5*( lo + hi ) )
+	base = add( scale( v, cv ), scale( w, cw ) )
+	return add( base, scale( u, t0 ) ), add( base, scale( u, t1 ) ), r
+
+
+def volume( cap ):
+	p0, p1, r = cap
+	return math.pi*r*r*math.sqrt( dot( sub( p1, p0 ), sub( p1, p0 ) ) ) + 4.0/3.0*math.pi*r**3
+
+
+def fit( points ):
+	candidates = principal_axes( points ) + [ ( 1.0, 0.0, 0.0 ), ( 0.0, 1.0, 0.0 ), ( 0.0, 0.0, 1.0 ) ]
+	return min( ( capsule( points, a ) for a in candidates ), key = volume )
+
+
+def fmt( x ):
+	return repr( round( float( x ), 6 ) )
+
+
+def fmt_up( x ):
+	#Radius rounded up, covering the rounding of the end points too
+	return repr( math.ceil( ( float( x ) + 1e-6 )*1e6 )/1e6 )
+
+
+def generate( caps, prefix, padding ):
+	out = []
+	out.append( '//Generated by scripts/gen_iiwa_capsules.py from the lbr_iiwa_description meshes: do not edit' )
+	out.append( '//	Enclosing capsules of %s0 .. %s%d, radius padding %s m' % ( prefix, prefix, len( caps ) - 1, fmt( padding ) ) )
+	out.append( '#ifndef IIWA_KDL_IIWA_CAPSULES_GEN_H' )
+	out.append( '#define IIWA_KDL_IIWA_CAPSULES_GEN_H' )
+	out.append( '' )
+	out.append( 'namespace iiwa_kdl {' )
+	out.append( 'namespace iiwa_capsules_gen {' )
+	out.append( '' )
+	out.append( 'constexpr unsigned int NLINKS = %d;' % len( caps ) )
+	out.append( 'constexpr const char *LINK_PREFIX = "%s";' % prefix )
+	out.append( '//Segment end points in the frame of link i and radius (m)' )
+	for name, idx in ( ( 'P0', 0 ), ( 'P1', 1 ) ):
+		out.append( 'constexpr double %s[NLINKS][3] = {' % name )
+		for c in caps:
+			out.append( '\t{ %s },' % ', '.join( fmt( x ) for x in c[ idx ] ) )
+		out.append( '};' )
+	out.append( 'constexpr double RADIUS[NLINKS] = { %s };' % ', '.join( fmt_up( c[ 2 ] + padding ) for c in caps ) )
+	out.append( '' )
+	out.append( '}' )
+	out.append( '}' )
+	out.append( '' )
+	out.append( '#endif' )
+	return '\n'.join( out ) + '\n'
+
+
+if __name__ == '__main__':
+	parser = argparse.ArgumentParser( description = 'Generate the capsule model of the iiwa links from the STL meshes' )
+	parser.add_argument( 'meshes', help = 'Directory of link_0.stl .. link_7.stl' )
+	parser.add_argument( 'output' )
+	parser.add_argument( '--links', type = int, default = 8 )
+	parser.add_argument( '--prefix', default = 'lbr_iiwa_link_' )
+	parser.add_argument( '--padding', type = float, default = 0.0, help = 'Added to each radius (m)' )
+	args = parser.parse_args()
+
+	caps = []
+	for i in range( args.links ):
+		points = read_stl( os.path.join( args.meshes, 'link_%d.stl' % i ) )
+		caps.append( fit( points ) )
+		p0, p1, r = caps[ -1 ]
+		sys.stderr.write( 'link_%d: radius %.4f length %.4f\n' % ( i, r, math.sqrt( dot( sub( p1, p0 ), sub( p1, p0 ) ) ) ) )
+	text = generate( caps, args.prefix, args.padding )
+
+	#Keep the timestamp when nothing changed: no rebuild of the dependent files
+	if os.path.exists( args.output ) and open( args.output ).read() == text:
+		sys.exit( 0 )
+	with open( args.output, 'w' ) as out:
+		out.write( text )
@@ -0,0 +1,364 @@
+#!/usr/bin/env python
+#Generate the fixed structure kernels of the iiwa chain (include/iiwa_kdl/iiwa_kernel_gen.h)
+#	The joints between base_link and tip_link are read from an expanded URDF and
+#	fk and rnea are written as straight line code: one block for each joint, the
+#	constant terms (zeros, unit rotations, inertial parameters) are folded here and
+#	the values nobody reads (e.g. the base wrench of rnea) are dropped.
+#
+#	rosrun xacro xacro lbr_iiwa.urdf.xacro > lbr_iiwa.urdf
+#	gen_iiwa_kernel.py lbr_iiwa.urdf include/iiwa_kdl/iiwa_kernel_gen.h
+
+import argparse
+import math
+import os
+import re
+import sys
+import xml.etree.ElementTree as ET
+
+#Coefficients below this are zero, within this from +-1 are +-1
+EPS = 1e-12
+
+
+def vec( text, default ):
+	if text is None: return list( default )
+	return [ float( v ) for v in text.split() ]
+
+
+def rpy_matrix( r, p, y ):
+	#URDF: R = Rz(yaw) Ry(pitch) Rx(roll)
+	cr, sr = math.cos( r ), math.sin( r )
+	cp, sp = math.cos( p ), math.sin( p )
+	cy, sy = math.cos( y ), math.sin( y )
+	return [ [ cy*cp, cy*sp*sr - sy*cr, cy*sp*cr + sy*sr ],
+		[ sy*cp, sy*sp*sr + cy*cr, sy*sp*cr - cy*sr ],
+		[ -sp, cp*sr, cp*cr ] ]
+
+
+def snap( x ):
+	if abs( x ) < EPS: return 0.0
+	if abs( x - 1.0 ) < EPS: return 1.0
+	if abs( x + 1.0 ) < EPS: return -1.0
+	return x
+
+
+def origin( elem ):
+	if elem is None: return [ 0.0, 0.0, 0.0 ], [ 0.0, 0.0, 0.0 ]
+	return vec( elem.get( 'xyz' ), [ 0, 0, 0 ] ), vec( elem.get( 'rpy' ), [ 0, 0, 0 ] )
+
+
+def fmt( x ):
+	return repr( float( x ) )
+
+
+class Code( object ):
+	#Straight line code with constant folding
+	#	A value is None (exact zero), a float (constant) or the name of a variable
+
+	def __init__( self ):
+		self.lines = []
+		self.count = 0
+
+	def emit( self, line ):
+		self.lines.append( '\t' + line )
+
+	def var( self, prefix, terms, const = 0.0 ):
+		#terms: list of (coefficient, expression). Return the folded value
+		terms = [ ( snap( c ), e ) for c, e in terms if snap( c ) != 0.0 ]
+		const = snap( const )
+		if not terms:
+			return const if const != 0.0 else None
+		if len( terms ) == 1 and terms[0][0] == 1.0 and const == 0.0 and '*' not in terms[0][1]:
+			return terms[0][1]
+
+		out = ''
+		for c, e in terms:
+			if c == 1.0: t = ' + ' + e
+			elif c == -1.0: t = ' - ' + e
+			elif c < 0.0: t = ' - ' + fmt( -c ) + '*' + e
+			else: t = ' + ' + fmt( c ) + '*' + e
+			out += t
+		if const != 0.0:
+			out += ( ' - ' + fmt( -const ) ) if const < 0.0 else ( ' + ' + fmt( const ) )
+		out = out[3:] if out.startswith( ' + ' ) else '-' + out[3:]
+
+		self.count += 1
+		name = '%s_%d' % ( prefix, self.count )
+		self.emit( 'const double %s = %s;' % ( name, out ) )
+		return name
+
+	def prune( self ):
+		#Drop the values that are not read by a later line (no unused variables)
+		used = set()
+		kept = []
+		for line in reversed( self.lines ):
+			m = re.match( r'\s*const double (\w+) = (.*);$', line )
+			if m and m.group( 1 ) not in used: continue
+			used.update( re.findall( r'[A-Za-z_]\w*', m.group( 2 ) if m else line ) )
+			kept.append( line )
+		self.lines = kept[::-1]
+
+
+def product( a, b ):
+	#Terms of a*b, a and b values
+	if a is None or b is None: return []
+	if isinstance( a, float ) and isinstance( b, float ): return [ ( a*b, '1.0' ) ]
+	if isinstance( a, float ): return [ ( a, b ) ]
+	if isinstance( b, float ): return [ ( b, a ) ]
+	return [ ( 1.0, a + '*' + b ) ]
+
+
+def split_const( terms ):
+	#Move the constant products in the constant term
+	const = 0.0
+	out = []
+	for c, e in terms:
+		if e == '1.0': const += c
+		else: out.append( ( c, e ) )
+	return out, const
+
+
+def lin( code, prefix, terms ):
+	t, c = split_const( terms )
+	return code.var( prefix, t, c )
+
+
+def mat_vec( code, prefix, M, v, transpose = False ):
+	out = []
+	for i in range( 3 ):
+		terms = []
+		for k in range( 3 ):
+			terms += product( M[k][i] if transpose else M[i][k], v[k] )
+		out.append( lin( code, prefix, terms ) )
+	return out
+
+
+def cross( code, prefix, a, b ):
+	out = []
+	for i in range( 3 ):
+		j, k = ( i + 1 ) % 3, ( i + 2 ) % 3
+		terms = product( a[j], b[k] ) + [ ( -c, e ) for c, e in product( a[k], b[j] ) ]
+		out.append( lin( code, prefix, terms ) )
+	return out
+
+
+def add( code, prefix, *vs ):
+	out = []
+	for i in range( 3 ):
+		terms = []
+		for v in vs: terms += product( 1.0, v[i] )
+		out.append( lin( code, prefix, terms ) )
+	return out
+
+
+def const_vec( v ):
+	return [ snap( x ) if snap( x ) != 0.0 else None for x in v ]
+
+
+def const_mat( M ):
+	return [ const_vec( row ) for row in M ]
+
+
+def read_chain( urdf, base, tip ):
+	root = ET.parse( urdf ).getroot()
+	links = dict( ( l.get( 'name' ), l ) for l in root.findall( 'link' ) )
+	by_child = dict( ( j.find( 'child' ).get( 'link' ), j ) for j in root.findall( 'joint' ) )
+
+	joints = []
+	link = tip
+	while link != base:
+		if link not in by_child: sys.exit( 'No path from %s to %s' % ( base, tip ) )
+		j = by_child[link]
+		joints.append( j )
+		link = j.find( 'parent' ).get( 'link' )
+	joints.reverse()
+
+	chain = []
+	for j in joints:
+		if j.get( 'type' ) not in ( 'revolute', 'continuous' ):
+			sys.exit( 'Joint %s: only revolute joints are supported' % j.get( 'name' ) )
+		xyz, rpy = origin( j.find( 'origin' ) )
+		axis = vec( j.find( 'axis' ).get( 'xyz' ) if j.find( 'axis' ) is not None else None, [ 1, 0, 0 ] )
+		n = math.sqrt( sum( a*a for a in axis ) )
+		axis = [ snap( a/n ) for a in axis ]
+		if sorted( abs( a ) for a in axis ) != [ 0.0, 0.0, 1.0 ]:
+			sys.exit( 'Joint %s: the axis must be one of the axes of the joint frame' % j.get( 'name' ) )
+
+		#Inertial parameters in the link frame, inertia about the center of mass
+		m, cog, I = 0.0, [ 0.0, 0.0, 0.0 ], [ [ 0.0 ]*3 for k in range( 3 ) ]
+		inertial = links[ j.find( 'child' ).get( 'link' ) ].find( 'inertial' )
+		if inertial is not None:
+			m = float( inertial.find( 'mass' ).get( 'value' ) )
+			cog, irpy = origin( inertial.find( 'origin' ) )
+			it = inertial.find( 'inertia' )
+			g = lambda k: float( it.get( k, 0 ) )
+			Ii = [ [ g( 'ixx' ), g( 'ixy' ), g( 'ixz' ) ], [ g( 'ixy' ), g( 'iyy' ), g( 'iyz' ) ], [ g( 'ixz' ), g( 'iyz' ), g( 'izz' ) ] ]
+			Ri = rpy_matrix( *irpy )
+			I = [ [ sum( Ri[a][k]*Ii[k][l]*Ri[b][l] for k in range( 3 ) for l in range( 3 ) ) for b in range( 3 ) ] for a in range( 3 ) ]
+
+		chain.append( { 'name': j.get( 'name' ), 'R': rpy_matrix( *rpy ), 'p': xyz, 'axis': axis,
+			'mass': m, 'cog': cog, 'I': I } )
+	return chain
+
+
+def local_rotation( code, i, joint ):
+	#R0 * Rot(axis, q): each entry is a*c + b*s + d
+	k = [ abs( a ) for a in joint['axis'] ].index( 1.0 )
+	sgn = joint['axis'][k]
+	c, s = 'c%d' % i, 's%d' % i
+	code.emit( 'const double %s = std::cos( q[%d] ), %s = std::sin( q[%d] );' % ( c, i, s, i ) )
+
+	#Rot(e_k, sgn*q), entries as (cos, sin, const) coefficients
+	rot = [ [ ( 0.0, 0.0, 1.0 if a == b else 0.0 ) for b in range( 3 ) ] for a in range( 3 ) ]
+	a, b = ( k + 1 ) % 3, ( k + 2 ) % 3
+	rot[a][a] = ( 1.0, 0.0, 0.0 )
+	rot[b][b] = ( 1.0, 0.0, 0.0 )
+	rot[a][b] = ( 0.0, -sgn, 0.0 )
+	rot[b][a] = ( 0.0, sgn, 0.0 )
+
+	L = []
+	for r in range( 3 ):
+		row = []
+		for col in range( 3 ):
+			cc = sum( joint['R'][r][m]*rot[m][col][0] for m in range( 3 ) )
+			cs = sum( joint['R'][r][m]*rot[m][col][1] for m in range( 3 ) )
+			c1 = sum( joint['R'][r][m]*rot[m][col][2] for m in range( 3 ) )
+			row.append( code.var( 'L%d' % i, [ ( cc, c ), ( cs, s ) ], c1 ) )
+		L.append( row )
+	return L, k, sgn
+
+
+def generate( chain, base, tip, source ):
+	nj = len( chain )
+
+	#fk: frames of all the segments in the base frame
+	fk = Code()
+	R = [ [ 1.0 if a == b else None for b in range( 3 ) ] for a in range( 3 ) ]
+	p = [ None, None, None ]
+	locals_ = []
+	for i, joint in enumerate( chain ):
+		fk.emit( '//%s' % joint['name'] )
+		L, k, sgn = local_rotation( fk, i, joint )
+		locals_.append( ( L, k, sgn ) )
+		p = add( fk, 'p%d' % i, p, mat_vec( fk, 'p%d' % i, R, const_vec( joint['p'] ) ) )
+		R = [ [ lin( fk, 'R%d' % i, sum( [ product( R[a][m], L[m][b] ) for m in range( 3 ) ], [] ) )
+			for b in range( 3 ) ] for a in range( 3 ) ]
+		for a in range( 3 ):
+			for b in range( 3 ):
+				fk.emit( 'R[%d][%d] = %s;' % ( i, 3*a + b, value( R[a][b] ) ) )
+		for a in range( 3 ):
+			fk.emit( 'p[%d][%d] = %s;' % ( i, a, value( p[a] ) ) )
+
+	#rnea: Newton-Euler in the link frames, base acceleration -g
+	rn = Code()
+	w = [ None ]*3
+	wd = [ None ]*3
+	acc = [ 'ga[0]', 'ga[1]', 'ga[2]' ]
+	rn.emit( 'const double ga[3] = { -g[0], -g[1], -g[2] };' )
+	F, N, Ls = [], [], []
+	for i, joint in enumerate( chain ):
+		rn.emit( '//%s' % joint['name'] )
+		L, k, sgn = local_rotation( rn, i, joint )
+		Ls.append( L )
+		p0 = const_vec( joint['p'] )
+
+		#Acceleration of the origin of the frame, from the parent velocities
+		a_prev = add( rn, 'a%d' % i, acc, cross( rn, 'a%d' % i, wd, p0 ), cross( rn, 'a%d' % i, w, cross( rn, 'a%d' % i, w, p0 ) ) )
+		acc = mat_vec( rn, 'a%d' % i, L, a_prev, True )
+
+		wp = mat_vec( rn, 'w%d' % i, L, w, True )
+		wdp = mat_vec( rn, 'wd%d' % i, L, wd, True )
+		ez = [ None ]*3
+		ez[k] = 'dq[%d]' % i
+		ezd = [ None ]*3
+		ezd[k] = 'qdd[%d]' % i
+		w = [ lin( rn, 'w%d' % i, product( 1.0, wp[a] ) + product( sgn if a == k else 0.0, ez[a] ) ) for a in range( 3 ) ]
+		wxe = cross( rn, 'wd%d' % i, wp, [ lin( rn, 'wd%d' % i, product( sgn if a == k else 0.0, ez[a] ) ) for a in range( 3 ) ] )
+		wd = [ lin( rn, 'wd%d' % i, product( 1.0, wdp[a] ) + product( sgn if a == k else 0.0, ezd[a] ) + product( 1.0, wxe[a] ) )
+			for a in range( 3 ) ]
+
+		#Force and moment on the link, center of mass and inertia in the link frame
+		c = const_vec( joint['cog'] )
+		I = const_mat( joint['I'] )
+		acog = add( rn, 'F%d' % i, acc, cross( rn, 'F%d' % i, wd, c ), cross( rn, 'F%d' % i, w, cross( rn, 'F%d' % i, w, c ) ) )
+		F.append( [ lin( rn, 'F%d' % i, product( joint['mass'], acog[a] ) ) for a in range( 3 ) ] )
+		N.append( add( rn, 'N%d' % i, mat_vec( rn, 'N%d' % i, I, wd ), cross( rn, 'N%d' % i, w, mat_vec( rn, 'N%d' % i, I, w ) ) ) )
+
+	f = [ None ]*3
+	n = [ None ]*3
+	for i in reversed( range( nj ) ):
+		joint = chain[i]
+		rn.emit( '//%s' % joint['name'] )
+		c = const_vec( joint['cog'] )
+		if i + 1 < nj:
+			fc = mat_vec( rn, 'f%d' % i, Ls[i + 1], f )
+			nc = mat_vec( rn, 'n%d' % i, Ls[i + 1], n )
+			pc = cross( rn, 'n%d' % i, const_vec( chain[i + 1]['p'] ), fc )
+		else:
+			fc, nc, pc = [ None ]*3, [ None ]*3, [ None ]*3
+		f = add( rn, 'f%d' % i, F[i], fc )
+		n = add( rn, 'n%d' % i, N[i], nc, cross( rn, 'n%d' % i, c, F[i] ), pc )
+		k, sgn = locals_[i][1], locals_[i][2]
+		rn.emit( 'tau[%d] = %s;' % ( i, value( lin( rn, 'tau%d' % i, product( sgn, n[k] ) ) ) ) )
+
+	fk.prune()
+	rn.prune()
+
+	out = []
+	out.append( '//Generated by scripts/gen_iiwa_kernel.py from %s: do not edit' % source )
+	out.append( '//\tChain %s -> %s, %d revolute joints' % ( base, tip, nj ) )
+	out.append( '#ifndef IIWA_KDL_IIWA_KERNEL_GEN_H' )
+	out.append( '#define IIWA_KDL_IIWA_KERNEL_GEN_H' )
+	out.append( '' )
+	out.append( '#include <cmath>' )
+	out.append( '' )
+	out.append( 'namespace iiwa_kdl {' )
+	out.append( 'namespace iiwa_gen {' )
+	out.append( '' )
+	out.append( 'constexpr unsigned int NJ = %d;' % nj )
+	out.append( 'constexpr const char *BASE_LINK = "%s";' % base )
+	out.append( 'constexpr const char *TIP_LINK = "%s";' % tip )
+	out.append( '//Joint axis: axis AXIS[i] of the segment frame, direction AXIS_SIGN[i]' )
+	out.append( 'constexpr int AXIS[NJ] = { %s };' % ', '.join( str( l[1] ) for l in locals_ ) )
+	out.append( 'constexpr double AXIS_SIGN[NJ] = { %s };' % ', '.join( fmt( l[2] ) for l in locals_ ) )
+	out.append( '' )
+	out.append( '//Frames of the %d segments in the base frame: R[i] row major and p[i]' % nj )
+	out.append( 'inline void fk( const double *q, double (*R)[9], double (*p)[3] ) {' )
+	out += fk.lines
+	out.append( '}' )
+	out.append( '' )
+	out.append( '' )
+	out.append( '//Inverse dynamics: tau = M(q)*qdd + C(q,dq)*dq + g(q), gravity g in the base frame' )
+	out.append( 'inline void rnea( const double *q, const double *dq, const double *qdd, const double *g, double *tau ) {' )
+	out += rn.lines
+	out.append( '}' )
+	out.append( '' )
+	out.append( '}' )
+	out.append( '}' )
+	out.append( '' )
+	out.append( '#endif' )
+	return '\n'.join( out ) + '\n'
+
+
+def value( v ):
+	if v is None: return '0.0'
+	if isinstance( v, float ): return fmt( v )
+	return v
+
+
+if __name__ == '__main__':
+	parser = argparse.ArgumentParser( description = 'Generate the fixed iiwa kernels from a URDF' )
+	parser.add_argument( 'urdf' )
+	parser.add_argument( 'output' )
+	parser.add_argument( '--base', default = 'lbr_iiwa_link_0' )
+	parser.add_argument( '--tip', default = 'lbr_iiwa_link_7' )
+	parser.add_argument( '--source', default = None, help = 'Name of the model in the header comment' )
+	args = parser.parse_args()
+
+	chain = read_chain( args.urdf, args.base, args.tip )
+	text = generate( chain, args.base, args.tip, args.source or os.path.basename( args.urdf ) )
+
+	#Keep the timestamp when nothing changed: no rebuild of the dependent files
+	if os.path.exists( args.output ) and open( args.output ).read() == text:
+		sys.exit( 0 )
+	with open( args.output, 'w' ) as out:
+		out.write( text )
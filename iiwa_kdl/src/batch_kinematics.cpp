@@ -0,0 +1,190 @@
+#include "iiwa_kdl/batch_kinematics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "boost/bind.hpp"
+
+#include <kdl/chainfksolverpos_recursive.hpp>
+#include <kdl/chainiksolvervel_pinv.hpp>
+
+#include "iiwa_kdl/chainiksolverpos_rt.h"
+
+namespace iiwa_kdl {
+
+BatchKinematics::BatchKinematics( const KDL::Chain &chain, int threads ) :
+	_chain( chain ), _nj( chain.getNrOfJoints() ), _valid( true ), _pool( threads ) {
+
+	//Product of exponentials model: T(q) = exp(xi_1 q_1) ... exp(xi_n q_n) M
+	KDL::Frame T = KDL::Frame::Identity();
+	for(unsigned int s=0; s<_chain.getNrOfSegments(); s++) {
+		const KDL::Segment &seg = _chain.getSegment(s);
+		const KDL::Joint &joint = seg.getJoint();
+
+		const KDL::Joint::JointType type = joint.getType();
+		if( type != KDL::Joint::None ) {
+			const bool rot = type == KDL::Joint::RotAxis || type == KDL::Joint::RotX || type == KDL::Joint::RotY || type == KDL::Joint::RotZ;
+			const bool trans = type == KDL::Joint::TransAxis || type == KDL::Joint::TransX || type == KDL::Joint::TransY || type == KDL::Joint::TransZ;
+			if( !rot && !trans ) _valid = false;
+
+			KDL::Vector axis = T.M*joint.JointAxis();
+			axis.Normalize();
+			_w.push_back( axis );
+			_r.push_back( T*joint.JointOrigin() );
+			_prismatic.push_back( trans );
+		}
+		T = T*seg.pose( 0.0 );
+	}
+	_M = T;
+
+	if( _w.size() != _nj ) _valid = false;
+}
+
+
+BatchKinematics::~BatchKinematics() {
+}
+
+
+void BatchKinematics::chunk( int worker, size_t n, size_t &begin, size_t &end ) const {
+	const size_t workers = _pool.size();
+	begin = n*worker/workers;
+	end = n*( worker + 1 )/workers;
+}
+
+
+void BatchKinematics::fk( const JointBatch &q, PoseBatch &f ) {
+	if( f.size() != q.size() ) f.resize( q.size() );
+	_pool.run( boost::bind( &BatchKinematics::fk_job, this, _1, &q, &f ) );
+}
+
+
+void BatchKinematics::fk_job( int worker, const JointBatch *q, PoseBatch *f ) {
+	size_t begin, end;
+	chunk( worker, q->size(), begin, end );
+	for(size_t b=begin; b<end; b+=BLOCK)
+		fk_block( *q, b, std::min( (size_t)BLOCK, end - b ), *f );
+}
+
+
+//T = T * exp(xi q) for a block of samples
+//	Every statement is a loop over the samples of the block, on contiguous arrays:
+//	the compiler turns them in packed SIMD operations
+void BatchKinematics::fk_block( const JointBatch &q, size_t begin, size_t n, PoseBatch &f ) const {
+	//Rotation (row major) and position of the accumulated transform
+	double T[12][BLOCK];
+	//Joint transform
+	double E[12][BLOCK];
+	double c[BLOCK], s[BLOCK];
+
+	for(int k=0; k<12; k++)
+		for(size_t i=0; i<n; i++) T[k][i] = ( k == 0 || k == 4 || k == 8 ) ? 1.0 : 0.0;
+
+	for(unsigned int j=0; j<_nj; j++) {
+		const double *qj = q.q(j) + begin;
+		const double wx = _w[j].x(), wy = _w[j].y(), wz = _w[j].z();
+
+		if( _prismatic[j] ) {
+			for(int k=0; k<9; k++)
+				for(size_t i=0; i<n; i++) E[k][i] = ( k == 0 || k == 4 || k == 8 ) ? 1.0 : 0.0;
+			for(size_t i=0; i<n; i++) {
+				E[9][i] = wx*qj[i];
+				E[10][i] = wy*qj[i];
+				E[11][i] = wz*qj[i];
+			}
+		}
+		else {
+			const double rx = _r[j].x(), ry = _r[j].y(), rz = _r[j].z();
+			for(size_t i=0; i<n; i++) {
+				c[i] = cos( qj[i] );
+				s[i] = sin( qj[i] );
+			}
+			//Rodrigues: R = I + sin(q) [w] + (1 - cos(q)) [w]^2, p = (I - R) r
+			for(size_t i=0; i<n; i++) {
+				const double v = 1.0 - c[i];
+				E[0][i] = c[i] + wx*wx*v;
+				E[1][i] = wx*wy*v - wz*s[i];
+				E[2][i] = wx*wz*v + wy*s[i];
+				E[3][i] = wy*wx*v + wz*s[i];
+				E[4][i] = c[i] + wy*wy*v;
+				E[5][i] = wy*wz*v - wx*s[i];
+				E[6][i] = wz*wx*v - wy*s[i];
+				E[7][i] = wz*wy*v + wx*s[i];
+				E[8][i] = c[i] + wz*wz*v;
+				E[9][i] = rx - ( E[0][i]*rx + E[1][i]*ry + E[2][i]*rz );
+				E[10][i] = ry - ( E[3][i]*rx + E[4][i]*ry + E[5][i]*rz );
+				E[11][i] = rz - ( E[6][i]*rx + E[7][i]*ry + E[8][i]*rz );
+			}
+		}
+
+		//T = T * E
+		for(size_t i=0; i<n; i++) {
+			double R[9];
+			for(int a=0; a<3; a++)
+				for(int b=0; b<3; b++)
+					R[3*a + b] = T[3*a][i]*E[b][i] + T[3*a + 1][i]*E[3 + b][i] + T[3*a + 2][i]*E[6 + b][i];
+			for(int a=0; a<3; a++)
+				T[9 + a][i] += T[3*a][i]*E[9][i] + T[3*a + 1][i]*E[10][i] + T[3*a + 2][i]*E[11][i];
+			for(int k=0; k<9; k++) T[k][i] = R[k];
+		}
+	}
+
+	//Tip: F = T * M
+	const double *M = _M.M.data;
+	const double Mx = _M.p.x(), My = _M.p.y(), Mz = _M.p.z();
+	for(int a=0; a<3; a++) {
+		double *Fp = f.c( PoseBatch::P + a ) + begin;
+		for(size_t i=0; i<n; i++)
+			Fp[i] = T[3*a][i]*Mx + T[3*a + 1][i]*My + T[3*a + 2][i]*Mz + T[9 + a][i];
+		for(int b=0; b<3; b++) {
+			double *Fr = f.c( PoseBatch::R + 3*a + b ) + begin;
+			for(size_t i=0; i<n; i++)
+				Fr[i] = T[3*a][i]*M[b] + T[3*a + 1][i]*M[3 + b] + T[3*a + 2][i]*M[6 + b];
+		}
+	}
+}
+
+
+size_t BatchKinematics::ik( const PoseBatch &f, const KDL::JntArray &q_init, JointBatch &q, std::vector<int> *status,
+		unsigned int maxiter, double eps ) {
+
+	if( q.size() != f.size() || q.joints() != _nj ) q.resize( _nj, f.size() );
+	if( status ) status->assign( f.size(), 0 );
+
+	std::vector<size_t> solved( _pool.size(), 0 );
+	_pool.run( boost::bind( &BatchKinematics::ik_job, this, _1, &f, &q_init, &q, status, maxiter, eps, &solved[0] ) );
+
+	size_t total = 0;
+	for(size_t i=0; i<solved.size(); i++) total += solved[i];
+	return total;
+}
+
+
+void BatchKinematics::ik_job( int worker, const PoseBatch *f, const KDL::JntArray *q_init, JointBatch *q,
+		std::vector<int> *status, unsigned int maxiter, double eps, size_t *solved ) {
+
+	size_t begin, end;
+	chunk( worker, f->size(), begin, end );
+	if( begin == end ) return;
+
+	//KDL solvers keep internal state: one set for each worker
+	KDL::ChainFkSolverPos_recursive fksolver( _chain );
+	KDL::ChainIkSolverVel_pinv iksolver_vel( _chain );
+	ChainIkSolverPos_RT iksolver( _chain, fksolver, iksolver_vel, maxiter, eps );
+
+	KDL::JntArray q_seed( *q_init );
+	KDL::JntArray q_out( _nj );
+	KDL::Frame target;
+
+	for(size_t s=begin; s<end; s++) {
+		f->get( s, target );
+		const int ret = iksolver.CartToJnt( q_seed, target, q_out );
+		if( ret == KDL::SolverI::E_NOERROR ) solved[worker]++;
+		if( status ) (*status)[s] = ret;
+
+		q->set( s, q_out );
+		//The best iterate is the seed of the next waypoint, also when the tolerance is not reached
+		if( ret >= 0 ) q_seed = q_out;
+	}
+}
+
+}
@@ -0,0 +1,144 @@
+#include "iiwa_kdl/capsule_model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+namespace iiwa_kdl {
+
+//Closest points of n pairs of segments p1 + s*d1, p2 + t*d2 with s, t in [0, 1]
+//	Clamped alternation of the closed form solution (Ericson, Real-Time Collision
+//	Detection, 5.1.9): s of the infinite lines, t for s, s again for t. At the
+//	constrained minimum each parameter is optimal for the other, so the last step
+//	does not change an unclamped result and the loop has no branches
+static void segment_distances( const double (*seg)[IIWA_CAPSULE_PAIRS_PADDED], unsigned int n,
+		double *s_out, double *t_out, double *dist ) {
+
+	//Degenerate segments (spheres) and parallel pairs
+	const double tiny = 1e-12;
+	for(unsigned int k=0; k<n; k++) {
+		const double rx = seg[0][k] - seg[6][k], ry = seg[1][k] - seg[7][k], rz = seg[2][k] - seg[8][k];
+		const double d1x = seg[3][k], d1y = seg[4][k], d1z = seg[5][k];
+		const double d2x = seg[9][k], d2y = seg[10][k], d2z = seg[11][k];
+
+		const double a = d1x*d1x + d1y*d1y + d1z*d1z + tiny;
+		const double e = d2x*d2x + d2y*d2y + d2z*d2z + tiny;
+		const double b = d1x*d2x + d1y*d2y + d1z*d2z;
+		const double c = d1x*rx + d1y*ry + d1z*rz;
+		const double f = d2x*rx + d2y*ry + d2z*rz;
+		const double denom = std::max( a*e - b*b, tiny );
+
+		double s = std::min( std::max( ( b*f - c*e )/denom, 0.0 ), 1.0 );
+		const double t = std::min( std::max( ( b*s + f )/e, 0.0 ), 1.0 );
+		s = std::min( std::max( ( b*t - c )/a, 0.0 ), 1.0 );
+
+		const double dx = rx + s*d1x - t*d2x, dy = ry + s*d1y - t*d2y, dz = rz + s*d1z - t*d2z;
+		s_out[k] = s;
+		t_out[k] = t;
+		dist[k] = std::sqrt( dx*dx + dy*dy + dz*dz );
+	}
+}
+
+
+static bool ends_with( const std::string &s, const std::string &suffix ) {
+	return s.size() >= suffix.size() && s.compare( s.size() - suffix.size(), suffix.size(), suffix ) == 0;
+}
+
+
+CapsuleModel::CapsuleModel( const KDL::Chain &chain ) : _chain( chain ) {
+
+	_valid = chain.getNrOfJoints() == IIWA_NJ && chain.getNrOfSegments() == IIWA_NJ;
+	for(unsigned int i=0; _valid && i<IIWA_NJ; i++)
+		_valid = ends_with( chain.getSegment(i).getName(), "link_" + std::to_string( i + 1 ) );
+
+	for(unsigned int i=0; i<IIWA_NLINKS; i++) {
+		_p0[i] = KDL::Vector( iiwa_capsules_gen::P0[i][0], iiwa_capsules_gen::P0[i][1], iiwa_capsules_gen::P0[i][2] );
+		_p1[i] = KDL::Vector( iiwa_capsules_gen::P1[i][0], iiwa_capsules_gen::P1[i][1], iiwa_capsules_gen::P1[i][2] );
+		_radius[i] = iiwa_capsules_gen::RADIUS[i];
+	}
+
+	unsigned int k = 0;
+	for(unsigned int a=0; a<IIWA_NLINKS; a++)
+		for(unsigned int b=a+2; b<IIWA_NLINKS; b++) {
+			if( a == 5 && b == 7 ) continue;
+			_pair_a[k] = a;
+			_pair_b[k] = b;
+			k++;
+		}
+
+	memset( _seg, 0, sizeof(_seg) );
+	memset( _s, 0, sizeof(_s) );
+	memset( _t, 0, sizeof(_t) );
+	memset( _dist, 0, sizeof(_dist) );
+	for(unsigned int p=0; p<IIWA_CAPSULE_PAIRS; p++) _clearance[p] = 0.0;
+	for(unsigned int j=0; j<IIWA_NJ; j++) {
+		_axis[j] = KDL::Vector::Zero();
+		_origin[j] = KDL::Vector::Zero();
+	}
+}
+
+
+void CapsuleModel::update( const Vector7d &q ) {
+	if( !_valid ) return;
+
+	//Capsule end points in the base frame, link 0 is the base
+	KDL::Vector p0[IIWA_NLINKS], d[IIWA_NLINKS];
+	KDL::Frame F = KDL::Frame::Identity();
+	p0[0] = _p0[0];
+	d[0] = _p1[0] - _p0[0];
+	for(unsigned int i=0; i<IIWA_NJ; i++) {
+		const KDL::Segment &seg = _chain.getSegment(i);
+		//Joint axis and origin are in the frame of the previous link
+		_axis[i] = F.M * seg.getJoint().JointAxis();
+		_origin[i] = F * seg.getJoint().JointOrigin();
+		F = F * seg.pose( q(i) );
+		p0[i + 1] = F * _p0[i + 1];
+		d[i + 1] = F.M * ( _p1[i + 1] - _p0[i + 1] );
+	}
+
+	for(unsigned int k=0; k<IIWA_CAPSULE_PAIRS; k++) {
+		const unsigned int a = _pair_a[k], b = _pair_b[k];
+		for(int c=0; c<3; c++) {
+			_seg[c][k] = p0[a](c);
+			_seg[3 + c][k] = d[a](c);
+			_seg[6 + c][k] = p0[b](c);
+			_seg[9 + c][k] = d[b](c);
+		}
+	}
+
+	segment_distances( _seg, IIWA_CAPSULE_PAIRS_PADDED, _s, _t, _dist );
+
+	for(unsigned int k=0; k<IIWA_CAPSULE_PAIRS; k++)
+		_clearance[k] = _dist[k] - _radius[ _pair_a[k] ] - _radius[ _pair_b[k] ];
+}
+
+
+double CapsuleModel::minClearance( unsigned int *pair ) const {
+	unsigned int best = 0;
+	for(unsigned int k=1; k<IIWA_CAPSULE_PAIRS; k++)
+		if( _clearance[k] < _clearance[best] ) best = k;
+	if( pair ) *pair = best;
+	return _clearance[best];
+}
+
+
+void CapsuleModel::clearanceGradient( unsigned int k, Vector7d &grad ) const {
+	grad.setZero();
+
+	//Closest points c_a, c_b and the direction n of the distance
+	KDL::Vector ca, cb;
+	for(int c=0; c<3; c++) {
+		ca(c) = _seg[c][k] + _s[k]*_seg[3 + c][k];
+		cb(c) = _seg[6 + c][k] + _t[k]*_seg[9 + c][k];
+	}
+	if( _dist[k] < 1e-9 ) return;
+	const KDL::Vector n = ( ca - cb ) / _dist[k];
+
+	//The joints before link a move both points rigidly: no change of the distance.
+	//	Joint j between the links moves c_b by z_j x ( c_b - o_j ): dd/dq_j = -n . ( z_j x ( c_b - o_j ) )
+	for(unsigned int j=_pair_a[k]; j<_pair_b[k]; j++)
+		grad(j) = -KDL::dot( n, _axis[j] * ( cb - _origin[j] ) );
+}
+
+}
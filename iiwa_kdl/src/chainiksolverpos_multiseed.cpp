@@ -0,0 +1,129 @@
+#include "iiwa_kdl/chainiksolverpos_multiseed.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "boost/bind.hpp"
+
+namespace iiwa_kdl {
+
+ChainIkSolverPos_MultiSeed::ChainIkSolverPos_MultiSeed( const KDL::Chain &chain, const KDL::JntArray &q_min, const KDL::JntArray &q_max,
+		const VelSolverFactory &vel_factory, unsigned int seeds, unsigned int maxiter, double eps, double deadline, unsigned int random_seed ) :
+	_chain( chain ),
+	_nj( chain.getNrOfJoints() ),
+	_q_lo( chain.getNrOfJoints() ),
+	_q_hi( chain.getNrOfJoints() ),
+	_seeds( std::max( seeds, 2u ) ),
+	_pool( std::max( seeds, 2u ) ),
+	_converged( false ),
+	_target( 0 ),
+	_q_current( chain.getNrOfJoints() ),
+	_has_current( false ),
+	_gen( random_seed ),
+	_unif( 0.0, 1.0 ),
+	_winner( -1 ),
+	_iter( 0 ) {
+
+	//Continuous joints: one turn
+	for(unsigned int i=0; i<_nj; i++) {
+		const bool bounded = i < q_min.rows() && i < q_max.rows() && std::isfinite( q_min(i) ) && std::isfinite( q_max(i) );
+		_q_lo(i) = bounded ? q_min(i) : -M_PI;
+		_q_hi(i) = bounded ? q_max(i) :  M_PI;
+	}
+
+	for(unsigned int k=0; k<_seeds.size(); k++) {
+		Seed &s = _seeds[k];
+		s.fksolver = new KDL::ChainFkSolverPos_recursive( _chain );
+		s.iksolver_vel = vel_factory( _chain );
+		s.iksolver = new ChainIkSolverPos_RT( _chain, *s.fksolver, *s.iksolver_vel, maxiter, eps, 1e-9, deadline );
+		s.iksolver->setCancel( &_converged );
+		s.q_seed.resize( _nj );
+		s.q_out.resize( _nj );
+		s.ret = E_NOERROR;
+	}
+
+	_job = boost::bind( &ChainIkSolverPos_MultiSeed::seed_job, this, _1 );
+}
+
+
+ChainIkSolverPos_MultiSeed::~ChainIkSolverPos_MultiSeed() {
+	for(unsigned int k=0; k<_seeds.size(); k++) {
+		delete _seeds[k].iksolver;
+		delete _seeds[k].iksolver_vel;
+		delete _seeds[k].fksolver;
+	}
+}
+
+
+void ChainIkSolverPos_MultiSeed::setCurrent( const KDL::JntArray &q ) {
+	if( q.rows() != _nj ) return;
+	_q_current = q;
+	_has_current = true;
+}
+
+
+void ChainIkSolverPos_MultiSeed::seed_job( int worker ) {
+	Seed &s = _seeds[worker];
+	s.ret = s.iksolver->CartToJnt( s.q_seed, *_target, s.q_out );
+	if( s.ret == E_NOERROR ) _converged.store( true, std::memory_order_relaxed );
+}
+
+
+int ChainIkSolverPos_MultiSeed::CartToJnt( const KDL::JntArray &q_init, const KDL::Frame &p_in, KDL::JntArray &q_out ) {
+
+	if( q_init.rows() != _nj || q_out.rows() != _nj )
+		return (error = E_SIZE_MISMATCH);
+
+	const KDL::JntArray &q_ref = _has_current ? _q_current : q_init;
+	_seeds[0].q_seed = q_ref;
+	_seeds[1].q_seed = q_init;
+	for(unsigned int k=2; k<_seeds.size(); k++)
+		for(unsigned int i=0; i<_nj; i++)
+			_seeds[k].q_seed(i) = _q_lo(i) + _unif(_gen)*( _q_hi(i) - _q_lo(i) );
+
+	_target = &p_in;
+	_converged.store( false, std::memory_order_relaxed );
+	_pool.run( _job );
+
+	//Converged seeds: closest to the current joints. Else: smallest residual
+	_winner = -1;
+	double best = HUGE_VAL;
+	for(unsigned int k=0; k<_seeds.size(); k++) {
+		if( _seeds[k].ret != E_NOERROR ) continue;
+		const double d = ( _seeds[k].q_out.data - q_ref.data ).squaredNorm();
+		if( d < best ) {
+			best = d;
+			_winner = k;
+		}
+	}
+	if( _winner < 0 ) {
+		//Every seed with a valid iterate: E_MAX_ITERATIONS_EXCEEDED is a normal failure
+		for(unsigned int k=0; k<_seeds.size(); k++) {
+			const int ret = _seeds[k].ret;
+			if( ret == E_SIZE_MISMATCH || ret == ChainIkSolverPos_RT::E_FKSOLVERPOS_FAILED ||
+					ret == ChainIkSolverPos_RT::E_IKSOLVERVEL_FAILED ) continue;
+			const double r = _seeds[k].iksolver->getResidual();
+			if( r < best ) {
+				best = r;
+				_winner = k;
+			}
+		}
+	}
+	_has_current = false;
+
+	if( _winner < 0 ) {
+		q_out = q_init;
+		return (error = _seeds[0].ret);
+	}
+	q_out = _seeds[_winner].q_out;
+	_iter = _seeds[_winner].iksolver->getIterations();
+	return (error = _seeds[_winner].ret);
+}
+
+
+const char* ChainIkSolverPos_MultiSeed::strError( const int error ) const {
+	//Same codes of the seed solvers
+	return _seeds[0].iksolver->strError( error );
+}
+
+}
@@ -0,0 +1,113 @@
+#include "iiwa_kdl/chainiksolverpos_rt.h"
+
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+
+namespace iiwa_kdl {
+
+ChainIkSolverPos_RT::ChainIkSolverPos_RT( const KDL::Chain &chain, KDL::ChainFkSolverPos &fksolver, KDL::ChainIkSolverVel &iksolver,
+		unsigned int maxiter, double eps, double eps_joints, double deadline ) :
+	_chain( chain ),
+	_fksolver( fksolver ),
+	_iksolver( iksolver ),
+	_maxiter( maxiter ),
+	_eps( eps ),
+	_eps_joints( eps_joints ),
+	_deadline( deadline ),
+	_cancel( 0 ),
+	_delta_q( chain.getNrOfJoints() ),
+	_q_best( chain.getNrOfJoints() ),
+	_iter( 0 ),
+	_best_err( 0.0 ) {
+}
+
+
+void ChainIkSolverPos_RT::updateInternalDataStructures() {
+	_delta_q.resize( _chain.getNrOfJoints() );
+	_q_best.resize( _chain.getNrOfJoints() );
+	_fksolver.updateInternalDataStructures();
+	_iksolver.updateInternalDataStructures();
+}
+
+
+//Largest component of the cartesian error, as KDL::Equal( twist, Twist::Zero(), eps )
+static double twist_err( const KDL::Twist &t ) {
+	double e = 0.0;
+	for(int i=0; i<3; i++) {
+		e = std::max( e, std::fabs( t.vel(i) ) );
+		e = std::max( e, std::fabs( t.rot(i) ) );
+	}
+	return e;
+}
+
+
+int ChainIkSolverPos_RT::CartToJnt( const KDL::JntArray &q_init, const KDL::Frame &p_in, KDL::JntArray &q_out ) {
+
+	if( q_init.rows() != _chain.getNrOfJoints() || q_out.rows() != _chain.getNrOfJoints() )
+		return (error = E_SIZE_MISMATCH);
+
+	typedef std::chrono::steady_clock clock;
+	const clock::time_point t_end = clock::now() + std::chrono::duration_cast<clock::duration>( std::chrono::duration<double>( _deadline ) );
+
+	q_out = q_init;
+	_q_best = q_init;
+	_best_err = HUGE_VAL;
+
+	for( _iter=0; _iter<_maxiter; _iter++ ) {
+
+		if( _fksolver.JntToCart( q_out, _f ) < 0 )
+			return (error = E_FKSOLVERPOS_FAILED);
+		_delta_twist = KDL::diff( _f, p_in );
+
+		//Track the best iterate: this is what we return on failure
+		const double err = twist_err( _delta_twist );
+		if( err < _best_err ) {
+			_best_err = err;
+			_q_best = q_out;
+		}
+
+		if( err < _eps ) {
+			q_out = _q_best;
+			return (error = E_NOERROR);
+		}
+
+		if( _cancel && _cancel->load( std::memory_order_relaxed ) ) {
+			q_out = _q_best;
+			return (error = E_CANCELED);
+		}
+
+		if( _deadline > 0.0 && clock::now() >= t_end ) {
+			q_out = _q_best;
+			return (error = E_DEADLINE_EXCEEDED);
+		}
+
+		const int ret = _iksolver.CartToJnt( q_out, _delta_twist, _delta_q );
+		if( ret < 0 ) {
+			q_out = _q_best;
+			return (error = E_IKSOLVERVEL_FAILED);
+		}
+		KDL::Add( q_out, _delta_q, q_out );
+
+		//The joint update is negligible: more iterations will not help
+		if( _delta_q.data.lpNorm<Eigen::Infinity>() < _eps_joints ) {
+			q_out = _q_best;
+			return (error = E_STALLED);
+		}
+	}
+
+	q_out = _q_best;
+	return (error = E_MAX_ITERATIONS_EXCEEDED);
+}
+
+
+const char* ChainIkSolverPos_RT::strError( const int error ) const {
+	if( E_DEADLINE_EXCEEDED == error ) return "Deadline exceeded, best iterate returned";
+	else if( E_STALLED == error ) return "Joint update below tolerance, best iterate returned";
+	else if( E_CANCELED == error ) return "Canceled, best iterate returned";
+	else if( E_IKSOLVERVEL_FAILED == error ) return "Child IK vel solver failed";
+	else if( E_FKSOLVERPOS_FAILED == error ) return "Child FK solver failed";
+	else return SolverI::strError( error );
+}
+
+}
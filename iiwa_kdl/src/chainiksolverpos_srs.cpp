@@ -0,0 +1,421 @@
+#include "iiwa_kdl/chainiksolverpos_srs.h"
+
+#include <cmath>
+#include <limits>
+
+namespace iiwa_kdl {
+
+typedef Eigen::Vector3d V3;
+typedef Eigen::Matrix3d M3;
+
+//Tolerance on the geometry of the chain (m)
+static const double GEOM_TOL = 1e-6;
+//Samples of the arm angle search
+static const int PSI_SAMPLES = 24;
+static const int PSI_REFINE = 12;
+
+static inline M3 rot( const V3 &w, double th ) {
+	return Eigen::AngleAxisd( th, w ).toRotationMatrix();
+}
+
+static inline double wrap( double th ) {
+	return std::atan2( std::sin(th), std::cos(th) );
+}
+
+//Paden-Kahan subproblem 1: th such that rot(w,th)*p = q
+static double sp1( const V3 &w, const V3 &p, const V3 &q ) {
+	const V3 pp = p - w*w.dot(p);
+	const V3 qp = q - w*w.dot(q);
+	return std::atan2( w.dot( pp.cross(qp) ), pp.dot(qp) );
+}
+
+//Paden-Kahan subproblem 2: th1, th2 such that rot(w1,th1)*rot(w2,th2)*p = q
+//	Return the number of solutions (0, 1 or 2)
+static int sp2( const V3 &w1, const V3 &w2, const V3 &p, const V3 &q, double th1[2], double th2[2] ) {
+	const double c = w1.dot(w2);
+	const V3 n = w1.cross(w2);
+	const double n2 = n.squaredNorm();
+	if( n2 < 1e-12 ) return 0;
+
+	//z = rot(w2,th2)*p = rot(w1,-th1)*q = a*w1 + b*w2 + g*(w1 x w2)
+	const double a = ( c*w2.dot(p) - w1.dot(q) ) / ( c*c - 1.0 );
+	const double b = ( c*w1.dot(q) - w2.dot(p) ) / ( c*c - 1.0 );
+	double g2 = ( p.squaredNorm() - a*a - b*b - 2.0*a*b*c ) / n2;
+	if( g2 < -1e-9*p.squaredNorm() ) return 0;
+	g2 = std::max( g2, 0.0 );
+
+	const double g = std::sqrt( g2 );
+	const int ns = ( g > 1e-12 ) ? 2 : 1;
+	for(int k=0; k<ns; k++) {
+		const V3 z = a*w1 + b*w2 + ( k == 0 ? g : -g )*n;
+		th2[k] = sp1( w2, p, z );
+		th1[k] = sp1( w1, z, q );
+	}
+	return ns;
+}
+
+//Paden-Kahan subproblem 3: th such that |rot(w,th)*(p - r) + r - q| = d, r is a point on the axis
+static int sp3( const V3 &w, const V3 &r, const V3 &p, const V3 &q, double d, double th[2] ) {
+	const V3 u = p - r;
+	const V3 v = q - r;
+	const V3 up = u - w*w.dot(u);
+	const V3 vp = v - w*w.dot(v);
+	const double nu = up.norm();
+	const double nv = vp.norm();
+	if( nu < GEOM_TOL || nv < GEOM_TOL ) return 0;
+
+	const double dz = w.dot( p - q );
+	const double dp2 = d*d - dz*dz;
+	double c = ( nu*nu + nv*nv - dp2 ) / ( 2.0*nu*nv );
+	if( std::fabs(c) > 1.0 + 1e-9 ) return 0;
+	c = std::max( -1.0, std::min( 1.0, c ) );
+
+	const double th0 = std::atan2( w.dot( up.cross(vp) ), up.dot(vp) );
+	const double a = std::acos( c );
+	th[0] = wrap( th0 - a );
+	th[1] = wrap( th0 + a );
+	return ( a > 1e-12 ) ? 2 : 1;
+}
+
+//Decomposition of a spherical joint: R = rot(a,t1)*rot(b,t2)*rot(c,t3)
+//	When the axes a and c are aligned (t2 = 0 or pi) only t1+t3 is defined and t1 = ref1
+static int spherical( const V3 &a, const V3 &b, const V3 &c, const M3 &R, double ref1, double t[2][3] ) {
+	const V3 tc = R*c;
+	const V3 v = c.unitOrthogonal();
+	double t1[2], t2[2];
+	int ns;
+
+	if( a.cross(c).norm() < 1e-9 && a.cross(tc).norm() < 1e-9 ) {
+		t1[0] = ref1;
+		t2[0] = sp1( b, c, tc );
+		ns = 1;
+	}
+	else {
+		ns = sp2( a, b, c, tc, t1, t2 );
+	}
+
+	for(int k=0; k<ns; k++) {
+		const M3 Q = rot( a, t1[k] )*rot( b, t2[k] );
+		t[k][0] = wrap( t1[k] );
+		t[k][1] = wrap( t2[k] );
+		t[k][2] = wrap( sp1( c, v, Q.transpose()*R*v ) );
+	}
+	return ns;
+}
+
+//Closest point of two lines, false if they do not intersect
+static bool intersect( const V3 &p1, const V3 &d1, const V3 &p2, const V3 &d2, V3 &x ) {
+	const V3 n = d1.cross(d2);
+	const double n2 = n.squaredNorm();
+	if( n2 < 1e-12 ) return false;
+	const double t1 = ( p2 - p1 ).cross(d2).dot(n) / n2;
+	const double t2 = ( p2 - p1 ).cross(d1).dot(n) / n2;
+	const V3 x1 = p1 + t1*d1;
+	const V3 x2 = p2 + t2*d2;
+	x = 0.5*( x1 + x2 );
+	return ( x1 - x2 ).norm() < GEOM_TOL;
+}
+
+static double line_distance( const V3 &r, const V3 &w, const V3 &x ) {
+	return ( ( x - r ) - w*w.dot( x - r ) ).norm();
+}
+
+
+ChainIkSolverPos_SRS::ChainIkSolverPos_SRS( const KDL::Chain &chain, const KDL::JntArray &q_min, const KDL::JntArray &q_max,
+		KDL::ChainIkSolverPos *fallback, ArmAnglePolicy policy ) :
+	_chain( chain ),
+	_fallback( fallback ),
+	_policy( policy ),
+	_valid( false ) {
+
+	_q_min.setConstant( -M_PI );
+	_q_max.setConstant( M_PI );
+	if( q_min.rows() == IIWA_NJ && q_max.rows() == IIWA_NJ ) {
+		_q_min = Eigen::Map<const Vector7d>( q_min.data.data() );
+		_q_max = Eigen::Map<const Vector7d>( q_max.data.data() );
+	}
+
+	_valid = initFromChain();
+}
+
+
+void ChainIkSolverPos_SRS::updateInternalDataStructures() {
+	_valid = initFromChain();
+	if( _fallback ) _fallback->updateInternalDataStructures();
+}
+
+
+bool ChainIkSolverPos_SRS::initFromChain() {
+
+	if( _chain.getNrOfJoints() != IIWA_NJ ) return false;
+
+	V3 w[IIWA_NJ], r[IIWA_NJ];
+	KDL::Frame T = KDL::Frame::Identity();
+	unsigned int j = 0;
+
+	for(unsigned int s=0; s<_chain.getNrOfSegments(); s++) {
+		const KDL::Segment &seg = _chain.getSegment(s);
+		const KDL::Joint &joint = seg.getJoint();
+
+		if( joint.getType() != KDL::Joint::None ) {
+			//Only revolute joints are allowed
+			if( joint.getType() != KDL::Joint::RotAxis && joint.getType() != KDL::Joint::RotX &&
+				joint.getType() != KDL::Joint::RotY && joint.getType() != KDL::Joint::RotZ ) return false;
+
+			const KDL::Vector axis = T.M*joint.JointAxis();
+			const KDL::Vector origin = T*joint.JointOrigin();
+			w[j] = V3( axis.x(), axis.y(), axis.z() ).normalized();
+			r[j] = V3( origin.x(), origin.y(), origin.z() );
+			j++;
+		}
+		T = T*seg.pose( 0.0 );
+	}
+
+	M3 M_R;
+	for(int i=0; i<3; i++)
+		for(int k=0; k<3; k++)
+			M_R(i, k) = T.M.data[i*3 + k];
+
+	return setGeometry( w, r, M_R, V3( T.p.x(), T.p.y(), T.p.z() ) );
+}
+
+
+bool ChainIkSolverPos_SRS::setGeometry( const Eigen::Vector3d w[IIWA_NJ], const Eigen::Vector3d r[IIWA_NJ],
+		const Eigen::Matrix3d &M_R, const Eigen::Vector3d &M_p ) {
+
+	_valid = false;
+	for(unsigned int i=0; i<IIWA_NJ; i++) {
+		_w[i] = w[i].normalized();
+		_r[i] = r[i];
+	}
+	_M_R = M_R;
+	_M_p = M_p;
+
+	//Spherical shoulder: axes 1, 2, 3 through S
+	if( !intersect( _r[0], _w[0], _r[1], _w[1], _S0 ) ) return false;
+	if( line_distance( _r[2], _w[2], _S0 ) > GEOM_TOL ) return false;
+
+	//Spherical wrist: axes 5, 6, 7 through W
+	if( !intersect( _r[4], _w[4], _r[5], _w[5], _W0 ) ) return false;
+	if( line_distance( _r[6], _w[6], _W0 ) > GEOM_TOL ) return false;
+
+	//The elbow must change the shoulder-wrist distance
+	if( line_distance( _r[3], _w[3], _S0 ) < GEOM_TOL || line_distance( _r[3], _w[3], _W0 ) < GEOM_TOL ) return false;
+
+	//Elbow center: projection of the shoulder on the elbow axis
+	_E0 = _r[3] + _w[3]*_w[3].dot( _S0 - _r[3] );
+	_W_tip = _M_R.transpose()*( _W0 - _M_p );
+
+	_valid = true;
+	return true;
+}
+
+
+void ChainIkSolverPos_SRS::fk( const Vector7d &q, Eigen::Matrix3d &R, Eigen::Vector3d &p ) const {
+	R = _M_R;
+	p = _M_p;
+	for(int i=IIWA_NJ-1; i>=0; i--) {
+		const M3 Ri = rot( _w[i], q(i) );
+		R = Ri*R;
+		p = Ri*( p - _r[i] ) + _r[i];
+	}
+}
+
+
+bool ChainIkSolverPos_SRS::referenceShoulder( double q4, const Eigen::Vector3d &Wd, Eigen::Matrix3d &R0 ) const {
+	const V3 W4 = rot( _w[3], q4 )*( _W0 - _r[3] ) + _r[3];
+	double t1[2], t2[2];
+	const int ns = sp2( _w[0], _w[1], W4 - _S0, Wd - _S0, t1, t2 );
+	if( ns == 0 ) return false;
+
+	//Fixed branch choice (t2 >= 0): the arm angle must be a function of the configuration
+	const int k = ( ns == 2 && wrap( t2[0] ) < 0.0 ) ? 1 : 0;
+	R0 = rot( _w[0], t1[k] )*rot( _w[1], t2[k] );
+	return true;
+}
+
+
+double ChainIkSolverPos_SRS::armAngle( const Vector7d &q ) const {
+	const M3 Rsh = rot( _w[0], q(0) )*rot( _w[1], q(1) )*rot( _w[2], q(2) );
+	const V3 W4 = rot( _w[3], q(3) )*( _W0 - _r[3] ) + _r[3];
+	const V3 W = _S0 + Rsh*( W4 - _S0 );
+
+	M3 R0;
+	if( !referenceShoulder( q(3), W, R0 ) ) return 0.0;
+
+	const V3 u = ( W - _S0 ).normalized();
+	V3 e_ref = R0*( _E0 - _S0 );
+	V3 e = Rsh*( _E0 - _S0 );
+	e_ref -= u*u.dot(e_ref);
+	e -= u*u.dot(e);
+	//Stretched arm: the elbow is on the S-W line and the arm angle is not defined
+	if( e_ref.norm() < GEOM_TOL || e.norm() < GEOM_TOL ) return 0.0;
+
+	return std::atan2( u.dot( e_ref.cross(e) ), e_ref.dot(e) );
+}
+
+
+bool ChainIkSolverPos_SRS::withinLimits( const Vector7d &q ) const {
+	return ( q.array() >= _q_min.array() ).all() && ( q.array() <= _q_max.array() ).all();
+}
+
+
+bool ChainIkSolverPos_SRS::elbow( const Eigen::Vector3d &Wd, Elbow &el ) const {
+	double q4[2];
+	const int n4 = sp3( _w[3], _r[3], _W0, _S0, ( Wd - _S0 ).norm(), q4 );
+
+	el.n = 0;
+	el.u = ( Wd - _S0 ).normalized();
+	for(int i=0; i<n4; i++) {
+		if( !referenceShoulder( q4[i], Wd, el.R0[el.n] ) ) continue;
+		el.q4[el.n] = q4[i];
+		el.R4[el.n] = rot( _w[3], q4[i] );
+		el.n++;
+	}
+	return el.n > 0;
+}
+
+
+double ChainIkSolverPos_SRS::solveArmAngle( double psi, const Eigen::Matrix3d &R, const Elbow &el,
+		const Vector7d &q_ref, Vector7d &q ) const {
+
+	double best = std::numeric_limits<double>::infinity();
+	const M3 Rpsi = rot( el.u, psi );
+	const M3 RMt = R*_M_R.transpose();
+
+	for(int i4=0; i4<el.n; i4++) {
+		//Shoulder: rotation of the reference solution around the S-W line
+		const M3 Rsh = Rpsi*el.R0[i4];
+		double sh[2][3];
+		const int nsh = spherical( _w[0], _w[1], _w[2], Rsh, q_ref(0), sh );
+
+		//Wrist: remaining orientation
+		const M3 Rw = ( Rsh*el.R4[i4] ).transpose()*RMt;
+		double wr[2][3];
+		const int nwr = spherical( _w[4], _w[5], _w[6], Rw, q_ref(4), wr );
+
+		for(int a=0; a<nsh; a++) {
+			for(int b=0; b<nwr; b++) {
+				Vector7d qc;
+				qc << sh[a][0], sh[a][1], sh[a][2], el.q4[i4], wr[b][0], wr[b][1], wr[b][2];
+				if( !withinLimits( qc ) ) continue;
+				const double cost = ( qc - q_ref ).squaredNorm();
+				if( cost < best ) {
+					best = cost;
+					q = qc;
+				}
+			}
+		}
+	}
+	return best;
+}
+
+
+int ChainIkSolverPos_SRS::solve( const Eigen::Matrix3d &R, const Eigen::Vector3d &p, const Vector7d &q_ref, Vector7d &q ) const {
+
+	if( !_valid ) return E_NOT_SRS;
+
+	//Wrist center of the target pose and elbow angle
+	const V3 Wd = p + R*_W_tip;
+	Elbow el;
+	if( !elbow( Wd, el ) ) return E_OUT_OF_REACH;
+
+	const double psi_ref = armAngle( q_ref );
+	Vector7d qc;
+	double best = solveArmAngle( psi_ref, R, el, q_ref, q );
+	double psi_best = psi_ref;
+
+	if( _policy == KEEP_CURRENT && best < std::numeric_limits<double>::infinity() )
+		return E_NOERROR;
+
+	//Coarse search over the arm angle
+	const double step = 2.0*M_PI/PSI_SAMPLES;
+	for(int k=1; k<PSI_SAMPLES; k++) {
+		const double psi = wrap( psi_ref + k*step );
+		const double cost = solveArmAngle( psi, R, el, q_ref, qc );
+		if( cost < best ) {
+			best = cost;
+			psi_best = psi;
+			q = qc;
+		}
+	}
+	if( best == std::numeric_limits<double>::infinity() ) return E_JOINT_LIMITS;
+
+	//Golden section refinement around the best sample
+	const double gr = 0.5*( std::sqrt(5.0) - 1.0 );
+	double a = psi_best - step;
+	double b = psi_best + step;
+	double c = b - gr*( b - a );
+	double d = a + gr*( b - a );
+	Vector7d qd;
+	double fc = solveArmAngle( c, R, el, q_ref, qc );
+	double fd = solveArmAngle( d, R, el, q_ref, qd );
+	for(int k=0; k<PSI_REFINE; k++) {
+		if( fc < best ) { best = fc; q = qc; }
+		if( fd < best ) { best = fd; q = qd; }
+		if( fc < fd ) {
+			b = d; d = c; fd = fc; qd = qc;
+			c = b - gr*( b - a );
+			fc = solveArmAngle( c, R, el, q_ref, qc );
+		}
+		else {
+			a = c; c = d; fc = fd; qc = qd;
+			d = a + gr*( b - a );
+			fd = solveArmAngle( d, R, el, q_ref, qd );
+		}
+	}
+	if( fc < best ) { best = fc; q = qc; }
+	if( fd < best ) { best = fd; q = qd; }
+
+	return E_NOERROR;
+}
+
+
+int ChainIkSolverPos_SRS::CartToJnt( const KDL::JntArray &q_init, const KDL::Frame &p_in, KDL::JntArray &q_out ) {
+
+	if( q_init.rows() != IIWA_NJ || q_out.rows() != IIWA_NJ )
+		return (error = E_SIZE_MISMATCH);
+
+	int ret = E_NOT_SRS;
+	if( _valid ) {
+		M3 R;
+		for(int i=0; i<3; i++)
+			for(int k=0; k<3; k++)
+				R(i, k) = p_in.M.data[i*3 + k];
+		const V3 p( p_in.p.x(), p_in.p.y(), p_in.p.z() );
+
+		Vector7d q;
+		ret = solve( R, p, Eigen::Map<const Vector7d>( q_init.data.data() ), q );
+		if( ret == E_NOERROR ) {
+			Eigen::Map<Vector7d>( q_out.data.data() ) = q;
+			return (error = E_NOERROR);
+		}
+	}
+
+	//Numeric solution when the closed form is not available
+	if( _fallback ) {
+		const int fb = _fallback->CartToJnt( q_init, p_in, q_out );
+		return (error = ( fb == E_NOERROR ) ? E_FALLBACK : fb);
+	}
+	return (error = ret);
+}
+
+
+bool ChainIkSolverPos_SRS::policyFromString( const std::string &name, ArmAnglePolicy &policy ) {
+	if( name == "keep" ) policy = KEEP_CURRENT;
+	else if( name == "min_change" ) policy = MIN_CHANGE;
+	else return false;
+	return true;
+}
+
+
+const char* ChainIkSolverPos_SRS::strError( const int error ) const {
+	if( E_OUT_OF_REACH == error ) return "Target out of reach";
+	else if( E_JOINT_LIMITS == error ) return "No solution within the joint limits";
+	else if( E_NOT_SRS == error ) return "The chain is not a spherical-revolute-spherical arm";
+	else if( E_FALLBACK == error ) return "Solution of the fallback solver";
+	else if( _fallback ) return _fallback->strError( error );
+	else return SolverI::strError( error );
+}
+
+}
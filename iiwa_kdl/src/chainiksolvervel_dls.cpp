@@ -0,0 +1,118 @@
+#include "iiwa_kdl/chainiksolvervel_dls.h"
+
+#include <cmath>
+
+namespace iiwa_kdl {
+
+//Relative pivot of the LDLT of J W^-1 J^T below which the jacobian is rank deficient
+static const double NULL_PIVOT_EPS = 1e-12;
+
+ChainIkSolverVel_DLS::ChainIkSolverVel_DLS( const KDL::Chain &chain, double lambda_max, double manip_threshold ) :
+	_chain( chain ),
+	_jac_solver( chain ),
+	_jac( chain.getNrOfJoints() ),
+	_lambda_max( lambda_max ),
+	_manip_threshold( manip_threshold ),
+	_null_gain( 0.0 ),
+	_objective( 0 ),
+	_objective_gain( 0.0 ),
+	_lambda2( 0.0 ),
+	_manip( 0.0 ),
+	_null_damped( false ) {
+
+	_w_inv.setOnes();
+	_q_rest.setZero();
+}
+
+
+void ChainIkSolverVel_DLS::updateInternalDataStructures() {
+	_jac_solver.updateInternalDataStructures();
+	_jac.resize( _chain.getNrOfJoints() );
+}
+
+
+void ChainIkSolverVel_DLS::setJointWeights( const Vector7d &w ) {
+	_w_inv = w.cwiseInverse();
+}
+
+
+void ChainIkSolverVel_DLS::setNullspace( const Vector7d &q_rest, double gain ) {
+	_q_rest = q_rest;
+	_null_gain = gain;
+}
+
+
+void ChainIkSolverVel_DLS::setNullspaceObjective( NullspaceObjective *objective, double gain ) {
+	_objective = objective;
+	_objective_gain = objective ? gain : 0.0;
+}
+
+
+void ChainIkSolverVel_DLS::setDamping( double lambda_max, double manip_threshold ) {
+	_lambda_max = lambda_max;
+	_manip_threshold = manip_threshold;
+}
+
+
+int ChainIkSolverVel_DLS::CartToJnt( const KDL::JntArray &q_in, const KDL::Twist &v_in, KDL::JntArray &qdot_out ) {
+
+	if( _chain.getNrOfJoints() != IIWA_NJ || q_in.rows() != IIWA_NJ || qdot_out.rows() != IIWA_NJ )
+		return (error = E_SIZE_MISMATCH);
+
+	if( _jac_solver.JntToJac( q_in, _jac ) < 0 )
+		return (error = E_JAC_FAILED);
+
+	Eigen::Map<const Jacobian7d> J( _jac.data.data() );
+	Eigen::Map<const Vector7d> q( q_in.data.data() );
+
+	//A = J W^-1 J^T
+	_jw.noalias() = J * _w_inv.asDiagonal();
+	_A.noalias() = _jw * J.transpose();
+
+	//Manipulability from the LDLT pivots: det(A) = prod(D)
+	_ldlt.compute( _A );
+	_manip = std::sqrt( std::fabs( _ldlt.vectorD().prod() ) );
+
+	//Damping only close to singular configurations
+	//	The null space projection keeps the undamped factorization: with the damped one the
+	//	null space velocity leaks in the task space. Only a rank deficient A (pivot below
+	//	NULL_PIVOT_EPS of the largest) projects with the damped one
+	const bool project = _null_gain > 0.0 || _objective_gain > 0.0;
+	_lambda2 = 0.0;
+	_null_damped = false;
+	if( _manip < _manip_threshold ) {
+		const double r = _manip / _manip_threshold;
+		_lambda2 = _lambda_max*_lambda_max*( 1.0 - r*r );
+		if( project ) {
+			const Vector6d D = _ldlt.vectorD().cwiseAbs();
+			_null_damped = D.minCoeff() <= NULL_PIVOT_EPS*D.maxCoeff();
+			if( !_null_damped ) _ldlt_null = _ldlt;
+		}
+		_A.diagonal().array() += _lambda2;
+		_ldlt.compute( _A );
+	}
+
+	_v << v_in.vel.x(), v_in.vel.y(), v_in.vel.z(), v_in.rot.x(), v_in.rot.y(), v_in.rot.z();
+	_y = _ldlt.solve( _v );
+	_qdot.noalias() = _jw.transpose() * _y;
+
+	//Null space term: z - W^-1 J^T A^-1 J z (undamped A)
+	if( project ) {
+		_z = -_null_gain*( q - _q_rest );
+		if( _objective_gain > 0.0 ) {
+			_objective->gradient( q, _grad );
+			_z -= _objective_gain*_grad;
+		}
+		_v.noalias() = J * _z;
+		if( _lambda2 > 0.0 && !_null_damped ) _y = _ldlt_null.solve( _v );
+		else _y = _ldlt.solve( _v );
+		_qdot += _z;
+		_qdot.noalias() -= _jw.transpose() * _y;
+	}
+
+	Eigen::Map<Vector7d>( qdot_out.data.data() ) = _qdot;
+
+	return (error = E_NOERROR);
+}
+
+}
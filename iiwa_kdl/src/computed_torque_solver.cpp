@@ -0,0 +1,65 @@
+#include "iiwa_kdl/computed_torque_solver.h"
+
+namespace iiwa_kdl {
+
+ComputedTorqueSolver::ComputedTorqueSolver( const KDL::Chain &chain, const KDL::Vector &gravity, Engine engine ) :
+	_engine( engine ),
+	_nj( chain.getNrOfJoints() ),
+	_id_solver( chain, gravity ),
+	_f_ext( chain.getNrOfSegments(), KDL::Wrench::Zero() ),
+	_dyn_param( chain, gravity ),
+	_M( chain.getNrOfJoints() ),
+	_coriol( chain.getNrOfJoints() ),
+	_grav( chain.getNrOfJoints() ),
+	_kernel( 0 ) {
+
+	if( _engine == FIXED ) {
+		_kernel = new IiwaKernel( gravity );
+		if( !_kernel->matches( chain ) ) {
+			delete _kernel;
+			_kernel = 0;
+			_engine = RNE;
+		}
+	}
+}
+
+
+ComputedTorqueSolver::~ComputedTorqueSolver() {
+	delete _kernel;
+}
+
+
+int ComputedTorqueSolver::compute( const KDL::JntArray &q, const KDL::JntArray &dq, const KDL::JntArray &qdd_ref, KDL::JntArray &tau ) {
+
+	if( _engine == RNE ) {
+		//No external wrenches: the result is M*qdd_ref + C*dq + g
+		return _id_solver.CartToJnt( q, dq, qdd_ref, _f_ext, tau );
+	}
+
+	if( _engine == FIXED ) {
+		_kernel->rnea( q.data, dq.data, qdd_ref.data, _tau );
+		tau.data = _tau;
+		return KDL::SolverI::E_NOERROR;
+	}
+
+	int ret;
+	if( (ret = _dyn_param.JntToMass( q, _M )) < 0 ) return ret;
+	if( (ret = _dyn_param.JntToCoriolis( q, dq, _coriol )) < 0 ) return ret;
+	if( (ret = _dyn_param.JntToGravity( q, _grav )) < 0 ) return ret;
+
+	tau.data.noalias() = _M.data * qdd_ref.data;
+	tau.data += _coriol.data + _grav.data;
+
+	return KDL::SolverI::E_NOERROR;
+}
+
+
+bool ComputedTorqueSolver::engineFromString( const std::string &name, Engine &engine ) {
+	if( name == "rne" ) engine = RNE;
+	else if( name == "dyn_param" ) engine = DYN_PARAM;
+	else if( name == "fixed" ) engine = FIXED;
+	else return false;
+	return true;
+}
+
+}
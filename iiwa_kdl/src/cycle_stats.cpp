@@ -0,0 +1,90 @@
+#include "iiwa_kdl/cycle_stats.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace iiwa_kdl {
+
+CycleStats::CycleStats( const std::string &name, const std::vector<std::string> &stages ) :
+	_name( name ), _stages( stages ), _overruns( 0 ), _failures( 0 ), _last_overruns( 0 ) {
+
+	_hist = new LatencyHistogram[ _stages.size() ];
+}
+
+
+CycleStats::~CycleStats() {
+	delete [] _hist;
+}
+
+
+void CycleStats::init( ros::NodeHandle &nh, double rate ) {
+	if( rate <= 0.0 ) return;
+
+	_diag_pub = nh.advertise< diagnostic_msgs::DiagnosticArray >("/diagnostics", 1);
+	_timer = nh.createTimer( ros::Duration( 1.0/rate ), &CycleStats::publish_cb, this );
+
+	_diag.status.resize(1);
+	_diag.status[0].name = _name + ": cycle";
+	_diag.status[0].hardware_id = _name;
+}
+
+
+static std::string us( uint64_t ns ) {
+	std::ostringstream ss;
+	ss << std::fixed << std::setprecision(1) << ns*1e-3;
+	return ss.str();
+}
+
+
+void CycleStats::publish_cb( const ros::TimerEvent & ) {
+	diagnostic_msgs::DiagnosticStatus &st = _diag.status[0];
+	st.values.clear();
+
+	diagnostic_msgs::KeyValue kv;
+	for(size_t i=0; i<_stages.size(); i++) {
+		const LatencyHistogram &h = _hist[i];
+		kv.key = _stages[i] + " p50 (us)";	kv.value = us( h.percentile(0.5) );		st.values.push_back( kv );
+		kv.key = _stages[i] + " p99 (us)";	kv.value = us( h.percentile(0.99) );	st.values.push_back( kv );
+		kv.key = _stages[i] + " max (us)";	kv.value = us( h.max() );				st.values.push_back( kv );
+	}
+
+	const uint64_t overruns = _overruns.load(std::memory_order_relaxed);
+	std::ostringstream ss;
+	ss << overruns;			kv.key = "overruns";	kv.value = ss.str();	st.values.push_back( kv );
+	ss.str("");
+	ss << _failures.load(std::memory_order_relaxed);
+	kv.key = "solver failures";		kv.value = ss.str();	st.values.push_back( kv );
+	ss.str("");
+	ss << ( _stages.empty() ? 0 : _hist[0].count() );
+	kv.key = "cycles";		kv.value = ss.str();	st.values.push_back( kv );
+
+	st.level = overruns > _last_overruns ? diagnostic_msgs::DiagnosticStatus::WARN : diagnostic_msgs::DiagnosticStatus::OK;
+	st.message = overruns > _last_overruns ? "period overrun" : "ok";
+	_last_overruns = overruns;
+
+	_diag.header.stamp = ros::Time::now();
+	_diag_pub.publish( _diag );
+}
+
+
+void CycleStats::dump( std::ostream &os ) const {
+	os << _name << " timing (us)" << std::endl;
+	os << std::left << std::setw(12) << "stage" << std::right
+		<< std::setw(10) << "count" << std::setw(10) << "mean" << std::setw(10) << "p50"
+		<< std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(10) << "max" << std::endl;
+
+	for(size_t i=0; i<_stages.size(); i++) {
+		const LatencyHistogram &h = _hist[i];
+		os << std::left << std::setw(12) << _stages[i] << std::right
+			<< std::setw(10) << h.count()
+			<< std::setw(10) << us( (uint64_t)h.mean() )
+			<< std::setw(10) << us( h.percentile(0.5) )
+			<< std::setw(10) << us( h.percentile(0.99) )
+			<< std::setw(10) << us( h.percentile(0.999) )
+			<< std::setw(10) << us( h.max() ) << std::endl;
+	}
+	os << "overruns: " << _overruns.load(std::memory_order_relaxed)
+		<< ", solver failures: " << _failures.load(std::memory_order_relaxed) << std::endl;
+}
+
+}
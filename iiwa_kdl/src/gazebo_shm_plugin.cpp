@@ -0,0 +1,112 @@
+#include <string>
+#include <vector>
+
+#include "boost/bind.hpp"
+#include <gazebo/gazebo.hh>
+#include <gazebo/common/common.hh>
+#include <gazebo/physics/physics.hh>
+
+#include "iiwa_kdl/shm_channel.h"
+
+namespace iiwa_kdl {
+
+//Simulator side of the shared memory channel (lbr_iiwa_description shm_channel:=<name>)
+//	At the beginning of each world update the plugin applies the newest effort command of
+//	the controller to the joints, then writes the joint state of the step in the channel.
+//	The force is added to the one of the ros_control effort controllers, which stay
+//	loaded for the joint_state_controller and the monitoring: they must command 0
+//	(kuka_invdyn_ctrl keeps publishing 0 on them in shared memory mode).
+//	Without commands for command_timeout seconds the joints get no force
+//	SDF: <channel> (/lbr_iiwa_shm), <joint_prefix> (lbr_iiwa_joint_), <command_timeout> (0.1)
+class IiwaShmPlugin : public gazebo::ModelPlugin {
+	public:
+		IiwaShmPlugin() : _seq( 0 ), _has_cmd( false ), _cmd_time( 0.0 ), _cmd_timeout( 0.1 ) {}
+
+		//The object is not removed: a controller still running reconnects at the next start
+		virtual ~IiwaShmPlugin() {
+			_shm.close();
+		}
+
+		virtual void Load( gazebo::physics::ModelPtr model, sdf::ElementPtr sdf ) {
+			_model = model;
+			_channel = sdf->HasElement( "channel" ) ? sdf->Get<std::string>( "channel" ) : std::string( "/lbr_iiwa_shm" );
+			const std::string prefix = sdf->HasElement( "joint_prefix" ) ? sdf->Get<std::string>( "joint_prefix" ) : std::string( "lbr_iiwa_joint_" );
+			if( sdf->HasElement( "command_timeout" ) ) _cmd_timeout = sdf->Get<double>( "command_timeout" );
+
+			//Chain order of the controller: joint 1 .. 7
+			for(unsigned int i=0; i<IIWA_NJ; i++) {
+				const std::string name = prefix + std::to_string( i + 1 );
+				gazebo::physics::JointPtr joint = model->GetJoint( name );
+				if( !joint ) {
+					gzerr << "IiwaShmPlugin: no joint " << name << " in the model\n";
+					return;
+				}
+				_joints.push_back( joint );
+			}
+
+			//The records of a previous run are dropped by open()
+			if( !_shm.open( _channel, ShmChannel::SIMULATOR, 1.0 ) ) {
+				gzerr << "IiwaShmPlugin: cannot open the shared memory channel " << _channel << "\n";
+				return;
+			}
+			//The controller derives its rate from the physics step
+#if GAZEBO_MAJOR_VERSION >= 8
+			_shm.setStep( model->GetWorld()->Physics()->GetMaxStepSize() );
+#else
+			_shm.setStep( model->GetWorld()->GetPhysicsEngine()->GetMaxStepSize() );
+#endif
+			gzmsg << "IiwaShmPlugin: joint states and efforts on " << _channel << "\n";
+
+			_update = gazebo::event::Events::ConnectWorldUpdateBegin( boost::bind( &IiwaShmPlugin::update, this ) );
+		}
+
+	private:
+		void update() {
+#if GAZEBO_MAJOR_VERSION >= 8
+			const double t = _model->GetWorld()->SimTime().Double();
+#else
+			const double t = _model->GetWorld()->GetSimTime().Double();
+#endif
+
+			if( _shm.readCommand( _cmd ) ) {
+				_has_cmd = true;
+				_cmd_time = t;
+			}
+			if( _has_cmd && t - _cmd_time > _cmd_timeout ) {
+				gzwarn << "IiwaShmPlugin: no command for " << _cmd_timeout << " s\n";
+				_has_cmd = false;
+			}
+			if( _has_cmd )
+				for(unsigned int i=0; i<IIWA_NJ; i++) _joints[i]->SetForce( 0, _cmd.cmd[i] );
+
+			_state.seq = ++_seq;
+			_state.stamp = t;
+			for(unsigned int i=0; i<IIWA_NJ; i++) {
+#if GAZEBO_MAJOR_VERSION >= 8
+				_state.q[i] = _joints[i]->Position( 0 );
+#else
+				_state.q[i] = _joints[i]->GetAngle( 0 ).Radian();
+#endif
+				_state.dq[i] = _joints[i]->GetVelocity( 0 );
+				_state.effort[i] = _joints[i]->GetForce( 0 );
+			}
+			_shm.writeState( _state );
+		}
+
+		gazebo::physics::ModelPtr _model;
+		std::vector<gazebo::physics::JointPtr> _joints;
+		gazebo::event::ConnectionPtr _update;
+
+		std::string _channel;
+		ShmChannel _shm;
+		ShmJointState _state;
+		ShmJointCommand _cmd;
+		uint64_t _seq;
+		bool _has_cmd;
+		double _cmd_time;
+		double _cmd_timeout;
+};
+
+GZ_REGISTER_MODEL_PLUGIN( IiwaShmPlugin )
+
+}
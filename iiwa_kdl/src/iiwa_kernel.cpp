@@ -0,0 +1,121 @@
+#include "iiwa_kdl/iiwa_kernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <kdl/jacobian.hpp>
+#include <kdl/jntarray.hpp>
+#include <kdl/chainfksolverpos_recursive.hpp>
+#include <kdl/chainjnttojacsolver.hpp>
+#include <kdl/chainidsolver_recursive_newton_euler.hpp>
+
+namespace iiwa_kdl {
+
+bool backendFromString( const std::string &name, KinematicsBackend &backend ) {
+	if( name == "kdl" ) backend = BACKEND_KDL;
+	else if( name == "fixed" ) backend = BACKEND_FIXED;
+	else return false;
+	return true;
+}
+
+
+IiwaKernel::IiwaKernel( const KDL::Vector &gravity ) {
+	for(int k=0; k<3; k++) _gravity[k] = gravity(k);
+}
+
+
+void IiwaKernel::fk( const Vector7d &q, KDL::Frame *frames ) const {
+	double R[IIWA_NJ][9], p[IIWA_NJ][3];
+	iiwa_gen::fk( q.data(), R, p );
+	for(unsigned int i=0; i<IIWA_NJ; i++) {
+		for(int k=0; k<9; k++) frames[i].M.data[k] = R[i][k];
+		for(int k=0; k<3; k++) frames[i].p.data[k] = p[i][k];
+	}
+}
+
+
+void IiwaKernel::fk( const Vector7d &q, KDL::Frame &tip ) const {
+	KDL::Frame frames[IIWA_NJ];
+	fk( q, frames );
+	tip = frames[IIWA_NJ - 1];
+}
+
+
+void IiwaKernel::jacobian( const Vector7d &q, Jacobian7d &J ) const {
+	KDL::Frame frames[IIWA_NJ];
+	fk( q, frames );
+	jacobian( frames, J );
+}
+
+
+//Column i: z_i x ( p_tip - p_i ) and z_i, z_i axis of the joint in the base frame
+//	The generator accepts only axes of the joint frame: z_i is a column of the frame rotation
+void IiwaKernel::jacobian( const KDL::Frame *frames, Jacobian7d &J ) {
+	const KDL::Vector &p_tip = frames[IIWA_NJ - 1].p;
+	for(unsigned int i=0; i<IIWA_NJ; i++) {
+		const double *M = frames[i].M.data;
+		const int a = iiwa_gen::AXIS[i];
+		const KDL::Vector z = iiwa_gen::AXIS_SIGN[i]*KDL::Vector( M[a], M[3 + a], M[6 + a] );
+		const KDL::Vector v = z * ( p_tip - frames[i].p );
+		for(int k=0; k<3; k++) {
+			J( k, i ) = v(k);
+			J( 3 + k, i ) = z(k);
+		}
+	}
+}
+
+
+void IiwaKernel::rnea( const Vector7d &q, const Vector7d &dq, const Vector7d &qdd, Vector7d &tau ) const {
+	iiwa_gen::rnea( q.data(), dq.data(), qdd.data(), _gravity, tau.data() );
+}
+
+
+double IiwaKernel::compare( const KDL::Chain &chain, int samples, unsigned int seed ) const {
+	if( chain.getNrOfJoints() != IIWA_NJ || chain.getNrOfSegments() != IIWA_NJ )
+		return std::numeric_limits<double>::infinity();
+
+	KDL::ChainFkSolverPos_recursive fksolver( chain );
+	KDL::ChainJntToJacSolver jac_solver( chain );
+	KDL::ChainIdSolver_RNE id_solver( chain, KDL::Vector( _gravity[0], _gravity[1], _gravity[2] ) );
+	KDL::Wrenches f_ext( IIWA_NJ, KDL::Wrench::Zero() );
+
+	KDL::JntArray q( IIWA_NJ ), dq( IIWA_NJ ), qdd( IIWA_NJ ), tau( IIWA_NJ );
+	KDL::Jacobian J( IIWA_NJ );
+	std::vector<KDL::Frame> frames( IIWA_NJ );
+	KDL::Frame kframes[IIWA_NJ];
+	Jacobian7d kJ;
+	Vector7d ktau;
+
+	std::mt19937 gen( seed );
+	std::uniform_real_distribution<double> unif( -M_PI, M_PI );
+
+	double err = 0.0;
+	for(int s=0; s<samples; s++) {
+		for(unsigned int i=0; i<IIWA_NJ; i++) {
+			q(i) = unif(gen);
+			dq(i) = unif(gen);
+			qdd(i) = unif(gen);
+		}
+		if( fksolver.JntToCart( q, frames ) < 0 || jac_solver.JntToJac( q, J ) < 0 ||
+				id_solver.CartToJnt( q, dq, qdd, f_ext, tau ) < 0 )
+			return std::numeric_limits<double>::infinity();
+
+		const Vector7d qv = q.data;
+		fk( qv, kframes );
+		jacobian( kframes, kJ );
+		rnea( qv, dq.data, qdd.data, ktau );
+
+		for(unsigned int i=0; i<IIWA_NJ; i++) {
+			for(int k=0; k<9; k++) err = std::max( err, std::fabs( frames[i].M.data[k] - kframes[i].M.data[k] ) );
+			for(int k=0; k<3; k++) err = std::max( err, std::fabs( frames[i].p.data[k] - kframes[i].p.data[k] ) );
+		}
+		err = std::max( err, ( J.data - kJ ).cwiseAbs().maxCoeff() );
+		err = std::max( err, ( tau.data - ktau ).cwiseAbs().maxCoeff() );
+	}
+	return err;
+}
+
+}
@@ -0,0 +1,89 @@
+#include "iiwa_kdl/ik_constraints.h"
+
+#include <algorithm>
+
+namespace iiwa_kdl {
+
+IkConstraints::IkConstraints( const KDL::Chain &chain, const KDL::JntArray &q_min, const KDL::JntArray &q_max ) :
+	_capsules( chain ),
+	_limit_margin( 0.1 ),
+	_limit_weight( 1.0 ),
+	_collision_activation( 0.03 ),
+	_collision_weight( 1.0 ),
+	_min_clearance( 0.0 ) {
+
+	for(unsigned int i=0; i<IIWA_NJ; i++) {
+		_q_min(i) = i < q_min.rows() ? q_min(i) : -M_PI;
+		_q_max(i) = i < q_max.rows() ? q_max(i) :  M_PI;
+	}
+	_grad_k.setZero();
+}
+
+
+void IkConstraints::setLimitCost( double margin, double weight ) {
+	_limit_margin = std::max( margin, 0.0 );
+	_limit_weight = weight;
+}
+
+
+void IkConstraints::setCollisionCost( double activation, double weight ) {
+	_collision_activation = activation;
+	_collision_weight = weight;
+}
+
+
+void IkConstraints::gradient( const Vector7d &q, Vector7d &grad ) {
+	grad.setZero();
+
+	//Joint limits: the margin is at most half of the range
+	if( _limit_weight > 0.0 ) {
+		for(unsigned int i=0; i<IIWA_NJ; i++) {
+			const double margin = std::min( _limit_margin, 0.5*( _q_max(i) - _q_min(i) ) );
+			const double lo = _q_min(i) + margin;
+			const double hi = _q_max(i) - margin;
+			if( q(i) > hi ) grad(i) = _limit_weight*( q(i) - hi );
+			else if( q(i) < lo ) grad(i) = _limit_weight*( q(i) - lo );
+		}
+	}
+
+	//Self collision: dH/dq = -w_c ( d_act - d_k ) dd_k/dq for the active pairs
+	if( _collision_weight > 0.0 && _capsules.valid() ) {
+		_capsules.update( q );
+		for(unsigned int k=0; k<IIWA_CAPSULE_PAIRS; k++) {
+			const double e = _collision_activation - _capsules.clearance(k);
+			if( e <= 0.0 ) continue;
+			_capsules.clearanceGradient( k, _grad_k );
+			grad -= _collision_weight*e*_grad_k;
+		}
+	}
+}
+
+
+int IkConstraints::check( const Vector7d &q ) {
+	for(unsigned int i=0; i<IIWA_NJ; i++)
+		if( q(i) < _q_min(i) || q(i) > _q_max(i) ) return (error = E_JOINT_LIMIT);
+
+	if( _capsules.valid() ) {
+		_capsules.update( q );
+		if( _capsules.minClearance() < _min_clearance ) return (error = E_SELF_COLLISION);
+	}
+	return (error = E_NOERROR);
+}
+
+
+double IkConstraints::minClearance( unsigned int *link_a, unsigned int *link_b ) const {
+	unsigned int k;
+	const double d = _capsules.minClearance( &k );
+	if( link_a ) *link_a = _capsules.linkA(k);
+	if( link_b ) *link_b = _capsules.linkB(k);
+	return d;
+}
+
+
+const char* IkConstraints::strError( const int error ) const {
+	if( E_JOINT_LIMIT == error ) return "Solution beyond the joint limits";
+	else if( E_SELF_COLLISION == error ) return "Solution in self collision";
+	else return SolverI::strError( error );
+}
+
+}
@@ -0,0 +1,212 @@
+#include "iiwa_kdl/jerk_limited_otg.h"
+#include "iiwa_kdl/param_utils.h"
+
+#include <math.h>
+
+namespace iiwa_kdl {
+
+//Joint speeds of the iiwa 14 R820 (rad/s)
+static const double IIWA_MAX_VELOCITY[IIWA_NJ] = { 1.483, 1.483, 1.745, 1.309, 2.269, 2.356, 2.356 };
+static const double DEFAULT_MAX_ACCELERATION = 2.0;
+static const double DEFAULT_MAX_JERK = 10.0;
+static const double MIN_LIMIT = 1e-6;
+//Bisection of the peak velocity
+static const int PEAK_ITERATIONS = 60;
+
+
+//Constant jerk segment of duration t from (p, v, a)
+static inline void integrate( double t, double j, double &p, double &v, double &a ) {
+	p += t*( v + t*( a/2.0 + t*j/6.0 ) );
+	v += t*( a + t*j/2.0 );
+	a += t*j;
+}
+
+
+//Segments from velocity v0 and acceleration a0 to velocity vt at zero acceleration in minimum
+//	time: jerk towards the peak acceleration, constant acceleration if the peak is the limit, jerk
+//	back to zero. Appended to t/j (3 segments)
+static void velocity_profile( double v0, double a0, double vt, double A, double J, double *t, double *j ) {
+	if( a0 > A ) a0 = A;
+	else if( a0 < -A ) a0 = -A;
+
+	//Velocity after bringing the acceleration to zero: side of the target
+	const double v_stop = v0 + a0*fabs(a0)/(2.0*J);
+	const double d = ( vt >= v_stop ) ? 1.0 : -1.0;
+
+	double ap = J*d*( vt - v0 ) + a0*a0/2.0;
+	ap = ( ap > 0.0 ) ? sqrt( ap ) : 0.0;
+	double t_hold = 0.0;
+	if( ap > A ) {
+		ap = A;
+		t_hold = ( d*( vt - v0 ) - ( 2.0*A*A - a0*a0 )/( 2.0*J ) )/A;
+		if( t_hold < 0.0 ) t_hold = 0.0;
+	}
+
+	t[0] = ( ap - d*a0 )/J;
+	if( t[0] < 0.0 ) t[0] = 0.0;
+	j[0] = d*J;
+	t[1] = t_hold;
+	j[1] = 0.0;
+	t[2] = ap/J;
+	j[2] = -d*J;
+}
+
+
+//Position at the end of the segments
+static double displacement( double p, double v, double a, const double *t, const double *j, int n ) {
+	for(int i=0; i<n; i++) integrate( t[i], j[i], p, v, a );
+	return p;
+}
+
+
+JerkLimitedOtg::JerkLimitedOtg() : _time( 0.0 ), _duration( 0.0 ) {
+	for(unsigned int i=0; i<IIWA_NJ; i++) {
+		_v_max[i] = IIWA_MAX_VELOCITY[i];
+		_a_max[i] = DEFAULT_MAX_ACCELERATION;
+		_j_max[i] = DEFAULT_MAX_JERK;
+		_q[i] = _qd[i] = _qdd[i] = 0.0;
+		_profile[i].p0 = _profile[i].v0 = _profile[i].a0 = 0.0;
+		_profile[i].target = 0.0;
+		_profile[i].n = 0;
+		_profile[i].duration = 0.0;
+	}
+}
+
+
+void JerkLimitedOtg::setLimits( const double *max_velocity, const double *max_acceleration, const double *max_jerk ) {
+	for(unsigned int i=0; i<IIWA_NJ; i++) {
+		_v_max[i] = ( max_velocity[i] > MIN_LIMIT ) ? max_velocity[i] : MIN_LIMIT;
+		_a_max[i] = ( max_acceleration[i] > MIN_LIMIT ) ? max_acceleration[i] : MIN_LIMIT;
+		_j_max[i] = ( max_jerk[i] > MIN_LIMIT ) ? max_jerk[i] : MIN_LIMIT;
+	}
+}
+
+
+void JerkLimitedOtg::reset( const double *q, const double *qd, const double *qdd ) {
+	for(unsigned int i=0; i<IIWA_NJ; i++) {
+		_q[i] = q[i];
+		_qd[i] = qd ? qd[i] : 0.0;
+		_qdd[i] = qdd ? qdd[i] : 0.0;
+		//Hold the state: target where the joint stops in minimum time
+		double t[3], j[3];
+		velocity_profile( _qd[i], _qdd[i], 0.0, _a_max[i], _j_max[i], t, j );
+		_profile[i].target = displacement( _q[i], _qd[i], _qdd[i], t, j, 3 );
+		plan( i );
+	}
+	_time = 0.0;
+	_duration = 0.0;
+	for(unsigned int i=0; i<IIWA_NJ; i++)
+		if( _profile[i].duration > _duration ) _duration = _profile[i].duration;
+}
+
+
+void JerkLimitedOtg::setTarget( const double *q_target ) {
+	_time = 0.0;
+	_duration = 0.0;
+	for(unsigned int i=0; i<IIWA_NJ; i++) {
+		_profile[i].target = q_target[i];
+		plan( i );
+		if( _profile[i].duration > _duration ) _duration = _profile[i].duration;
+	}
+}
+
+
+//Profile of joint i from the current reference to its target
+//	Peak velocity vc: the position reached by going to vc and then stopping grows with vc.
+//	If it falls short of the target even at the limit, cruise at the limit for the rest of the
+//	distance, else bisect vc with no cruise
+void JerkLimitedOtg::plan( unsigned int i ) {
+	Profile &pr = _profile[i];
+	pr.p0 = _q[i];
+	pr.v0 = _qd[i];
+	pr.a0 = _qdd[i];
+
+	const double V = _v_max[i];
+	const double A = _a_max[i];
+	const double J = _j_max[i];
+	const double dist = pr.target - pr.p0;
+
+	double *t = pr.t;
+	double *j = pr.j;
+	double vc, t_cruise = 0.0;
+
+	velocity_profile( pr.v0, pr.a0, V, A, J, t, j );
+	velocity_profile( V, 0.0, 0.0, A, J, t+4, j+4 );
+	const double f_max = displacement( 0.0, pr.v0, pr.a0, t, j, 3 ) + displacement( 0.0, V, 0.0, t+4, j+4, 3 ) - dist;
+
+	velocity_profile( pr.v0, pr.a0, -V, A, J, t, j );
+	velocity_profile( -V, 0.0, 0.0, A, J, t+4, j+4 );
+	const double f_min = displacement( 0.0, pr.v0, pr.a0, t, j, 3 ) + displacement( 0.0, -V, 0.0, t+4, j+4, 3 ) - dist;
+
+	if( f_max <= 0.0 ) {
+		vc = V;
+		t_cruise = -f_max/V;
+	}
+	else if( f_min >= 0.0 ) {
+		vc = -V;
+		t_cruise = f_min/V;
+	}
+	else {
+		double lo = -V, hi = V;
+		for(int k=0; k<PEAK_ITERATIONS; k++) {
+			vc = 0.5*( lo + hi );
+			velocity_profile( pr.v0, pr.a0, vc, A, J, t, j );
+			velocity_profile( vc, 0.0, 0.0, A, J, t+4, j+4 );
+			const double f = displacement( 0.0, pr.v0, pr.a0, t, j, 3 ) + displacement( 0.0, vc, 0.0, t+4, j+4, 3 ) - dist;
+			if( f > 0.0 ) hi = vc;
+			else lo = vc;
+		}
+		vc = 0.5*( lo + hi );
+	}
+
+	velocity_profile( pr.v0, pr.a0, vc, A, J, t, j );
+	t[3] = t_cruise;
+	j[3] = 0.0;
+	velocity_profile( vc, 0.0, 0.0, A, J, t+4, j+4 );
+	pr.n = MAX_SEGMENTS;
+
+	pr.duration = 0.0;
+	for(int k=0; k<pr.n; k++) pr.duration += t[k];
+}
+
+
+void JerkLimitedOtg::sample( const Profile &pr, double t, double &p, double &v, double &a ) const {
+	if( t >= pr.duration ) {
+		p = pr.target;
+		v = 0.0;
+		a = 0.0;
+		return;
+	}
+
+	p = pr.p0;
+	v = pr.v0;
+	a = pr.a0;
+	for(int k=0; k<pr.n && t > 0.0; k++) {
+		const double dt = ( t < pr.t[k] ) ? t : pr.t[k];
+		integrate( dt, pr.j[k], p, v, a );
+		t -= dt;
+	}
+}
+
+
+bool JerkLimitedOtg::update( double dt ) {
+	if( dt > 0.0 ) _time += dt;
+	for(unsigned int i=0; i<IIWA_NJ; i++) sample( _profile[i], _time, _q[i], _qd[i], _qdd[i] );
+	return !finished();
+}
+
+
+void loadOtgLimits( const ros::NodeHandle &nh, JerkLimitedOtg &otg ) {
+	double v[IIWA_NJ], a[IIWA_NJ], j[IIWA_NJ];
+	for(unsigned int i=0; i<IIWA_NJ; i++) {
+		v[i] = IIWA_MAX_VELOCITY[i];
+		a[i] = DEFAULT_MAX_ACCELERATION;
+		j[i] = DEFAULT_MAX_JERK;
+	}
+	loadJointParam( nh, "otg/max_velocity", v );
+	loadJointParam( nh, "otg/max_acceleration", a );
+	loadJointParam( nh, "otg/max_jerk", j );
+	otg.setLimits( v, a, j );
+}
+
+}
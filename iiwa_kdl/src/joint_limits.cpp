@@ -0,0 +1,45 @@
+#include "iiwa_kdl/joint_limits.h"
+
+#include <limits>
+#include <urdf/model.h>
+
+namespace iiwa_kdl {
+
+std::vector<std::string> chainJointNames( const KDL::Chain &chain ) {
+	std::vector<std::string> names;
+	for(unsigned int s=0; s<chain.getNrOfSegments(); s++) {
+		const KDL::Joint &j = chain.getSegment(s).getJoint();
+		if( j.getType() != KDL::Joint::None )
+			names.push_back( j.getName() );
+	}
+	return names;
+}
+
+
+bool jointLimitsFromUrdf( const std::string &robot_description, const KDL::Chain &chain,
+		KDL::JntArray &q_min, KDL::JntArray &q_max ) {
+
+	urdf::Model model;
+	if( !model.initString( robot_description ) ) return false;
+
+	std::vector<std::string> names = chainJointNames( chain );
+	q_min.resize( names.size() );
+	q_max.resize( names.size() );
+
+	for(unsigned int i=0; i<names.size(); i++) {
+		urdf::JointConstSharedPtr joint = model.getJoint( names[i] );
+		if( !joint ) return false;
+
+		if( joint->type == urdf::Joint::CONTINUOUS || !joint->limits ) {
+			q_min(i) = -std::numeric_limits<double>::infinity();
+			q_max(i) =  std::numeric_limits<double>::infinity();
+		}
+		else {
+			q_min(i) = joint->limits->lower;
+			q_max(i) = joint->limits->upper;
+		}
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,191 @@
+#include "iiwa_kdl/joint_trajectory_cache.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+
+namespace iiwa_kdl {
+
+//File header, followed by the signature, q and the second derivatives (doubles)
+static const char TRAJ_MAGIC[8] = { 'I', 'I', 'W', 'A', 'T', 'R', 'J', '1' };
+
+struct TrajFileHeader {
+	char magic[8];
+	uint32_t nj;
+	uint32_t n_signature;
+	uint64_t n;
+	double period;
+};
+
+
+JointTrajectoryCache::JointTrajectoryCache() : _nj( 0 ), _n( 0 ), _period( 0.0 ), _h( 0.0 ) {
+}
+
+
+bool JointTrajectoryCache::build( const std::vector<KDL::JntArray> &knots, double period ) {
+	_n = 0;
+	//A periodic cubic spline needs at least 3 knots
+	if( knots.size() < 3 || period <= 0.0 ) return false;
+
+	const unsigned int nj = knots[0].rows();
+	_q.resize( knots.size()*nj );
+	for(size_t k=0; k<knots.size(); k++) {
+		if( knots[k].rows() != nj ) return false;
+		for(unsigned int j=0; j<nj; j++) _q[ k*nj + j ] = knots[k](j);
+	}
+
+	_nj = nj;
+	_period = period;
+	_h = period/knots.size();
+	_n = knots.size();
+	return solveSpline();
+}
+
+
+//Uniform periodic spline: m[k-1] + 4 m[k] + m[k+1] = 6/h^2 ( q[k-1] - 2 q[k] + q[k+1] )
+//	Cyclic tridiagonal system, solved with the Thomas algorithm plus the
+//	Sherman-Morrison correction for the two corner elements
+bool JointTrajectoryCache::solveSpline() {
+	const size_t n = _n;
+	_m.assign( n*_nj, 0.0 );
+
+	const double gamma = -4.0;
+	std::vector<double> diag( n, 4.0 );
+	diag[0] -= gamma;
+	diag[n-1] -= 1.0/gamma;
+
+	//LU of the tridiagonal part, shared by all the right hand sides
+	std::vector<double> cp( n ), den( n );
+	den[0] = diag[0];
+	cp[0] = 1.0/den[0];
+	for(size_t k=1; k<n; k++) {
+		den[k] = diag[k] - cp[k-1];
+		cp[k] = 1.0/den[k];
+	}
+
+	std::vector<double> x( n ), z( n ), r( n );
+	const double c6 = 6.0/( _h*_h );
+
+	//z: correction vector, u = [gamma 0 ... 0 1]
+	for(size_t k=0; k<n; k++) r[k] = 0.0;
+	r[0] = gamma;
+	r[n-1] = 1.0;
+	z[0] = r[0]/den[0];
+	for(size_t k=1; k<n; k++) z[k] = ( r[k] - z[k-1] )/den[k];
+	for(size_t k=n-1; k-- > 0; ) z[k] -= cp[k]*z[k+1];
+	const double zden = 1.0 + z[0] + z[n-1]/gamma;
+	if( std::fabs( zden ) < 1e-12 ) return false;
+
+	for(unsigned int j=0; j<_nj; j++) {
+		for(size_t k=0; k<n; k++) {
+			const size_t km = ( k + n - 1 ) % n;
+			const size_t kp = ( k + 1 ) % n;
+			r[k] = c6*( _q[ km*_nj + j ] - 2.0*_q[ k*_nj + j ] + _q[ kp*_nj + j ] );
+		}
+		x[0] = r[0]/den[0];
+		for(size_t k=1; k<n; k++) x[k] = ( r[k] - x[k-1] )/den[k];
+		for(size_t k=n-1; k-- > 0; ) x[k] -= cp[k]*x[k+1];
+
+		const double fact = ( x[0] + x[n-1]/gamma )/zden;
+		for(size_t k=0; k<n; k++) _m[ k*_nj + j ] = x[k] - fact*z[k];
+	}
+	return true;
+}
+
+
+void JointTrajectoryCache::sample( double t, double *q, double *qd, double *qdd ) const {
+	double tm = std::fmod( t, _period );
+	if( tm < 0.0 ) tm += _period;
+
+	size_t k = (size_t)( tm/_h );
+	if( k >= _n ) k = _n - 1;
+	const size_t k1 = ( k + 1 ) % _n;
+
+	//Normalized position in the interval: a = 1 at knot k, b = 1 at knot k+1
+	const double b = ( tm - k*_h )/_h;
+	const double a = 1.0 - b;
+	const double h = _h;
+
+	const double *q0 = &_q[ k*_nj ];
+	const double *q1 = &_q[ k1*_nj ];
+	const double *m0 = &_m[ k*_nj ];
+	const double *m1 = &_m[ k1*_nj ];
+
+	for(unsigned int j=0; j<_nj; j++) {
+		q[j] = a*q0[j] + b*q1[j] + ( ( a*a*a - a )*m0[j] + ( b*b*b - b )*m1[j] )*h*h/6.0;
+		if( qd )
+			qd[j] = ( q1[j] - q0[j] )/h + ( -( 3.0*a*a - 1.0 )*m0[j] + ( 3.0*b*b - 1.0 )*m1[j] )*h/6.0;
+		if( qdd )
+			qdd[j] = a*m0[j] + b*m1[j];
+	}
+}
+
+
+bool JointTrajectoryCache::save( const std::string &file, const std::vector<double> &signature ) const {
+	if( !valid() ) return false;
+
+	FILE *f = fopen( file.c_str(), "wb" );
+	if( !f ) return false;
+
+	TrajFileHeader hdr;
+	memcpy( hdr.magic, TRAJ_MAGIC, sizeof(TRAJ_MAGIC) );
+	hdr.nj = _nj;
+	hdr.n_signature = signature.size();
+	hdr.n = _n;
+	hdr.period = _period;
+
+	bool ok = fwrite( &hdr, sizeof(hdr), 1, f ) == 1;
+	if( ok && !signature.empty() ) ok = fwrite( &signature[0], sizeof(double), signature.size(), f ) == signature.size();
+	if( ok ) ok = fwrite( &_q[0], sizeof(double), _q.size(), f ) == _q.size();
+	if( ok ) ok = fwrite( &_m[0], sizeof(double), _m.size(), f ) == _m.size();
+
+	return fclose( f ) == 0 && ok;
+}
+
+
+bool JointTrajectoryCache::load( const std::string &file, const std::vector<double> &signature ) {
+	FILE *f = fopen( file.c_str(), "rb" );
+	if( !f ) return false;
+
+	TrajFileHeader hdr;
+	bool ok = fread( &hdr, sizeof(hdr), 1, f ) == 1 && memcmp( hdr.magic, TRAJ_MAGIC, sizeof(TRAJ_MAGIC) ) == 0 &&
+		hdr.n_signature == signature.size() && hdr.n >= 3 && hdr.nj > 0 && hdr.period > 0.0;
+
+	std::vector<double> sig;
+	if( ok && hdr.n_signature > 0 ) {
+		sig.resize( hdr.n_signature );
+		ok = fread( &sig[0], sizeof(double), sig.size(), f ) == sig.size() && sig == signature;
+	}
+
+	//q and m must fill the rest of the file: a corrupted header allocates nothing
+	//	(the division keeps n*nj from overflowing)
+	if( ok ) {
+		const long pos = ftell( f );
+		ok = pos >= 0 && fseek( f, 0, SEEK_END ) == 0;
+		const long end = ok ? ftell( f ) : -1;
+		ok = ok && end >= pos && fseek( f, pos, SEEK_SET ) == 0;
+		const uint64_t left = ok ? ( end - pos )/( 2*sizeof(double) ) : 0;
+		ok = ok && hdr.n <= left/hdr.nj && hdr.n*hdr.nj == left;
+	}
+
+	std::vector<double> q, m;
+	if( ok ) {
+		q.resize( hdr.n*hdr.nj );
+		m.resize( hdr.n*hdr.nj );
+		ok = fread( &q[0], sizeof(double), q.size(), f ) == q.size() &&
+			fread( &m[0], sizeof(double), m.size(), f ) == m.size();
+	}
+	fclose( f );
+	if( !ok ) return false;
+
+	_nj = hdr.nj;
+	_n = hdr.n;
+	_period = hdr.period;
+	_h = _period/_n;
+	_q.swap( q );
+	_m.swap( m );
+	return true;
+}
+
+}
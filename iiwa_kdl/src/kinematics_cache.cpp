@@ -0,0 +1,61 @@
+#include "iiwa_kdl/kinematics_cache.h"
+
+#include <cmath>
+
+#include "iiwa_kdl/iiwa_types.h"
+
+namespace iiwa_kdl {
+
+KinematicsCache::KinematicsCache( const KDL::Chain &chain, KinematicsBackend backend ) :
+	_kernel( 0 ), _fksolver( chain ), _jac_solver( chain ),
+	_frames( chain.getNrOfSegments() ), _J( chain.getNrOfJoints() ), _manip( 0.0 ), _manip_valid( false ), _version( 0 ) {
+
+	if( backend == BACKEND_FIXED ) {
+		_kernel = new IiwaKernel();
+		if( !_kernel->matches( chain ) ) {
+			delete _kernel;
+			_kernel = 0;
+		}
+	}
+}
+
+
+KinematicsCache::~KinematicsCache() {
+	delete _kernel;
+}
+
+
+bool KinematicsCache::update( uint64_t version, const KDL::JntArray &q ) {
+	if( version == _version && _version != 0 ) return false;
+
+	if( _kernel ) {
+		//One pass for the frames, the jacobian is built from them
+		_kernel->fk( q.data, &_frames[0] );
+		IiwaKernel::jacobian( &_frames[0], _J7 );
+		_J.data = _J7;
+	}
+	else {
+		//One recursive pass for all the segment frames, the tip is the last one
+		_fksolver.JntToCart( q, _frames );
+		_jac_solver.JntToJac( q, _J );
+	}
+
+	_manip_valid = false;
+	_version = version;
+	return true;
+}
+
+
+double KinematicsCache::manipulability() const {
+	if( _manip_valid ) return _manip;
+
+	//J J^T is 6x6 for any number of joints: fixed size determinant, no allocations
+	Matrix6d JJt;
+	JJt.noalias() = _J.data*_J.data.transpose();
+	const double det = JJt.determinant();
+	_manip = det > 0.0 ? std::sqrt( det ) : 0.0;
+	_manip_valid = true;
+	return _manip;
+}
+
+}
@@ -1,157 +1,447 @@
-#include "ros/ros.h"
-#include "boost/thread.hpp"
-#include "sensor_msgs/JointState.h"
+#include "iiwa_kdl/kuka_invdyn_ctrl.h"
+
+#include "boost/bind.hpp"
 #include "geometry_msgs/Pose.h"
 #include <std_msgs/Float64.h>
 
-//Include KDL libraries
-#include <kdl_parser/kdl_parser.hpp>
-#include <kdl/chainiksolvervel_pinv.hpp>
-#include <kdl/chainfksolverpos_recursive.hpp>
-#include <kdl/chainiksolverpos_nr.hpp>
-//Get dynamic parameters
-#include <kdl/chaindynparam.hpp>
+#include "iiwa_kdl/rt_thread.h"
+#include "iiwa_kdl/param_utils.h"
 
 using namespace std;
 
-
-class KUKA_INVDYN {
-	public:
-		KUKA_INVDYN();
-
-		//From the run method we will start all the threads needed to accomplish the task
-		void run();
-		//Function to load the model from the URDF file (parameter server)
-		bool init_robot_model();
-		//Callback for the /joint_state message to retrieve the value of the joints
-		void joint_states_cb( sensor_msgs::JointState );
-		//Main control loop function
-		void ctrl_loop();
-
-
-	private:
-		ros::NodeHandle _nh;
-		KDL::Tree iiwa_tree;
-	
-		KDL::ChainFkSolverPos_recursive *_fksolver; //Forward position solver	
-		KDL::ChainIkSolverVel_pinv *_ik_solver_vel;   	//Inverse velocity solver
-		KDL::ChainIkSolverPos_NR *_ik_solver_pos;
-
-		KDL::Chain _k_chain;
-	
-		ros::Subscriber _js_sub;
-		ros::Publisher _cartpose_pub;
-		KDL::JntArray *_initial_q;
-		KDL::JntArray *_q_in;
-		KDL::JntArray *_dq_in;
-		bool _first_js;
-		bool _first_fk;
-		ros::Publisher _cmd_pub[7];
-		KDL::	Frame _p_out;
-		KDL::ChainDynParam *_dyn_param;
-};
+//Shared memory mode: rate of the zero commands of the effort controllers (Hz)
+static const double SHM_ZERO_RATE = 10.0;
+static const double SHM_ZERO_EFFORT[iiwa_kdl::IIWA_NJ] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
 
 
 bool KUKA_INVDYN::init_robot_model() {
-	std::string robot_desc_string;
-	_nh.param("robot_description", robot_desc_string, std::string());
-	if (!kdl_parser::treeFromString(robot_desc_string, iiwa_tree)){
-		ROS_ERROR("Failed to construct kdl tree");
+	//model_cache: binary file of the chain, the URDF is not parsed at the next startups
+	//	if it has not changed ("" to disable)
+	//	The controller needs only the chain dynamics: no ik solvers are built
+	std::string model_cache;
+	_nh_priv.param("model_cache", model_cache, std::string());
+	if( !iiwa_kdl::loadRobotModel( _nh, _model, model_cache ) ) return false;
+	_k_chain = _model.chain;
+
+	if( !_js_map.init( _k_chain ) ) {
+		ROS_ERROR("Unexpected number of joints in the kinematic chain: %d", _k_chain.getNrOfJoints());
 		return false;
 	}
 
-	std::string base_link = "lbr_iiwa_link_0";
-	std::string tip_link  = "lbr_iiwa_link_7";
-	if ( !iiwa_tree.getChain(base_link, tip_link, _k_chain) ) return false;
-
-
-	_ik_solver_vel = new KDL::ChainIkSolverVel_pinv( _k_chain );
-	_ik_solver_pos = new KDL::ChainIkSolverPos_NR( _k_chain, *_fksolver, *_ik_solver_vel, 100, 1e-6 );
-
-	_q_in = new KDL::JntArray( _k_chain.getNrOfJoints() );
-	_dq_in = new KDL::JntArray( _k_chain.getNrOfJoints() );
 	_initial_q = new KDL::JntArray( _k_chain.getNrOfJoints() );
-	_dyn_param = new KDL::ChainDynParam(_k_chain,KDL::Vector(0,0,-9.81));
+
+	//dyn_engine = rne: one recursive Newton-Euler pass (default)
+	//dyn_engine = dyn_param: JntToMass/JntToCoriolis/JntToGravity
+	//dyn_engine = fixed: recursive Newton-Euler of the generated iiwa kernel
+	std::string dyn_engine;
+	_nh_priv.param("dyn_engine", dyn_engine, std::string("rne"));
+	iiwa_kdl::ComputedTorqueSolver::Engine engine;
+	if( !iiwa_kdl::ComputedTorqueSolver::engineFromString( dyn_engine, engine ) ) {
+		ROS_ERROR("Unknown dynamics engine: %s (use rne, dyn_param or fixed)", dyn_engine.c_str());
+		return false;
+	}
+	_ct_solver = new iiwa_kdl::ComputedTorqueSolver(_k_chain, KDL::Vector(0,0,-9.81), engine);
+	if( _ct_solver->engine() != engine )
+		ROS_WARN("The fixed iiwa kernel does not match the robot description: using the KDL rne");
 
 	return true;
 }
 
 
-KUKA_INVDYN::KUKA_INVDYN() {
+KUKA_INVDYN::KUKA_INVDYN( const ros::NodeHandle &nh, const ros::NodeHandle &nh_priv ) :
+	_nh( nh ), _nh_priv( nh_priv ), _running( false ), _rt_alloc_check( false ) {
 
 	if (!init_robot_model()) exit(1); 
 	ROS_INFO("Robot tree correctly loaded from parameter server!");
 
-	cout << "Joints and segments: " << iiwa_tree.getNrOfJoints() << " - " << iiwa_tree.getNrOfSegments() << endl;
+	cout << "Joints and segments: " << _k_chain.getNrOfJoints() << " - " << _k_chain.getNrOfSegments() << endl;
  
-	_js_sub = _nh.subscribe("/lbr_iiwa/joint_states", 0, &KUKA_INVDYN::joint_states_cb, this);
-	
-	
-	_cmd_pub[0] = _nh.advertise< std_msgs::Float64 > ("/lbr_iiwa/lbr_iiwa_joint_1_effort_controller/command", 0);
-	_cmd_pub[1] = _nh.advertise< std_msgs::Float64 > ("/lbr_iiwa/lbr_iiwa_joint_2_effort_controller/command", 0);
-	_cmd_pub[2] = _nh.advertise< std_msgs::Float64 > ("/lbr_iiwa/lbr_iiwa_joint_3_effort_controller/command", 0);
-	_cmd_pub[3] = _nh.advertise< std_msgs::Float64 > ("/lbr_iiwa/lbr_iiwa_joint_4_effort_controller/command", 0);
-	_cmd_pub[4] = _nh.advertise< std_msgs::Float64 > ("/lbr_iiwa/lbr_iiwa_joint_5_effort_controller/command", 0);
-	_cmd_pub[5] = _nh.advertise< std_msgs::Float64 > ("/lbr_iiwa/lbr_iiwa_joint_6_effort_controller/command", 0);
-	_cmd_pub[6] = _nh.advertise< std_msgs::Float64 > ("/lbr_iiwa/lbr_iiwa_joint_7_effort_controller/command", 0);
-
-	_first_js = false;
+	//cmd_mode = joint: one topic for each JointEffortController
+	//cmd_mode = group: one message for the joint_group_effort_controller
+	std::string cmd_mode;
+	_nh_priv.param("cmd_mode", cmd_mode, std::string("joint"));
+	_nh_priv.param("zero_copy", _zero_copy, false);
+	std::vector<std::string> cmd_topics;
+	cmd_topics.push_back("/lbr_iiwa/lbr_iiwa_joint_1_effort_controller/command");
+	cmd_topics.push_back("/lbr_iiwa/lbr_iiwa_joint_2_effort_controller/command");
+	cmd_topics.push_back("/lbr_iiwa/lbr_iiwa_joint_3_effort_controller/command");
+	cmd_topics.push_back("/lbr_iiwa/lbr_iiwa_joint_4_effort_controller/command");
+	cmd_topics.push_back("/lbr_iiwa/lbr_iiwa_joint_5_effort_controller/command");
+	cmd_topics.push_back("/lbr_iiwa/lbr_iiwa_joint_6_effort_controller/command");
+	cmd_topics.push_back("/lbr_iiwa/lbr_iiwa_joint_7_effort_controller/command");
+	if( !_cmd_out.init( _nh, cmd_mode, cmd_topics, "/lbr_iiwa/joint_group_effort_controller/command", 0, _zero_copy ) )
+		exit(1);
+
+	//Shared memory channel of the gazebo plugin (lbr_iiwa_description shm_channel:=<name>)
+	//	The joint_states topic is still published by the joint_state_controller
+	//	shm_rate (Hz): loop rate, a whole number of physics steps of the simulator
+	std::string shm_channel;
+	double shm_timeout, shm_rate, shm_monitor_rate;
+	_nh_priv.param("shm_channel", shm_channel, std::string());
+	_nh_priv.param("shm_timeout", shm_timeout, 5.0);
+	_nh_priv.param("shm_rate", shm_rate, 250.0);
+	_nh_priv.param("shm_poll_us", _shm_poll_us, 50);
+	_nh_priv.param("shm_monitor_rate", shm_monitor_rate, 50.0);
+	_use_shm = !shm_channel.empty();
+	if( _use_shm ) {
+		if( !_shm.open( shm_channel, iiwa_kdl::ShmChannel::CONTROLLER, shm_timeout ) ) {
+			ROS_ERROR("Cannot open the shared memory channel %s", shm_channel.c_str());
+			exit(1);
+		}
+		if( !_shm.waitStep( shm_timeout ) ) {
+			ROS_ERROR("No physics step on the shared memory channel %s", shm_channel.c_str());
+			exit(1);
+		}
+		if( _shm_poll_us < 1 ) _shm_poll_us = 1;
+		//Simulation steps for each cycle and cycles for each monitor message
+		const double step = _shm.step();
+		_shm_decimation = shm_rate > 0.0 ? max( 1, (int)round( 1.0/( step*shm_rate ) ) ) : 1;
+		const double loop_rate = 1.0/( step*_shm_decimation );
+		_shm_monitor_decimation = shm_monitor_rate > 0.0 ? max( 1, (int)round( loop_rate/shm_monitor_rate ) ) : 0;
+		//The ros_control effort controllers stay loaded and keep their last command (e.g. of
+		//	an earlier TCPROS session): held at 0, the plugin force is the only one
+		_shm_zero_decimation = max( 1, (int)round( loop_rate/SHM_ZERO_RATE ) );
+		ROS_INFO("Physics step %g s: one cycle every %d steps (%.1f Hz)", step, _shm_decimation, loop_rate);
+		_shm_monitor_msg.data.resize( iiwa_kdl::IIWA_NJ );
+		if( _zero_copy ) _shm_monitor_pool.init( _shm_monitor_msg );
+		_shm_monitor_pub = _nh.advertise<std_msgs::Float64MultiArray>("/lbr_iiwa/shm_command", 1);
+		ROS_INFO("Joint states and commands on the shared memory channel %s", shm_channel.c_str());
+	}
+	else
+		_js_sub = _nh.subscribe("/lbr_iiwa/joint_states", 0, &KUKA_INVDYN::joint_states_cb, this, ros::TransportHints().tcpNoDelay());
+
+	//The joint_state_controller publishes at 500 Hz: decimation 2 is a 250 Hz loop
+	std::string trigger;
+	_nh_priv.param("trigger", trigger, std::string("rate"));
+	_nh_priv.param("ctrl_decimation", _decimation, 2);
+	if( trigger != "rate" && trigger != "event" ) {
+		ROS_ERROR("Unknown control trigger: %s (use rate or event)", trigger.c_str());
+		exit(1);
+	}
+	_event_trigger = ( trigger == "event" );
+	if( _decimation < 1 ) _decimation = 1;
+
+	//dyn: computed torque, publish: joint commands, cycle: whole computation,
+	//period: time between two cycle starts, latency: joint state stamp to command
+	std::vector<std::string> stages;
+	stages.push_back("dyn");
+	stages.push_back("publish");
+	stages.push_back("cycle");
+	stages.push_back("period");
+	stages.push_back("latency");
+	_stats = new iiwa_kdl::CycleStats( "kuka_invdyn_ctrl", stages );
+	double diag_rate;
+	_nh_priv.param("diag_rate", diag_rate, 1.0);
+	_stats->init( _nh, diag_rate );
+
+	//The log file is a ring of record_capacity cycles (default: 20 min of the 250 Hz loop)
+	std::string record_file;
+	int record_capacity;
+	double record_flush_period;
+	_nh_priv.param("record_file", record_file, std::string());
+	_nh_priv.param("record_capacity", record_capacity, 300000);
+	_nh_priv.param("record_flush_period", record_flush_period, 1.0);
+	if( !record_file.empty() &&
+		!( record_capacity > 0 && _recorder.open( record_file, record_capacity, iiwa_kdl::StateLogHeader::EFFORT, record_flush_period ) ) )
+		ROS_WARN("Cannot create the state log %s", record_file.c_str());
+	_fksolver = new KDL::ChainFkSolverPos_recursive( _k_chain );
+
 	_first_fk = false;
+
+	//initial_position: 7 joint values reached with the jerk limited otg from the first joint state
+	//	(otg/max_velocity, otg/max_acceleration, otg/max_jerk), else the first joint state is kept
+	_nh_priv.getParam("initial_position", _initial_target);
+	if( !_initial_target.empty() && _initial_target.size() != iiwa_kdl::IIWA_NJ ) {
+		ROS_ERROR("initial_position: %d values instead of %d", (int)_initial_target.size(), (int)iiwa_kdl::IIWA_NJ);
+		exit(1);
+	}
+	iiwa_kdl::loadOtgLimits( _nh_priv, _otg );
+
+	//Input: the trajectory and cartesian_trajectory topics of the position controller, in
+	//	robot_namespace. Joint setpoints: computed torque of the reference q, qd, qdd.
+	//	Cartesian setpoints: operational space control of the tip, null space posture at the
+	//	joints of the start of the cartesian motion (osc/* gains)
+	//	The trajectories are followed after the initial position, once ~start is called
+	//	(~autostart = true: immediately)
+	std::string ns;
+	double lookahead;
+	bool autostart;
+	_nh_priv.param("robot_namespace", ns, std::string("/lbr_iiwa"));
+	_nh_priv.param("trajectory_lookahead", lookahead, 0.1);
+	_nh_priv.param("autostart", autostart, false);
+	ros::NodeHandle traj_nh( _nh, ns );
+	_traj_in = new iiwa_kdl::TrajectoryStream;
+	_traj_in->init( traj_nh, _js_map.names(), lookahead );
+	_start.init( _nh_priv, autostart );
+
+	_osc = new iiwa_kdl::OperationalSpaceSolver( _k_chain, KDL::Vector(0,0,-9.81) );
+	iiwa_kdl::OperationalSpaceSolver::Gains osc_gains = _osc->gains();
+	iiwa_kdl::loadOscGains( _nh_priv, osc_gains );
+	_osc->setGains( osc_gains );
+
+	//Gains and loop rate: dynamic_reconfigure (cfg/InvDyn.cfg), initial values from the
+	//	parameter server. kp and kd can be lists of 7 values (or one): they set kp_1..kp_7, kd_1..kd_7
+	double kp[iiwa_kdl::IIWA_NJ], kd[iiwa_kdl::IIWA_NJ];
+	const bool kp_list = iiwa_kdl::loadJointParam( _nh_priv, "kp", kp );
+	const bool kd_list = iiwa_kdl::loadJointParam( _nh_priv, "kd", kd );
+	for(unsigned int i=0; i<iiwa_kdl::IIWA_NJ; i++) {
+		if( kp_list ) _nh_priv.setParam( "kp_" + std::to_string( i+1 ), kp[i] );
+		if( kd_list ) _nh_priv.setParam( "kd_" + std::to_string( i+1 ), kd[i] );
+	}
+	_reconf_srv.reset( new dynamic_reconfigure::Server<iiwa_kdl::InvDynConfig>( _nh_priv ) );
+	_reconf_srv->setCallback( boost::bind( &KUKA_INVDYN::reconfigure_cb, this, _1, _2 ) );
 }
 
 
-void KUKA_INVDYN::joint_states_cb( sensor_msgs::JointState js ) {
+KUKA_INVDYN::~KUKA_INVDYN() {
+	//The reconfigure service goes away before anything its callback uses
+	_reconf_srv.reset();
 
-	for(int i=0; i<7; i++ ) { 
-		_q_in->data[i] = js.position[i];
-		_dq_in->data[i] = js.velocity[i];
-		if( !_first_js ) _initial_q->data[i] = js.position[i];
-	}
+	//Trajectory subscriptions and the diagnostics timer
+	delete _traj_in;
+	delete _stats;
+
+	delete _osc;
+	delete _ct_solver;
+	delete _fksolver;
+	delete _initial_q;
+}
 
 
-	_first_js = true;
+void KUKA_INVDYN::reconfigure_cb( iiwa_kdl::InvDynConfig &config, uint32_t level ) {
+	LoopConfig cfg;
+	const double kp[iiwa_kdl::IIWA_NJ] = { config.kp_1, config.kp_2, config.kp_3, config.kp_4, config.kp_5, config.kp_6, config.kp_7 };
+	const double kd[iiwa_kdl::IIWA_NJ] = { config.kd_1, config.kd_2, config.kd_3, config.kd_4, config.kd_5, config.kd_6, config.kd_7 };
+	memcpy( cfg.kp, kp, sizeof(cfg.kp) );
+	memcpy( cfg.kd, kd, sizeof(cfg.kd) );
+	cfg.rate = config.rate;
+	//The control loop takes it at its next cycle
+	_loop_cfg.write( cfg );
+	ROS_INFO("Gains and rate updated (%.0f Hz)", cfg.rate);
 }
 
 
+void KUKA_INVDYN::joint_states_cb( const sensor_msgs::JointState::ConstPtr &js ) {
 
-void KUKA_INVDYN::ctrl_loop() {
+	double q[iiwa_kdl::IIWA_NJ];
+	double dq[iiwa_kdl::IIWA_NJ];
 
-	std_msgs::Float64 cmd[7];
-	KDL::JntArray coriol_(7);
-	KDL::JntArray grav_(7);
+	if( !_js_map.extract( *js, q, dq ) ) {
+		ROS_WARN_THROTTLE(1.0, "Joint state message does not contain all the chain joints");
+		return;
+	}
+
+	_js.write( q, dq, js->header.stamp.toSec() );
+	_js_event.notify();
+}
 
 
-	KDL::JntSpaceInertiaMatrix jsim_;
-	jsim_.resize(_k_chain.getNrOfJoints());
-	while( !_first_js ) usleep(0.1);
-		
+
+bool KUKA_INVDYN::shm_wait( uint64_t min_seq, double timeout, iiwa_kdl::ShmJointState &s ) {
+	const double t_end = ros::WallTime::now().toSec() + timeout;
+	do {
+		const double left = t_end - ros::WallTime::now().toSec();
+		if( left <= 0.0 || !_shm.waitState( s, left, _shm_poll_us ) ) return false;
+	} while( s.seq < min_seq );
+	return true;
+}
+
+
+void KUKA_INVDYN::ctrl_loop() {
+
+	KDL::JntArray q_in(_k_chain.getNrOfJoints());
+	KDL::JntArray dq_in(_k_chain.getNrOfJoints());
+	KDL::JntArray qdd_ref(_k_chain.getNrOfJoints());
+	KDL::JntArray tau(_k_chain.getNrOfJoints());
+	double js_stamp;
+
+	//Sleep until the first joint state
+	//	The first joint state is the position to keep
+	iiwa_kdl::ShmJointState shm_state;
+	iiwa_kdl::ShmJointCommand shm_cmd;
+	uint64_t shm_seq = 0;
+	uint64_t shm_cycles = 0;
+	if( _use_shm ) {
+		while( ros::ok() && _running && !shm_wait( 0, 1.0, shm_state ) );
+		for(unsigned int i=0; i<iiwa_kdl::IIWA_NJ; i++) (*_initial_q)(i) = shm_state.q[i];
+		shm_seq = shm_state.seq;
+	}
+	else {
+		while( ros::ok() && _running && !_js_event.wait( _js, 1, 1.0 ) );
+		_js.read( *_initial_q );
+	}
+	if( !_running ) return;
 
 	cout << "First js!!" << endl;
-	ros::Rate r(250);
-	double Kp = 150;
-	double Kd = 110;
+	//Gains and rate of the reconfigure server, copied again only when they change
+	LoopConfig cfg;
+	uint64_t cfg_version = 0;
+	for(unsigned int i=0; i<iiwa_kdl::IIWA_NJ; i++) {
+		cfg.kp[i] = 150;
+		cfg.kd[i] = 110;
+	}
+	cfg.rate = 250;
+	_loop_cfg.read( cfg, cfg_version );
+	ros::Rate r(cfg.rate);
+	Eigen::Map<const iiwa_kdl::Vector7d> Kp( cfg.kp );
+	Eigen::Map<const iiwa_kdl::Vector7d> Kd( cfg.kd );
+
+	//Reference q, qd, qdd: from the first joint state to the initial position
+	_otg.reset( _initial_q->data.data() );
+	if( !_initial_target.empty() ) {
+		_otg.setTarget( _initial_target.data() );
+		ROS_INFO("Initial position in %.2f s", _otg.duration());
+	}
+	double ref_stamp = -1.0;
+
+	//Joint reference of the last cycle (anchor of a new joint trajectory) and null space posture
+	iiwa_kdl::TrajectoryStream::Mode mode = iiwa_kdl::TrajectoryStream::NONE;
+	double q_ref[iiwa_kdl::IIWA_NJ];
+	double q_null[iiwa_kdl::IIWA_NJ];
+	memcpy( q_ref, _otg.q(), sizeof(q_ref) );
+	memcpy( q_null, q_ref, sizeof(q_null) );
+	KDL::Frame F_tip;
+
+	//Fixed size storage for the control law: nothing is allocated inside the loop
+	//	Views on the KDL buffers, allocated once above
+	Eigen::Map<const iiwa_kdl::Vector7d> q( q_in.data.data() );
+	Eigen::Map<const iiwa_kdl::Vector7d> dq( dq_in.data.data() );
+	Eigen::Map<iiwa_kdl::Vector7d> acc( qdd_ref.data.data() );
+	iiwa_kdl::Vector7d e, de;
+
+	uint64_t js_version = _js.version();
+
+	//Timestamps of the cycle stages (ns)
+	int64_t t_start, t_stage;
+	int64_t t_last_start = 0;
+
+	//Record of the state log
+	iiwa_kdl::StateRecord rec;
+	memset( &rec, 0, sizeof(rec) );
+
+	while( ros::ok() && _running ) {		
+
+		//Event mode: the cycle starts as soon as the new measurement is available
+		//	Shared memory: the simulation steps pace the loop
+		if( _use_shm ) {
+			if( !shm_wait( shm_seq + _shm_decimation, 0.1, shm_state ) ) {
+				ROS_WARN_THROTTLE(1.0, "No joint state on the shared memory channel");
+				continue;
+			}
+		}
+		else if( _event_trigger && !_js_event.wait( _js, js_version + _decimation, 0.1 ) ) {
+			ROS_WARN_THROTTLE(1.0, "No joint state received");
+			continue;
+		}
 
-	while( ros::ok() ) {		
+		t_start = iiwa_kdl::CycleStats::now();
+		if( t_last_start ) _stats->record( ST_PERIOD, t_start - t_last_start );
+		t_last_start = t_start;
+
+		//Consistent copy of q and dq for the whole cycle
+		if( _use_shm ) {
+			//Skipped simulation steps: the previous cycle was late
+			if( shm_state.seq > shm_seq + _shm_decimation ) _stats->overrun();
+			shm_seq = shm_state.seq;
+			for(unsigned int i=0; i<iiwa_kdl::IIWA_NJ; i++) {
+				q_in(i) = shm_state.q[i];
+				dq_in(i) = shm_state.dq[i];
+			}
+			js_stamp = shm_state.stamp;
+		}
+		else {
+			const uint64_t js_expected = js_version + _decimation;
+			js_version = _js.read( q_in, dq_in, js_stamp );
+			//Event mode: a newer sample than the awaited one means that the previous cycle was late
+			if( _event_trigger && js_version > js_expected ) _stats->overrun();
+		}
 
-		Eigen::VectorXd e = _initial_q->data - _q_in->data; //Keep initial position
+		//New configuration: applied from this cycle (no lock, no allocation)
+		if( _loop_cfg.read( cfg, cfg_version ) ) r = ros::Rate(cfg.rate);
+
+		//Reference advanced by the time of the joint state samples: it stops with the simulation
+		if( ref_stamp >= 0.0 && js_stamp > ref_stamp ) _otg.update( min( js_stamp - ref_stamp, 0.1 ) );
+		ref_stamp = js_stamp;
+
+		t_stage = iiwa_kdl::CycleStats::now();
+
+		//Streamed setpoint, once in the initial position and started
+		_fksolver->JntToCart( q_in, F_tip );
+		const iiwa_kdl::TrajectoryStream::Mode last_mode = mode;
+		if( _otg.finished() && _start.started() )
+			mode = _traj_in->update( ros::Time::now().toSec(), q_ref, F_tip );
+		const iiwa_kdl::TrajectoryStream::Setpoint &sp = _traj_in->setpoint();
+
+		int osc_status = KDL::SolverI::E_NOERROR;
+		if( mode == iiwa_kdl::TrajectoryStream::CARTESIAN ) {
+			//qdd_ref of the operational space control, the posture is the one at its start
+			if( last_mode != iiwa_kdl::TrajectoryStream::CARTESIAN ) memcpy( q_null, q_ref, sizeof(q_null) );
+			IIWA_RT_BEGIN( _rt_alloc_check );
+			osc_status = _osc->compute( q_in, dq_in, sp.F, sp.V, sp.A, q_null, qdd_ref );
+			IIWA_RT_END( _rt_alloc_check );
+			//Only damping if the solver fails
+			if( osc_status < 0 ) acc = -Kd.cwiseProduct(dq);
+			memcpy( q_ref, q_in.data.data(), sizeof(q_ref) );
+		}
+		else {
+			//Joint reference: trajectory setpoint, else the initial position otg
+			const bool joint_sp = ( mode == iiwa_kdl::TrajectoryStream::JOINT );
+			Eigen::Map<const iiwa_kdl::Vector7d> q_des( joint_sp ? sp.q : _otg.q() );
+			Eigen::Map<const iiwa_kdl::Vector7d> dq_des( joint_sp ? sp.qd : _otg.qd() );
+			Eigen::Map<const iiwa_kdl::Vector7d> ddq_des( joint_sp ? sp.qdd : _otg.qdd() );
 
-		Eigen::VectorXd de = -_dq_in->data; //Desired velocity: 0
-		_dyn_param->JntToMass(*_q_in, jsim_);
-		_dyn_param->JntToCoriolis(*_q_in, *_dq_in, coriol_);
-		_dyn_param->JntToGravity(*_q_in, grav_);
+			e = q_des - q;
 
+			de = dq_des - dq;
 
-		Eigen::VectorXd q_out = jsim_.data * (Kd*de + Kp*e ) + coriol_.data + grav_.data;
+			//tau = M*(qdd_des + Kd*de + Kp*e) + C*dq + g
+			acc = ddq_des + Kd.cwiseProduct(de) + Kp.cwiseProduct(e);
+			memcpy( q_ref, q_des.data(), sizeof(q_ref) );
+		}
 
-		for(int i=0; i<7; i++ ) {
-			cmd[i].data = q_out(i);
+		IIWA_RT_BEGIN( _rt_alloc_check );
+		const int ct_status = _ct_solver->compute(q_in, dq_in, qdd_ref, tau);
+		IIWA_RT_END( _rt_alloc_check );
+		if( ct_status < 0 || osc_status < 0 ) _stats->failure();
+		_stats->record( ST_DYN, iiwa_kdl::CycleStats::now() - t_stage );
+
+		t_stage = iiwa_kdl::CycleStats::now();
+		if( _use_shm ) {
+			shm_cmd.stamp = js_stamp;
+			memcpy( shm_cmd.cmd, tau.data.data(), sizeof(shm_cmd.cmd) );
+			if( !_shm.writeCommand( shm_cmd ) ) _stats->failure();
+			if( shm_cycles++ % _shm_zero_decimation == 0 ) _cmd_out.publish( SHM_ZERO_EFFORT );
+			if( _shm_monitor_decimation && shm_cycles % _shm_monitor_decimation == 0 ) {
+				if( _zero_copy ) {
+					const boost::shared_ptr<std_msgs::Float64MultiArray> &m = _shm_monitor_pool.get();
+					memcpy( m->data.data(), shm_cmd.cmd, sizeof(shm_cmd.cmd) );
+					_shm_monitor_pub.publish( m );
+				}
+				else {
+					memcpy( _shm_monitor_msg.data.data(), shm_cmd.cmd, sizeof(shm_cmd.cmd) );
+					_shm_monitor_pub.publish( _shm_monitor_msg );
+				}
+			}
 		}
-		for(int i=0; i<7; i++ ) {
-			_cmd_pub[i].publish( cmd[i] );
+		else
+			_cmd_out.publish( tau.data.data() );
+		_stats->record( ST_PUBLISH, iiwa_kdl::CycleStats::now() - t_stage );
+		_stats->record( ST_CYCLE, iiwa_kdl::CycleStats::now() - t_start );
+		_stats->record( ST_LATENCY, (int64_t)( ( ros::Time::now().toSec() - js_stamp )*1e9 ) );
+
+		if( _recorder.isOpen() ) {
+			rec.stamp = js_stamp;
+			rec.t_cmd = ros::Time::now().toSec();
+			memcpy( rec.q, q_in.data.data(), sizeof(rec.q) );
+			memcpy( rec.dq, dq_in.data.data(), sizeof(rec.dq) );
+			memcpy( rec.cmd, tau.data.data(), sizeof(rec.cmd) );
+			rec.setPose( F_tip );
+			rec.status = ( osc_status < 0 ) ? osc_status : ct_status;
+			_recorder.write( rec );
 		}
 		
-		
-		r.sleep();
+		//Rate mode: sleep() returns false when the period has been exceeded
+		if( !_use_shm && !_event_trigger && !r.sleep() ) _stats->overrun();
 	}
 
 
@@ -167,22 +457,37 @@ void KUKA_INVDYN::ctrl_loop() {
 }
 
 
-void KUKA_INVDYN::run() {
-
-
-	boost::thread ctrl_loop_t ( &KUKA_INVDYN::ctrl_loop, this);
-	ros::spin();	
-
+void KUKA_INVDYN::start() {
+	_running = true;
+	//Scheduling, affinity and stack prefault of the control thread: ~rt/ctrl
+	_ctrl_loop_t = boost::thread( iiwa_kdl::RtThreadFunction( iiwa_kdl::loadThreadRtConfig( _nh_priv, "ctrl" ),
+			boost::bind( &KUKA_INVDYN::ctrl_loop, this ) ) );
 }
 
 
+void KUKA_INVDYN::stop() {
+	_running = false;
+	//The log is unmapped only when the control loop does not write anymore
+	//	Its waits time out and check _running: a loop still alive is in a long cycle
+	if( _ctrl_loop_t.joinable() && !_ctrl_loop_t.try_join_for( boost::chrono::seconds(1) ) ) {
+		ROS_ERROR("The control loop is still running after 1 s, waiting for it");
+		_ctrl_loop_t.join();
+	}
+	_recorder.close();
+	//Atomic counters: the summary can be read while the control thread is still running
+	_stats->dump( cout );
+}
 
 
-int main(int argc, char** argv) {
+void KUKA_INVDYN::run() {
 
-	ros::init(argc, argv, "iiwa_kdl");
-	KUKA_INVDYN ik;
-	ik.run();
+	//Scheduling, affinity and stack prefault of each thread: ~rt/ctrl, ~rt/spinner
+	iiwa_kdl::lockProcessMemory( _nh_priv );
+	//Alone in its process: the allocation check of the solvers sees only this loop (debug builds)
+	_rt_alloc_check = true;
+	start();
+	iiwa_kdl::configureCurrentThread( iiwa_kdl::loadThreadRtConfig( _nh_priv, "spinner" ) );
+	ros::spin();	
 
-	return 0;
+	stop();
 }
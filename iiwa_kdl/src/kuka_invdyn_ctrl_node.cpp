@@ -0,0 +1,12 @@
+#include "iiwa_kdl/kuka_invdyn_ctrl.h"
+
+//Standalone process of the controller: the topics go through TCPROS
+//	The nodelet version (iiwa_kdl/KukaInvDynNodelet) shares the messages in process
+int main(int argc, char** argv) {
+
+	ros::init(argc, argv, "iiwa_kdl");
+	KUKA_INVDYN ik( ros::NodeHandle(), ros::NodeHandle("~") );
+	ik.run();
+
+	return 0;
+}
@@ -1,78 +1,32 @@
-#include "ros/ros.h"
-#include "boost/thread.hpp"
-#include "geometry_msgs/Pose.h"
-#include "sensor_msgs/JointState.h"
+#include "iiwa_kdl/kuka_invkin_ctrl.h"
+
+#include <iostream>
+
+#include "boost/bind.hpp"
 #include <std_msgs/Float64.h>
 
 //Include KDL libraries
 #include <kdl_parser/kdl_parser.hpp>
-#include <kdl/chainfksolverpos_recursive.hpp>
-#include <kdl/chainiksolvervel_pinv.hpp>
-#include <kdl/chainiksolverpos_nr.hpp>
+
+#include "iiwa_kdl/rt_thread.h"
+#include "iiwa_kdl/chainiksolverpos_rt.h"
+#include "iiwa_kdl/chainiksolvervel_dls.h"
+#include "iiwa_kdl/chainiksolverpos_srs.h"
+#include "iiwa_kdl/batch_kinematics.h"
 
 using namespace std;
 
+//Initial position of the robot, before the trajectory execution
+static const float IIWA_HOME[7] = { 0.0, 1.57, 0.0, 1.57, 0.0, 0.0, 0.0 };
+//The circle is parametrized by _t/(2*pi): one turn every 4*pi^2 s
+static const double CIRCLE_RADIUS = 0.3;
+static const double CIRCLE_Z = 1.0;
+static const double CIRCLE_PERIOD = 4.0*M_PI*M_PI;
 
-class KUKA_INVKIN {
-	public:
-		KUKA_INVKIN();
-
-		//From the run method we will start all the threads needed to accomplish the task
-		void run();
-		//Function to load the model from the URDF file (parameter server)
-		bool init_robot_model();
-		//Function to retrieve the pose of the end-effector using KDL
-		void get_dirkin();
-		//Callback for the /joint_state message to retrieve the value of the joints
-		void joint_states_cb( sensor_msgs::JointState );
-		//Joint space positioning to set an initial position
-		void goto_initial_position( float dp[7] );
-		//Main control loop function
-		void ctrl_loop();
-		
-	private:
-		ros::NodeHandle _nh;
-
-		//Kinematic chain
-		KDL::Chain _k_chain;
-		//Kinematic tree
-		KDL::Tree iiwa_tree;
-	
-		//Forward kinematics solver
-		KDL::ChainFkSolverPos_recursive *_fksolver; 	
-		//Implementation of a inverse velocity kinematics algorithm based on 
-		//the generalize pseudo inverse to calculate the velocity transformation 
-		//from Cartesian to joint space of a general KDL::Chain
-		KDL::ChainIkSolverVel_pinv *_ik_solver_vel;   	//Inverse velocity solver
-		
-		//Implementation of a general inverse position kinematics algorithm based on Newton-Raphson 
-		//iterations to calculate the position transformation from Cartesian 
-		//to joint space of a general KDL::Chain. 
-		KDL::ChainIkSolverPos_NR *_ik_solver_pos;
-
-		ros::Subscriber _js_sub;
-		ros::Publisher _cartpose_pub;
-		ros::Publisher _cmd_pub[7];
-	
-		//Variable to store the joint configuration
-		KDL::JntArray *_q_in;
-		//Variable to store the end effector pose
-		KDL::Frame _p_out;
-
-		//Control flags to check 
-		//that data have been received
-		bool _first_js;
-		bool _first_fk;
-		bool _start_traj;
-
-		// Frequency and time variables 
-		int _freq;
-		float _t;
-	
-
-};
 
-KUKA_INVKIN::KUKA_INVKIN() {
+KUKA_INVKIN::KUKA_INVKIN( const std::string &name, const ros::NodeHandle &nh, const ros::NodeHandle &nh_cfg,
+		iiwa_kdl::RobotModelRegistry &models, iiwa_kdl::StartSignal &start ) :
+	_name( name ), _nh( nh ), _nh_cfg( nh_cfg ), _models( models ), _start( start ), _running( false ) {
 
 	//If the robot motdel is not correctly loaded, exit from the program
 	if (!init_robot_model()) 
@@ -80,179 +34,540 @@ KUKA_INVKIN::KUKA_INVKIN() {
 	ROS_INFO("Robot tree correctly loaded from parameter server!");
 
 	//Get some output from the kinemtic object: number of joints and links
-	cout << "Joints and segments: " << iiwa_tree.getNrOfJoints() << " - " << iiwa_tree.getNrOfSegments() << endl;
+	cout << "Joints and segments: " << _k_chain.getNrOfJoints() << " - " << _k_chain.getNrOfSegments() << endl;
  
 	//Input: the current configuration of the robot (its joints value)
-	_js_sub = _nh.subscribe("/lbr_iiwa/joint_states", 0, &KUKA_INVKIN::joint_states_cb, this);
+	_js_sub = _nh.subscribe("joint_states", 0, &KUKA_INVKIN::joint_states_cb, this, ros::TransportHints().tcpNoDelay());
 	
 	//Output: the cartesian position of the end-effector
-	_cartpose_pub = _nh.advertise<geometry_msgs::Pose>("/lbr_iiwa/eef_pose", 0);
+	_cartpose_pub = _nh.advertise<geometry_msgs::PoseStamped>("eef_pose", 1);
+	//Output: the return code of the ik solver, for each control cycle
+	_ik_status_pub = _nh.advertise<std_msgs::Int32>("ik_status", 1);
 	//Output: the command to the robot joints
-	_cmd_pub[0] = _nh.advertise< std_msgs::Float64 > ("/lbr_iiwa/joint1_position_controller/command", 1);
-	_cmd_pub[1] = _nh.advertise< std_msgs::Float64 > ("/lbr_iiwa/joint2_position_controller/command", 1);
-	_cmd_pub[2] = _nh.advertise< std_msgs::Float64 > ("/lbr_iiwa/joint3_position_controller/command", 1);
-	_cmd_pub[3] = _nh.advertise< std_msgs::Float64 > ("/lbr_iiwa/joint4_position_controller/command", 1);
-	_cmd_pub[4] = _nh.advertise< std_msgs::Float64 > ("/lbr_iiwa/joint5_position_controller/command", 1);
-	_cmd_pub[5] = _nh.advertise< std_msgs::Float64 > ("/lbr_iiwa/joint6_position_controller/command", 1);
-	_cmd_pub[6] = _nh.advertise< std_msgs::Float64 > ("/lbr_iiwa/joint7_position_controller/command", 1);
+	//	cmd_mode = joint: one topic for each JointPositionController
+	//	cmd_mode = group: one message for the joint_group_position_controller
+	std::string cmd_mode;
+	_nh_cfg.param("cmd_mode", cmd_mode, std::string("joint"));
+	_nh_cfg.param("zero_copy", _zero_copy, false);
+	std::vector<std::string> cmd_topics;
+	cmd_topics.push_back("joint1_position_controller/command");
+	cmd_topics.push_back("joint2_position_controller/command");
+	cmd_topics.push_back("joint3_position_controller/command");
+	cmd_topics.push_back("joint4_position_controller/command");
+	cmd_topics.push_back("joint5_position_controller/command");
+	cmd_topics.push_back("joint6_position_controller/command");
+	cmd_topics.push_back("joint7_position_controller/command");
+	if( !_cmd_out.init( _nh, cmd_mode, cmd_topics, "joint_group_position_controller/command", 1, _zero_copy ) )
+		exit(1);
+
+	//Input: the trajectory to follow
+	//	trajectory_lookahead (s): points moved from the input ring to the interpolation window
+	std::string trajectory;
+	_nh_cfg.param("trajectory", trajectory, std::string("stream"));
+	_traj_in = 0;
+	if( trajectory == "stream" ) {
+		double lookahead;
+		_nh_cfg.param("trajectory_lookahead", lookahead, 0.1);
+		_traj_in = new iiwa_kdl::TrajectoryStream;
+		_traj_in->init( _nh, _js_map.names(), lookahead );
+	}
+	else if( trajectory != "circle" ) {
+		ROS_ERROR("Unknown trajectory: %s (use stream or circle)", trajectory.c_str());
+		exit(1);
+	}
+
+	//Limits of the motion to the initial position
+	iiwa_kdl::loadOtgLimits( _nh_cfg, _otg );
 
 	//Set the control flags to false
-	_first_js = false;
-	_first_fk = false;
 	_start_traj = false;
 
-	// Set the frequency to 50 Hz and initialize the time to 0
+	// Set the frequency to 50 Hz (freq parameter) and initialize the time to 0
 	_freq = 50;
 	_t = 0.0;
+
+	double eef_max_rate;
+	_nh_cfg.param("eef_max_rate", eef_max_rate, 50.0);
+	_nh_cfg.param("eef_min_translation", _eef_min_translation, 1e-4);
+	_nh_cfg.param("eef_min_rotation", _eef_min_rotation, 1e-3);
+	_eef_min_period = eef_max_rate > 0.0 ? 1.0/eef_max_rate : 0.0;
+	_eef_last_stamp = -1.0;
+	_eef_msg.header.frame_id = _model->base_link;
+
+	//The joint_state_controller publishes at 500 Hz: decimation 2 is a 250 Hz loop
+	std::string trigger;
+	_nh_cfg.param("trigger", trigger, std::string("rate"));
+	_nh_cfg.param("ctrl_decimation", _decimation, 2);
+	if( trigger != "rate" && trigger != "event" ) {
+		ROS_ERROR("Unknown control trigger: %s (use rate or event)", trigger.c_str());
+		exit(1);
+	}
+	_event_trigger = ( trigger == "event" );
+	if( _decimation < 1 ) _decimation = 1;
+
+	//ik: CartToJnt, publish: joint commands, cycle: whole computation,
+	//period: time between two cycle starts, latency: joint state stamp to command
+	std::vector<std::string> stages;
+	stages.push_back("ik");
+	stages.push_back("publish");
+	stages.push_back("cycle");
+	stages.push_back("period");
+	stages.push_back("latency");
+	_stats = new iiwa_kdl::CycleStats( _name, stages );
+	double diag_rate;
+	_nh_cfg.param("diag_rate", diag_rate, 1.0);
+	_stats->init( _nh, diag_rate );
+
+	//The log file is a ring of record_capacity cycles (default: 25 min of the 200 Hz loop)
+	std::string record_file;
+	int record_capacity;
+	double record_flush_period;
+	_nh_cfg.param("record_file", record_file, std::string());
+	_nh_cfg.param("record_capacity", record_capacity, 300000);
+	_nh_cfg.param("record_flush_period", record_flush_period, 1.0);
+	if( !record_file.empty() &&
+		!( record_capacity > 0 && _recorder.open( record_file, record_capacity, iiwa_kdl::StateLogHeader::POSITION, record_flush_period ) ) )
+		ROS_WARN("Cannot create the state log %s", record_file.c_str());
+
+	_nh_cfg.param("traj_cache_divergence", _traj_divergence, 0.1);
+	if( _use_traj_cache && _traj_in ) {
+		ROS_WARN("The joint trajectory cache is only for trajectory = circle: using the online ik");
+		_use_traj_cache = false;
+	}
+	if( _use_traj_cache && !init_traj_cache() ) {
+		ROS_WARN("Joint trajectory cache not available: using the online ik");
+		_use_traj_cache = false;
+	}
+
+	//Frequency and ik iterations: dynamic_reconfigure (cfg/InvKin.cfg) in the namespace of the
+	//	arm parameters, initial values from the parameter server
+	_loop_cfg_version = 0;
+	_reconf_srv.reset( new dynamic_reconfigure::Server<iiwa_kdl::InvKinConfig>( _nh_cfg ) );
+	_reconf_srv->setCallback( boost::bind( &KUKA_INVKIN::reconfigure_cb, this, _1, _2 ) );
 }
 
 
+KUKA_INVKIN::~KUKA_INVKIN() {
+	//The reconfigure service goes away before anything its callback uses
+	_reconf_srv.reset();
 
-bool KUKA_INVKIN::init_robot_model() {
+	//Trajectory subscriptions and the diagnostics timer
+	delete _traj_in;
+	delete _stats;
 
-	//Retrieve the robot description (URDF) from the robot_description param
-	std::string robot_desc_string;
-	_nh.param("robot_description", robot_desc_string, std::string());
-	
-	//Use the treeFromString function to convert the robot model into a kinematic tree 
-	if (!kdl_parser::treeFromString(robot_desc_string, iiwa_tree)){
-		ROS_ERROR("Failed to construct kdl tree");
-		return false;
+	//The ik solvers reference the velocity solvers, the fk solver and the constraints
+	delete _ik_solver_ws;
+	delete _ik_solver_pos;
+	delete _ik_solver_vel;
+	delete _constraints;
+	for(unsigned int i=0; i<_seed_constraints.size(); i++) delete _seed_constraints[i];
+	delete _kin;
+	delete _fksolver;
+}
+
+
+void KUKA_INVKIN::reconfigure_cb( iiwa_kdl::InvKinConfig &config, uint32_t level ) {
+	LoopConfig cfg;
+	cfg.freq = config.freq;
+	cfg.ik_max_iter = config.ik_max_iter;
+	cfg.ik_eps = config.ik_eps;
+	//The control loop takes it at its next cycle
+	_loop_cfg.write( cfg );
+	ROS_INFO("%s: frequency %d Hz, ik %d iterations, eps %g", _name.c_str(), cfg.freq, cfg.ik_max_iter, cfg.ik_eps);
+}
+
+
+bool KUKA_INVKIN::update_config() {
+	LoopConfig cfg;
+	if( !_loop_cfg.read( cfg, _loop_cfg_version ) ) return false;
+
+	_freq = cfg.freq;
+	//Between two CartToJnt calls: the multiseed workers are idle
+	if( _ik_solver_pos ) {
+		_ik_solver_pos->setMaxIter( cfg.ik_max_iter );
+		_ik_solver_pos->setEps( cfg.ik_eps );
+	}
+	if( _ik_solver_rt ) {
+		_ik_solver_rt->setMaxIter( cfg.ik_max_iter );
+		_ik_solver_rt->setEps( cfg.ik_eps );
 	}
+	if( _ik_solver_ms ) {
+		_ik_solver_ms->setMaxIter( cfg.ik_max_iter );
+		_ik_solver_ms->setEps( cfg.ik_eps );
+	}
+	return true;
+}
+
+
+void KUKA_INVKIN::circle_target( double t, KDL::Frame &F, KDL::Twist &V ) const {
+
+	F.p.data[0] = CIRCLE_RADIUS*cos(t/(2*M_PI));
+	F.p.data[1] = CIRCLE_RADIUS*sin(t/(2*M_PI));
+	F.p.data[2] = CIRCLE_Z;
 
-	//Define the links of the desired chain base_link -> tip_link
-	std::string base_link = "lbr_iiwa_link_0";
-	std::string tip_link  = "lbr_iiwa_link_7";
-	if ( !iiwa_tree.getChain(base_link, tip_link, _k_chain) ) return false;
+	//Identity orientation
+	for(int i = 0; i < 9; i++)
+		F.M.data[i] = ( i == 0 || i == 4 || i == 8 ) ? 1 : 0;
+
+	//Time derivative of the goal position (the orientation is constant)
+	V.vel.data[0] = -CIRCLE_RADIUS/(2*M_PI)*sin(t/(2*M_PI));
+	V.vel.data[1] =  CIRCLE_RADIUS/(2*M_PI)*cos(t/(2*M_PI));
+	V.vel.data[2] = 0.0;
+	V.rot = KDL::Vector::Zero();
+}
+
+
+bool KUKA_INVKIN::init_traj_cache() {
+
+	//traj_cache_file: table loaded at startup if it matches the path, written otherwise ("" to disable)
+	std::string file;
+	int knots;
+	_nh_cfg.param("traj_cache_file", file, std::string());
+	_nh_cfg.param("traj_cache_knots", knots, 4000);
+	if( knots < 3 ) knots = 3;
+
+	//The table is valid only for the same path and seed
+	std::vector<double> signature;
+	signature.push_back( CIRCLE_RADIUS );
+	signature.push_back( CIRCLE_Z );
+	signature.push_back( CIRCLE_PERIOD );
+	signature.push_back( knots );
+	for(int i=0; i<7; i++) signature.push_back( IIWA_HOME[i] );
+
+	//Already computed by another arm of the same model
+	_traj_cache = _models.trajectory( _model.get(), signature );
+	if( _traj_cache ) return true;
+
+	boost::shared_ptr<iiwa_kdl::JointTrajectoryCache> table_cache( new iiwa_kdl::JointTrajectoryCache );
+	if( !file.empty() && table_cache->load( file, signature ) ) {
+		ROS_INFO("Joint trajectory loaded from %s", file.c_str());
+		if( table_cache->joints() != _k_chain.getNrOfJoints() ) return false;
+		_traj_cache = table_cache;
+		_models.addTrajectory( _model.get(), signature, _traj_cache );
+		return true;
+	}
+
+	//Cartesian waypoints of one period
+	iiwa_kdl::PoseBatch targets( knots );
+	KDL::Frame F;
+	KDL::Twist V;
+	for(int k=0; k<knots; k++) {
+		circle_target( k*CIRCLE_PERIOD/knots, F, V );
+		targets.set( k, F );
+	}
+
+	//Single worker: each waypoint is seeded with the previous solution
+	//	The first pass starts from the home position, the next ones from the end of the
+	//	previous pass, until the joint path closes on itself (no jump at the period)
+	iiwa_kdl::BatchKinematics batch( _k_chain, 1 );
+	iiwa_kdl::JointBatch q;
+	KDL::JntArray seed( _k_chain.getNrOfJoints() );
+	KDL::JntArray q_first( _k_chain.getNrOfJoints() );
+	KDL::JntArray q_prev_first( _k_chain.getNrOfJoints() );
+	for(unsigned int i=0; i<_k_chain.getNrOfJoints(); i++) seed(i) = IIWA_HOME[i];
+
+	bool closed = false;
+	for(int pass=0; pass<5 && !closed; pass++) {
+		if( batch.ik( targets, seed, q ) != (size_t)knots ) {
+			ROS_ERROR("The ik of the circle failed");
+			return false;
+		}
+		q.get( 0, q_first );
+		q.get( knots - 1, seed );
+		closed = pass > 0 && ( q_first.data - q_prev_first.data ).norm() < 1e-6;
+		q_prev_first = q_first;
+	}
+	if( !closed ) ROS_WARN("The joint path of the circle does not close: the trajectory jumps at each period");
+
+	std::vector<KDL::JntArray> table( knots, KDL::JntArray( _k_chain.getNrOfJoints() ) );
+	for(int k=0; k<knots; k++) q.get( k, table[k] );
+	if( !table_cache->build( table, CIRCLE_PERIOD ) ) return false;
+
+	if( !file.empty() ) {
+		if( table_cache->save( file, signature ) ) ROS_INFO("Joint trajectory saved in %s", file.c_str());
+		else ROS_WARN("Cannot write the joint trajectory in %s", file.c_str());
+	}
+	_traj_cache = table_cache;
+	_models.addTrajectory( _model.get(), signature, _traj_cache );
+	return true;
+}
+
+
+
+bool KUKA_INVKIN::init_robot_model() {
+
+	//Retrieve the robot description (URDF) from the robot_description param
+	//	and build the chain base_link -> tip_link (default lbr_iiwa_link_0 -> lbr_iiwa_link_7)
+	//	The model is parsed only by the first arm with this URDF
+	//	model_cache: binary file of the chain and the joint limits, the URDF is not parsed
+	//	at the next startups if it has not changed ("" to disable)
+	std::string base_link, tip_link, model_cache;
+	_nh_cfg.param("base_link", base_link, std::string(iiwa_kdl::IIWA_BASE_LINK));
+	_nh_cfg.param("tip_link", tip_link, std::string(iiwa_kdl::IIWA_TIP_LINK));
+	_nh_cfg.param("model_cache", model_cache, std::string());
+	_model = _models.load( _nh, model_cache, base_link, tip_link );
+	if( !_model ) return false;
+	_k_chain = _model->chain;
 
 	//Initialize the solvers
 	//Solvers are declared as pointer in the class definition
 	//Here we instantiate the solvers on the desired kinematic chain
+	//	Only the ones of the selected ik mode are built
+	_nh_cfg.param("ik_mode", _ik_mode, std::string("nr"));
+	_nh_cfg.param("traj_cache", _use_traj_cache, false);
 	_fksolver = new KDL::ChainFkSolverPos_recursive( _k_chain );
-	_ik_solver_vel = new KDL::ChainIkSolverVel_pinv( _k_chain );
+
+
+	//Kinematics of the measured joints: kdl solvers (default) or the generated iiwa kernel (fixed)
+	std::string kin_backend;
+	_nh_cfg.param("kinematics_backend", kin_backend, std::string("kdl"));
+	iiwa_kdl::KinematicsBackend backend;
+	if( !iiwa_kdl::backendFromString( kin_backend, backend ) ) {
+		ROS_ERROR("Unknown kinematics backend: %s (use kdl or fixed)", kin_backend.c_str());
+		return false;
+	}
+	_kin = new iiwa_kdl::KinematicsCache( _k_chain, backend );
+	if( _kin->backend() != backend )
+		ROS_WARN("The fixed iiwa kernel does not match the robot description: using the KDL solvers");
+	_constraints = 0;
+	_ik_solver_vel = 0;
+	_ik_solver_vel = new_ik_vel_solver( _k_chain );
+	if( !_ik_solver_vel ) return false;
 	//The invers kinematic solver object needs must be initialized considering also
 	//the number of iterations to solve the ik problem on a given robot configuration
 	//and the allowed error on the joint positioning 
-	_ik_solver_pos = new KDL::ChainIkSolverPos_NR( _k_chain, *_fksolver, *_ik_solver_vel, 100, 1e-6 );
-
-	//The _q_in is the vetor where the values of the joints at a current time
-	//are saved. Also this variable is a pointer
-	//Must be instantiated before its usage 
-	_q_in = new KDL::JntArray( _k_chain.getNrOfJoints() );
+	//	Used by the nr mode, as fallback of the srs mode and of the trajectory cache
+	//	(no deadline and no early exit on small joint updates: the KDL NR iteration)
+	int ik_max_iter;
+	double ik_eps, ik_deadline;
+	_nh_cfg.param("ik_max_iter", ik_max_iter, 100);
+	_nh_cfg.param("ik_eps", ik_eps, 1e-6);
+	_ik_solver_pos = 0;
+	if( _ik_mode == "nr" || _ik_mode == "srs" || _use_traj_cache )
+		_ik_solver_pos = new iiwa_kdl::ChainIkSolverPos_RT( _k_chain, *_fksolver, *_ik_solver_vel, ik_max_iter, ik_eps, 0.0, 0.0 );
+
+	//The real-time solver stops at the deadline (default: 80% of the 200 Hz control period)
+	//	and returns the best iterate found so far
+	_nh_cfg.param("ik_deadline", ik_deadline, 0.004);
+	_nh_cfg.param("clik_gain", _clik_gain, 20.0);
+	_ik_solver_ws = 0;
+	_ik_solver_rt = 0;
+	_ik_solver_ms = 0;
+	if( _ik_mode == "rt" ) {
+		_ik_solver_rt = new iiwa_kdl::ChainIkSolverPos_RT( _k_chain, *_fksolver, *_ik_solver_vel, ik_max_iter, ik_eps, 1e-9, ik_deadline );
+		_ik_solver_ws = _ik_solver_rt;
+	}
+	else if( _ik_mode == "multiseed" ) {
+		//Seeds within the URDF limits, one worker thread for each seed (ik_seeds >= 2)
+		int ik_seeds, ik_random_seed;
+		_nh_cfg.param("ik_seeds", ik_seeds, 4);
+		_nh_cfg.param("ik_random_seed", ik_random_seed, 1);
+		_ik_solver_ms = new iiwa_kdl::ChainIkSolverPos_MultiSeed( _k_chain, _model->q_min, _model->q_max,
+				boost::bind( &KUKA_INVKIN::new_ik_vel_solver, this, _1 ), max( ik_seeds, 2 ), ik_max_iter, ik_eps, ik_deadline, ik_random_seed );
+		_ik_solver_ws = _ik_solver_ms;
+	}
+	else if( _ik_mode == "srs" ) {
+		//The analytic solver needs the joint limits of the URDF to select the solution
+		//	srs_arm_angle = keep: arm angle of the previous solution
+		//	srs_arm_angle = min_change: arm angle closest to the previous solution
+		std::string arm_angle;
+		_nh_cfg.param("srs_arm_angle", arm_angle, std::string("keep"));
+		iiwa_kdl::ChainIkSolverPos_SRS::ArmAnglePolicy policy;
+		if( !iiwa_kdl::ChainIkSolverPos_SRS::policyFromString( arm_angle, policy ) ) {
+			ROS_ERROR("Unknown arm angle policy: %s (use keep or min_change)", arm_angle.c_str());
+			return false;
+		}
+		iiwa_kdl::ChainIkSolverPos_SRS *srs = new iiwa_kdl::ChainIkSolverPos_SRS( _k_chain, _model->q_min, _model->q_max, _ik_solver_pos, policy );
+		if( !srs->geometryValid() )
+			ROS_WARN("The kinematic chain is not a SRS arm: using the numeric ik");
+		_ik_solver_ws = srs;
+	}
+	else if( _ik_mode != "nr" && _ik_mode != "clik" ) {
+		ROS_ERROR("Unknown ik mode: %s (use nr, rt, srs, multiseed or clik)", _ik_mode.c_str());
+		return false;
+	}
 
+	//The joint snapshot has a fixed size: check that the chain matches it
+	//	and store the joint names to decode the joint_states messages
+	if( !_js_map.init( _k_chain ) ) {
+		ROS_ERROR("Unexpected number of joints in the kinematic chain: %d", _k_chain.getNrOfJoints());
+		return false;
+	}
 
 	return true;
 }
 
 
+//Velocity ik of the vel_ik_solver parameter on the chain, 0 if the solver is unknown
+//	Called once for each solver that needs its own instance (seeds of the multiseed mode):
+//	the first set of ik constraints is the one that validates the solutions
+KDL::ChainIkSolverVel *KUKA_INVKIN::new_ik_vel_solver( const KDL::Chain &chain ) {
+	//Warnings only for the first solver of the arm
+	const bool first = _ik_solver_vel == 0;
+	std::string ik_vel_solver;
+	bool ik_constraints;
+	_nh_cfg.param("ik_vel_solver", ik_vel_solver, std::string("pinv"));
+	_nh_cfg.param("ik_constraints", ik_constraints, false);
+	if( ik_constraints && ik_vel_solver == "pinv" ) {
+		if( first ) ROS_WARN("The ik constraints need the null space of the dls solver: using ik_vel_solver = dls");
+		ik_vel_solver = "dls";
+	}
+	if( ik_vel_solver == "dls" ) {
+		//Damped least squares: adaptive damping below the manipulability threshold
+		//	and optional joint centering in the null space (the iiwa limits are symmetric around 0)
+		double lambda_max, manip_threshold, null_gain;
+		_nh_cfg.param("dls_lambda_max", lambda_max, 0.1);
+		_nh_cfg.param("dls_manip_threshold", manip_threshold, 0.01);
+		_nh_cfg.param("dls_null_gain", null_gain, 0.0);
+		iiwa_kdl::ChainIkSolverVel_DLS *dls = new iiwa_kdl::ChainIkSolverVel_DLS( chain, lambda_max, manip_threshold );
+		dls->setNullspace( iiwa_kdl::Vector7d::Zero(), null_gain );
+		if( ik_constraints ) {
+			//Quadratic costs beyond ik_limit_margin (rad) from the URDF limits and below
+			//	ik_collision_activation (m) of clearance between the link capsules.
+			//	ik_min_clearance (m): smallest clearance of a valid solution
+			double limit_margin, limit_weight, collision_activation, collision_weight, min_clearance, gain;
+			_nh_cfg.param("ik_limit_margin", limit_margin, 0.1);
+			_nh_cfg.param("ik_limit_weight", limit_weight, 1.0);
+			_nh_cfg.param("ik_collision_activation", collision_activation, 0.03);
+			_nh_cfg.param("ik_collision_weight", collision_weight, 10.0);
+			_nh_cfg.param("ik_min_clearance", min_clearance, 0.0);
+			_nh_cfg.param("ik_constraints_gain", gain, 1.0);
+			iiwa_kdl::IkConstraints *constraints = new iiwa_kdl::IkConstraints( chain, _model->q_min, _model->q_max );
+			constraints->setLimitCost( limit_margin, limit_weight );
+			constraints->setCollisionCost( collision_activation, collision_weight );
+			constraints->setMinClearance( min_clearance );
+			if( first && !constraints->collisionModel() )
+				ROS_WARN("The kinematic chain does not match the capsule model: joint limits only");
+			dls->setNullspaceObjective( constraints, gain );
+			if( !_constraints ) _constraints = constraints;
+			else _seed_constraints.push_back( constraints );
+		}
+		return dls;
+	}
+	else if( ik_vel_solver == "pinv" ) {
+		return new KDL::ChainIkSolverVel_pinv( chain );
+	}
+	ROS_ERROR("Unknown velocity ik solver: %s (use pinv or dls)", ik_vel_solver.c_str());
+	return 0;
+}
+
+
 //Callback for the joint state
-void KUKA_INVKIN::joint_states_cb( sensor_msgs::JointState js ) {
+//	The message is received by const reference: no copy of the name/position vectors
+void KUKA_INVKIN::joint_states_cb( const sensor_msgs::JointState::ConstPtr &js ) {
+
+	double q[iiwa_kdl::IIWA_NJ];
+	double dq[iiwa_kdl::IIWA_NJ];
 
-	//We assume to know the number of joints
-	for(int i=0; i<7; i++ ) 
-		_q_in->data[i] = js.position[i];
+	//Joints are picked by name, whatever is their order in the message
+	if( !_js_map.extract( *js, q, dq ) ) {
+		ROS_WARN_THROTTLE(1.0, "Joint state message does not contain all the chain joints");
+		return;
+	}
 
-	//We can start the calculation of the fw kinematic
-	//We know that the first joint value set is arrived
-	_first_js = true;
+	//Publish the whole vector at once: readers never see a partial update
+	//	Once written, the fk calculation can start
+	_js.write( q, dq, js->header.stamp.toSec() );
+	_js_event.notify();
 }
 
 //Initial robot positioning
-//Command the initial velue until that value has not been reached
-//	If the robot is controlled in position, the inner loop of the acutator 
-//	will assure that the value will be reached in a smooth way
-void KUKA_INVKIN::goto_initial_position( float dp[7] ) {
+//The jerk limited otg moves the command from the measured joints to dp in minimum time
+//	(otg/max_velocity, otg/max_acceleration, otg/max_jerk), one step for each control cycle.
+//	Done when the command is on dp and the measured joints are within 0.002 rad of it
+void KUKA_INVKIN::goto_initial_position( const double dp[7] ) {
 	
-	ros::Rate r(10);
+	update_config();
+	ros::Rate r(_freq*4);
+	const double dt = 1.0/(_freq*4);
+
+	KDL::JntArray q_in(_k_chain.getNrOfJoints());
+	KDL::JntArray dq_in(_k_chain.getNrOfJoints());
+	double js_stamp;
+
+	//The reference starts at rest on the measured joints
+	update_kinematics( _js.read( q_in, dq_in, js_stamp ), q_in, js_stamp );
+	_otg.reset( q_in.data.data() );
+	_otg.setTarget( dp );
+	ROS_INFO("%s: initial position in %.2f s", _name.c_str(), _otg.duration());
 
-	float min_e = 1000.0;
 	float max_e = 1000.0;
 
-	std_msgs::Float64 cmd[7];
+	//While the reference moves or the maximum error over all the joints is higher than a given threshold 
+	while( _running && ( !_otg.finished() || max_e > 0.002 ) ) {
+		_otg.update( dt );
+		_cmd_out.publish( _otg.q() );
+		r.sleep();
 
-	//While the maximum error over all the joints is higher than a given threshold 
-	while( max_e > 0.002 ) {
- 		max_e = -1000;
-		//Command the same value for all the joints and calculate the maximum error
+		max_e = -1000;
+		update_kinematics( _js.read( q_in, dq_in, js_stamp ), q_in, js_stamp );
 		for(int i=0; i<7; i++) {
- 			cmd[i].data = dp[i];
-			_cmd_pub[i].publish (cmd[i]);
-			float e = fabs( cmd[i].data - _q_in->data[i] );
+			float e = fabs( dp[i] - q_in.data[i] );
 			//max_e is the maximum error over all the joints
 			max_e = ( e > max_e ) ? e : max_e;
 		}
-		r.sleep();
 	}
-
-	sleep(2);
 }
 
 
-void KUKA_INVKIN::get_dirkin() {
-
-	ros::Rate r(_freq);
-
-	KDL::JntArray q_curr(_k_chain.getNrOfJoints());
-
-	//Wait the first Joint state message
-	//	Without the first joint value
-	//	is not useful to calculate the Fk
-	while( !_first_js ) usleep(0.1);
-
-	//Output message to publish the pose of the end effector
-	geometry_msgs::Pose cpose;
-
-	while(ros::ok()) {
-
-		if(_start_traj) _t = _t + 1.0/_freq;
-		//JntToCart: Joint values to Cartesian space
-		//	First argument: the current value of the robot joints
-		//	Second argument: the calculated pose of the end effector
-		_fksolver->JntToCart(*_q_in, _p_out);
-
+void KUKA_INVKIN::publish_eef_pose( double stamp ) {
 
-		double qx, qy, qz, qw;
+	const KDL::Frame &p = _kin->tip();
 
-		cpose.position.x = _p_out.p.x();
-		cpose.position.y = _p_out.p.y();
-		cpose.position.z = _p_out.p.z();
+	//Rate limit, then publish only when the end effector moves
+	if( _eef_last_stamp >= 0.0 ) {
+		if( stamp - _eef_last_stamp < _eef_min_period ) return;
+		const KDL::Twist d = KDL::diff( _p_out, p );
+		if( d.vel.Norm() < _eef_min_translation && d.rot.Norm() < _eef_min_rotation ) return;
+	}
+	_p_out = p;
+	_eef_last_stamp = stamp;
+
+	_eef_msg.header.stamp = ros::Time( stamp );
+	_eef_msg.pose.position.x = _p_out.p.x();
+	_eef_msg.pose.position.y = _p_out.p.y();
+	_eef_msg.pose.position.z = _p_out.p.z();
+
+	//In KDL the p_out is a KDL::Frame data
+	//	The orientation is reported in the rotation matrix form
+	//	We can convert into quaternion
+	double qx, qy, qz, qw;
+	_p_out.M.GetQuaternion( qx, qy, qz, qw );
+	_eef_msg.pose.orientation.x = qx;
+	_eef_msg.pose.orientation.y = qy;
+	_eef_msg.pose.orientation.z = qz;
+	_eef_msg.pose.orientation.w = qw;
+
+	if( _zero_copy ) {
+		const boost::shared_ptr<geometry_msgs::PoseStamped> &m = _eef_pool.get();
+		*m = _eef_msg;
+		_cartpose_pub.publish( m );
+	}
+	else
+		_cartpose_pub.publish( _eef_msg );
+}
 
-		//In KDL the p_out is a KDL::Frame data
-		//	The orientation is reported in the rotation matrix form
-		//	We can convert into quaternion
-		_p_out.M.GetQuaternion( qx, qy, qz, qw);
-		cpose.orientation.w = qw;
-		cpose.orientation.x = qx;
-		cpose.orientation.y = qy;
-		cpose.orientation.x = qz;
 
-		_cartpose_pub.publish( cpose );		
-	
-		//Flag to true for the fk calculation (we can proceed with the ik solution)
-		_first_fk = true;
-	
-		r.sleep();
-	}
+void KUKA_INVKIN::update_kinematics( uint64_t version, const KDL::JntArray &q, double stamp ) {
+	if( _kin->update( version, q ) )
+		publish_eef_pose( stamp );
 }
 
 
 
 void KUKA_INVKIN::ctrl_loop() {
 	
-	//Wait until the first fk has not been calculated
-	while( !_first_fk ) usleep(0.1);
-
-	ros::Rate r(_freq*4);
+	//Wait the first joint state, then compute its kinematics
+	KDL::JntArray q_first(_k_chain.getNrOfJoints());
+	KDL::JntArray dq_first(_k_chain.getNrOfJoints());
+	double first_stamp;
+	while( _running && !_js.ready() ) usleep(1000);
+	if( !_running ) return;
+	update_kinematics( _js.read( q_first, dq_first, first_stamp ), q_first, first_stamp );
 
 	//Control the robot towards a fixed initial position
-	float i_cmd[7];
-	i_cmd[0] = 0.0;
-	i_cmd[1] = 1.57;
-	i_cmd[2] = 0.0;
-	i_cmd[3] = 1.57;
-	i_cmd[4] = 0.0;
-	i_cmd[5] = 0.0;
-	i_cmd[6] = 0.0;
+	double i_cmd[7];
+	for(int i=0; i<7; i++) i_cmd[i] = IIWA_HOME[i];
 	goto_initial_position( i_cmd );
 
 	//F_dest is the target frame: where we want to bring the robot end effector 
@@ -260,6 +575,37 @@ void KUKA_INVKIN::ctrl_loop() {
 
 	//q_out is the variable storing the output of the Inverse kinematic
 	KDL::JntArray q_out(_k_chain.getNrOfJoints());
+	//q_in is the consistent copy of the current joint values used as ik seed
+	KDL::JntArray q_in(_k_chain.getNrOfJoints());
+	//q_prev is the solution of the previous cycle (warm start of the rt solver)
+	KDL::JntArray q_prev(_k_chain.getNrOfJoints());
+	std_msgs::Int32 ik_status;
+
+	//Variables of the differential ik
+	//	V_dest: velocity of the trajectory, F_curr: pose of the commanded joint values
+	KDL::Twist V_dest;
+	KDL::Frame F_curr;
+	KDL::JntArray dq_out(_k_chain.getNrOfJoints());
+	//Rate of the loop: 4 times the frequency of the configuration in use, rebuilt when it changes
+	update_config();
+	int rate_freq = _freq;
+	ros::Rate r(rate_freq*4);
+	double dt_rate = 1.0/(rate_freq*4);
+	double dt = dt_rate;
+
+	//Measured joint velocities and time of the current sample
+	KDL::JntArray dq_in(_k_chain.getNrOfJoints());
+	double js_stamp = 0.0;
+	double js_last_stamp = 0.0;
+	uint64_t js_version;
+
+	//Timestamps of the cycle stages (ns)
+	int64_t t_start, t_stage;
+	int64_t t_last_start = 0;
+
+	//Record of the state log
+	iiwa_kdl::StateRecord rec;
+	memset( &rec, 0, sizeof(rec) );
 
 	/* std::cout << _p_out.p.x() << std::endl << _p_out.p.y() << std::endl << _p_out.p.z() << std::endl;
 	std::cout << _p_out.M.data[0] << "\t" << _p_out.M.data[1] << "\t" << _p_out.M.data[2] << std::endl;
@@ -267,21 +613,68 @@ void KUKA_INVKIN::ctrl_loop() {
 	std::cout << _p_out.M.data[6] << "\t" << _p_out.M.data[7] << "\t" << _p_out.M.data[8] << std::endl;
 	 */
 	//Lock the code to start manually the execution of the trajectory
-	cout << "Press enter to start the trajectory execution" << endl;
-	string ln;
-	getline(cin, ln);
+	if( !_start.wait( _running ) ) return;
 	_start_traj = true;
-	
-	std_msgs::Float64 cmd[7];
 
-	while(ros::ok()){
+	//The first warm start is the current configuration
+	js_version = _js.read( q_out, dq_in, js_last_stamp );
+	//Last valid command: held when the ik constraints reject a solution
+	KDL::JntArray q_cmd = q_out;
+
+	while( ros::ok() && _running ){
+
+		//Event mode: the cycle starts as soon as the new measurement is available
+		if( _event_trigger ) {
+			if( !_js_event.wait( _js, js_version + _decimation, 0.1 ) ) {
+				ROS_WARN_THROTTLE(1.0, "No joint state received");
+				continue;
+			}
+		}
+		t_start = iiwa_kdl::CycleStats::now();
+		if( t_last_start ) _stats->record( ST_PERIOD, t_start - t_last_start );
+		t_last_start = t_start;
+
+		const uint64_t js_expected = js_version + _decimation;
+		js_version = _js.read( q_in, dq_in, js_stamp );
+		update_kinematics( js_version, q_in, js_stamp );
+		//Event mode: a newer sample than the awaited one means that the previous cycle was late
+		if( _event_trigger && js_version > js_expected ) _stats->overrun();
+
+		//New frequency or ik iterations: applied from this cycle (no lock, no allocation)
+		update_config();
+		if( _freq != rate_freq ) {
+			rate_freq = _freq;
+			r = ros::Rate(rate_freq*4);
+			dt_rate = 1.0/(rate_freq*4);
+		}
+
+		//The integration step of the clik follows the measurements in event mode
+		dt = dt_rate;
+		if( _event_trigger && js_stamp > js_last_stamp ) dt = js_stamp - js_last_stamp;
+		js_last_stamp = js_stamp;
+
+		//Time along the trajectory
+		_t = _t + dt;
 
 		// Generate the goal position
-		//	Starting from the current position (_p_out) 
-		//		command the data with an offset
-		F_dest.p.data[0] = 0.3*cos(_t/(2*M_PI));
-		F_dest.p.data[1] = 0.3*sin(_t/(2*M_PI));
-		F_dest.p.data[2] = 1.0;
+		//	Streamed trajectory: setpoint at the time of the cycle, a new batch starts from the
+		//	last command. Joint setpoints need no ik, no trajectory yet holds the last command
+		bool joint_target = false;
+		if( _traj_in ) {
+			const iiwa_kdl::TrajectoryStream::Mode mode = _traj_in->update( ros::Time::now().toSec(), q_out.data.data(), _kin->tip() );
+			const iiwa_kdl::TrajectoryStream::Setpoint &sp = _traj_in->setpoint();
+			if( mode == iiwa_kdl::TrajectoryStream::CARTESIAN ) {
+				F_dest = sp.F;
+				V_dest = sp.V;
+			}
+			else {
+				joint_target = true;
+				if( mode == iiwa_kdl::TrajectoryStream::JOINT )
+					for(unsigned int i=0; i<_k_chain.getNrOfJoints(); i++) q_out(i) = sp.q[i];
+			}
+		}
+		else
+			circle_target( _t, F_dest, V_dest );
 
 		// std::cout << _p_out.p.x() << std::endl << _p_out.p.y() << std::endl << _p_out.p.z() << std::endl;
 
@@ -290,54 +683,149 @@ void KUKA_INVKIN::ctrl_loop() {
 		// 	F_dest.M.data[i] = _p_out.M.data[i];
 		// }
 
-		for(int i = 0; i < 9; i++){
-			if(i == 0 || i == 4 || i == 8){
-		 		F_dest.M.data[i] = 1;				
-		 	}else{
-		 		F_dest.M.data[i] = 0;
-		 	}
-
-		}
-
 		//CartToJnt: transform the desired cartesian position into joint values
-		if( _ik_solver_pos->CartToJnt(*_q_in, F_dest, q_out) != KDL::SolverI::E_NOERROR ) 
-			cout << "failing in ik!" << endl;
-
-		//Convert KDL output values into std_msgs::Float datatype
-		for(int i=0; i<7; i++) {
-			cmd[i].data = q_out.data[i];
+		t_stage = iiwa_kdl::CycleStats::now();
+		if( joint_target ) {
+			ik_status.data = KDL::SolverI::E_NOERROR;
 		}
-
-		//Publish all the commands in topics
-		for(int i=0; i<7; i++) {
-			_cmd_pub[i].publish (cmd[i]);
+		else if( _use_traj_cache ) {
+			//Precomputed trajectory: interpolation only, unless the robot is far from it
+			_traj_cache->sample( _t, q_out.data.data() );
+			ik_status.data = KDL::SolverI::E_NOERROR;
+			double divergence = 0.0;
+			for(unsigned int i=0; i<_k_chain.getNrOfJoints(); i++)
+				divergence = max( divergence, fabs( q_out(i) - q_in(i) ) );
+			if( divergence > _traj_divergence ) {
+				ik_status.data = _ik_solver_pos->CartToJnt(q_in, F_dest, q_out);
+				ROS_WARN_THROTTLE(1.0, "The robot diverged from the joint trajectory: using the numeric ik");
+			}
+		}
+		else if( _ik_solver_ws ) {
+			q_prev = q_out;
+			if( _ik_solver_ms ) _ik_solver_ms->setCurrent( q_in );
+			ik_status.data = _ik_solver_ws->CartToJnt(q_prev, F_dest, q_out);
+			if( ik_status.data != KDL::SolverI::E_NOERROR )
+				ROS_WARN_THROTTLE(1.0, "ik: %s", _ik_solver_ws->strError(ik_status.data));
+		}
+		else if( _ik_mode == "clik" ) {
+			//Closed loop inverse kinematics
+			//	dq = J^#(q) * ( V_dest + K*e ), q = q + dq*dt
+			//	e is the pose error of the commanded configuration: the integration drift is recovered
+			_fksolver->JntToCart(q_out, F_curr);
+			KDL::Twist e = KDL::diff(F_curr, F_dest);
+			KDL::Twist v( V_dest.vel + _clik_gain*e.vel, V_dest.rot + _clik_gain*e.rot );
+			ik_status.data = _ik_solver_vel->CartToJnt(q_out, v, dq_out);
+			if( ik_status.data >= 0 )
+				q_out.data += dq_out.data*dt;
+			else
+				ROS_WARN_THROTTLE(1.0, "failing in velocity ik!");
+		}
+		else if( KDL::Equal( _kin->tip(), F_dest, 1e-6 ) ) {
+			//The seed already reaches the target: the cached fk saves the NR solution
+			q_out = q_in;
+			ik_status.data = KDL::SolverI::E_NOERROR;
+		}
+		else {
+			ik_status.data = _ik_solver_pos->CartToJnt(q_in, F_dest, q_out);
+			if( ik_status.data != KDL::SolverI::E_NOERROR )
+				ROS_WARN_THROTTLE(1.0, "ik: %s", _ik_solver_pos->strError(ik_status.data));
+		}
+		if( _constraints ) {
+			const int valid = _constraints->check( q_out.data );
+			if( valid != KDL::SolverI::E_NOERROR ) {
+				ROS_WARN_THROTTLE(1.0, "ik: %s, holding the last command", _constraints->strError(valid));
+				ik_status.data = valid;
+				q_out = q_cmd;
+			}
+			q_cmd = q_out;
+		}
+		_stats->record( ST_IK, iiwa_kdl::CycleStats::now() - t_stage );
+		//Failures: negative codes and the results that did not converge (positive codes of the
+		//	rt solver). A fallback solution of srs and a singular velocity ik of clik are solutions
+		if( ik_status.data < 0 || ( ik_status.data != KDL::SolverI::E_NOERROR &&
+				ik_status.data != iiwa_kdl::ChainIkSolverPos_SRS::E_FALLBACK && _ik_mode != "clik" ) )
+			_stats->failure();
+
+		t_stage = iiwa_kdl::CycleStats::now();
+		if( _zero_copy ) {
+			const boost::shared_ptr<std_msgs::Int32> &m = _ik_status_pool.get();
+			m->data = ik_status.data;
+			_ik_status_pub.publish( m );
+		}
+		else
+			_ik_status_pub.publish( ik_status );
+
+		//Publish all the commands at once
+		_cmd_out.publish( q_out.data.data() );
+		_stats->record( ST_PUBLISH, iiwa_kdl::CycleStats::now() - t_stage );
+		_stats->record( ST_CYCLE, iiwa_kdl::CycleStats::now() - t_start );
+		_stats->record( ST_LATENCY, (int64_t)( ( ros::Time::now().toSec() - js_stamp )*1e9 ) );
+
+		if( _recorder.isOpen() ) {
+			rec.stamp = js_stamp;
+			rec.t_cmd = ros::Time::now().toSec();
+			memcpy( rec.q, q_in.data.data(), sizeof(rec.q) );
+			memcpy( rec.dq, dq_in.data.data(), sizeof(rec.dq) );
+			memcpy( rec.cmd, q_out.data.data(), sizeof(rec.cmd) );
+			rec.setPose( _kin->tip() );
+			rec.status = ik_status.data;
+			_recorder.write( rec );
 		}
 
-		r.sleep();
+		//Rate mode: sleep() returns false when the period has been exceeded
+		if( !_event_trigger && !r.sleep() ) _stats->overrun();
 
 	}
 }
 
 
-void KUKA_INVKIN::run() {
+//Multi-arm process
+//	~robots: names of the arms controlled by this process. Each arm reads its
+//	parameters from ~<name>/ and works in the namespace ~<name>/robot_namespace
+//	(default /<name>): joint_states, eef_pose, ik_status and the command topics.
+//	Without ~robots, a single arm with the private parameters in /lbr_iiwa.
+//	The arms with the same URDF share the parsed model and the joint trajectory
+//	table, each control loop runs on its own thread (~<name>/rt/ctrl/cpu to pin it)
+void KUKA_INVKIN::create_arms( const ros::NodeHandle &nh, const ros::NodeHandle &nh_priv,
+		iiwa_kdl::RobotModelRegistry &models, iiwa_kdl::StartSignal &start, std::vector<KUKA_INVKIN*> &arms ) {
 
-	//In the run method, we start the threads to:
-	//	- Calculate the forward kinematic
-	//	- Calculate the inverse kinematic 
-	boost::thread get_dirkin_t( &KUKA_INVKIN::get_dirkin, this);
-	boost::thread ctrl_loop_t ( &KUKA_INVKIN::ctrl_loop, this);
-	ros::spin();	
+	std::vector<std::string> robots;
+	nh_priv.getParam("robots", robots);
 
+	if( robots.empty() ) {
+		std::string ns;
+		nh_priv.param("robot_namespace", ns, std::string("/lbr_iiwa"));
+		arms.push_back( new KUKA_INVKIN( "kuka_invkin_ctrl", ros::NodeHandle( nh, ns ), nh_priv, models, start ) );
+	}
+	else {
+		for(size_t i=0; i<robots.size(); i++) {
+			ros::NodeHandle nh_cfg( nh_priv, robots[i] );
+			std::string ns;
+			nh_cfg.param("robot_namespace", ns, "/" + robots[i]);
+			arms.push_back( new KUKA_INVKIN( robots[i], ros::NodeHandle( nh, ns ), nh_cfg, models, start ) );
+		}
+		ROS_INFO("%zu arms, %zu robot models", arms.size(), models.size());
+	}
 }
 
 
+void KUKA_INVKIN::start() {
+	_running = true;
+	//Scheduling, affinity and stack prefault of the control thread: rt/ctrl of the arm
+	_ctrl_loop_t = boost::thread( iiwa_kdl::RtThreadFunction( iiwa_kdl::loadThreadRtConfig( _nh_cfg, "ctrl" ),
+			boost::bind( &KUKA_INVKIN::ctrl_loop, this ) ) );
+}
 
 
-int main(int argc, char** argv) {
-
-	ros::init(argc, argv, "iiwa_kdl");
-	KUKA_INVKIN ik;
-	ik.run();
-
-	return 0;
+void KUKA_INVKIN::stop() {
+	_running = false;
+	//The log is unmapped only when the control loop does not write anymore
+	//	Its waits time out and check _running: a loop still alive is in a long cycle
+	if( _ctrl_loop_t.joinable() && !_ctrl_loop_t.try_join_for( boost::chrono::seconds(1) ) ) {
+		ROS_ERROR("%s: the control loop is still running after 1 s, waiting for it", _name.c_str());
+		_ctrl_loop_t.join();
+	}
+	_recorder.close();
+	//Atomic counters: the summary can be read while the control thread is still running
+	_stats->dump( cout );
 }
@@ -0,0 +1,33 @@
+#include "iiwa_kdl/kuka_invkin_ctrl.h"
+#include "iiwa_kdl/rt_thread.h"
+
+//Standalone process of the controller: the topics go through TCPROS
+//	The nodelet version (iiwa_kdl/KukaInvKinNodelet) shares the messages in process
+int main(int argc, char** argv) {
+
+	ros::init(argc, argv, "iiwa_kdl");
+	ros::NodeHandle nh_priv("~");
+
+	//~start (std_srvs/Trigger) starts the trajectory execution of all the arms
+	//	~autostart = true: they start as soon as they are in the initial position
+	bool autostart;
+	nh_priv.param("autostart", autostart, false);
+	iiwa_kdl::StartSignal start;
+	start.init( nh_priv, autostart );
+
+	iiwa_kdl::RobotModelRegistry models;
+	std::vector<KUKA_INVKIN *> arms;
+	KUKA_INVKIN::create_arms( ros::NodeHandle(), nh_priv, models, start, arms );
+
+	//In the main thread we start the control thread of each arm:
+	//	- Calculate the inverse kinematic and publish the forward kinematic
+	//	The callbacks of all the arms run in the spinner (~rt/spinner)
+	iiwa_kdl::lockProcessMemory( nh_priv );
+	for(size_t i=0; i<arms.size(); i++) arms[i]->start();
+	iiwa_kdl::configureCurrentThread( iiwa_kdl::loadThreadRtConfig( nh_priv, "spinner" ) );
+	ros::spin();
+
+	for(size_t i=0; i<arms.size(); i++) arms[i]->stop();
+
+	return 0;
+}
@@ -0,0 +1,548 @@
+#include "ros/ros.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+//Include KDL libraries
+#include <kdl/chainfksolverpos_recursive.hpp>
+#include <kdl/chainjnttojacsolver.hpp>
+#include <kdl/chainiksolvervel_pinv.hpp>
+#include <kdl/chainiksolverpos_nr.hpp>
+#include <kdl/chaindynparam.hpp>
+#include <kdl_parser/kdl_parser.hpp>
+
+#include "iiwa_kdl/robot_model.h"
+#include "iiwa_kdl/joint_limits.h"
+#include "iiwa_kdl/model_cache.h"
+#include "iiwa_kdl/chainiksolverpos_rt.h"
+#include "iiwa_kdl/chainiksolverpos_multiseed.h"
+#include "iiwa_kdl/chainiksolverpos_srs.h"
+#include "iiwa_kdl/chainiksolvervel_dls.h"
+#include "iiwa_kdl/computed_torque_solver.h"
+#include "iiwa_kdl/batch_kinematics.h"
+#include "iiwa_kdl/iiwa_kernel.h"
+#include "iiwa_kdl/capsule_model.h"
+#include "iiwa_kdl/ik_constraints.h"
+
+using namespace std;
+
+//Offline benchmark of the kinematics and dynamics kernels on the iiwa model
+//	No simulator is needed: the chain is loaded from robot_description as in the
+//	control nodes (launch/kin_bench.launch). The results are printed on stdout,
+//	one JSON object per kernel and line:
+//	{"kernel":"fk_recursive","samples":1000,"ns_per_op":850.2,"p50_ns":812,"p99_ns":1530,"max_ns":9210}
+//	ik kernels add "success_rate" and, when the solver reports them, "iter_mean" and "iter_p99"
+//	The check of the fixed iiwa kernels against KDL is reported as
+//	{"kernel":"fixed_check","max_error":3.1e-15,"tolerance":1e-09,"match":true}
+//	The startup paths of the model (model_parse: URDF, model_cache: binary cache) are
+//	checked the same way, as model_cache_check
+//	capsule_update and ik_constraints_gradient time the self collision model of the ik
+
+
+static int64_t now_ns() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+
+//Timing samples and, for the ik kernels, outcome of each call
+struct BenchResult {
+	vector<int64_t> ns;
+	vector<unsigned int> iterations;
+	int success;
+	bool has_success;
+	//Number of ik problems, when a timing sample is not a single call
+	size_t trials;
+
+	BenchResult() : success(0), has_success(false), trials(0) {}
+};
+
+
+static void report( const string &kernel, BenchResult &res ) {
+	if( res.ns.empty() ) return;
+
+	double sum = 0.0;
+	for(size_t i=0; i<res.ns.size(); i++) sum += res.ns[i];
+	sort( res.ns.begin(), res.ns.end() );
+	const size_t n = res.ns.size();
+
+	printf("{\"kernel\":\"%s\",\"samples\":%zu,\"ns_per_op\":%.1f,\"p50_ns\":%lld,\"p99_ns\":%lld,\"max_ns\":%lld",
+		kernel.c_str(), n, sum/n, (long long)res.ns[ (n-1)/2 ], (long long)res.ns[ (size_t)( 0.99*(n-1) ) ], (long long)res.ns[n-1] );
+
+	if( res.has_success )
+		printf(",\"success_rate\":%.4f", (double)res.success / ( res.trials ? res.trials : n ));
+
+	if( !res.iterations.empty() ) {
+		double it = 0.0;
+		for(size_t i=0; i<res.iterations.size(); i++) it += res.iterations[i];
+		sort( res.iterations.begin(), res.iterations.end() );
+		printf(",\"iter_mean\":%.2f,\"iter_p99\":%u", it/res.iterations.size(),
+			res.iterations[ (size_t)( 0.99*(res.iterations.size()-1) ) ] );
+	}
+	printf("}\n");
+	fflush(stdout);
+}
+
+
+//Velocity ik of each seed of the multiseed solver
+static KDL::ChainIkSolverVel *new_ik_vel_pinv( const KDL::Chain &chain ) {
+	return new KDL::ChainIkSolverVel_pinv( chain );
+}
+
+
+//The solution is valid when its pose matches the target
+static bool pose_reached( KDL::ChainFkSolverPos &fk, const KDL::JntArray &q, const KDL::Frame &target, double tol ) {
+	KDL::Frame f;
+	if( fk.JntToCart( q, f ) < 0 ) return false;
+	const KDL::Twist e = KDL::diff( f, target );
+	return e.vel.Norm() < tol && e.rot.Norm() < tol;
+}
+
+
+class KUKA_KIN_BENCH {
+	public:
+		KUKA_KIN_BENCH();
+
+		//Load the model through the same path of the control nodes
+		bool init_robot_model();
+		//Run all the kernels and print the results
+		void run();
+
+	private:
+		void sample_configurations();
+
+		void bench_fk();
+		void bench_jac();
+		void bench_ik_pos( const string &kernel, KDL::ChainIkSolverPos &solver, iiwa_kdl::ChainIkSolverPos_RT *rt );
+		void bench_ik_vel( const string &kernel, KDL::ChainIkSolverVel &solver );
+		void bench_dyn();
+		void bench_batch();
+		void bench_fixed();
+		void bench_model_load();
+		void bench_constraints();
+
+		ros::NodeHandle _nh;
+		iiwa_kdl::RobotModel _model;
+		KDL::Chain _k_chain;
+		KDL::JntArray _q_min;
+		KDL::JntArray _q_max;
+		//Model cache written and loaded by bench_model_load
+		std::string _model_cache;
+		int _model_samples;
+
+		int _samples;
+		int _warmup;
+		int _seed;
+		//Distance of the ik seed from the target configuration (tracking-like warm start)
+		double _ik_seed_noise;
+		double _ik_tol;
+		//Workers of the batch kernels (0: one for each hardware thread)
+		int _batch_threads;
+
+		//Random configurations inside the joint limits, ik seeds and fk of the configurations
+		vector<KDL::JntArray> _q;
+		vector<KDL::JntArray> _q_seed;
+		vector<KDL::Frame> _f;
+
+		KDL::ChainFkSolverPos_recursive *_fksolver;
+};
+
+
+KUKA_KIN_BENCH::KUKA_KIN_BENCH() {
+	ros::NodeHandle nh_priv("~");
+	nh_priv.param("samples", _samples, 1000);
+	nh_priv.param("warmup", _warmup, 100);
+	nh_priv.param("seed", _seed, 1);
+	nh_priv.param("ik_seed_noise", _ik_seed_noise, 0.1);
+	nh_priv.param("ik_tol", _ik_tol, 1e-5);
+	nh_priv.param("batch_threads", _batch_threads, 0);
+	nh_priv.param("model_cache", _model_cache, std::string("/tmp/kuka_kin_bench.model"));
+	nh_priv.param("model_samples", _model_samples, 20);
+	if( _samples < 1 ) _samples = 1;
+	if( _warmup < 0 ) _warmup = 0;
+
+	if( !init_robot_model() ) exit(1);
+	sample_configurations();
+}
+
+
+bool KUKA_KIN_BENCH::init_robot_model() {
+	//No model cache: the kernels run on the chain parsed from the URDF
+	if( !iiwa_kdl::loadRobotModel( _nh, _model ) ) return false;
+	_k_chain = _model.chain;
+	_q_min = _model.q_min;
+	_q_max = _model.q_max;
+
+	_fksolver = new KDL::ChainFkSolverPos_recursive( _k_chain );
+	return true;
+}
+
+
+void KUKA_KIN_BENCH::sample_configurations() {
+	const unsigned int nj = _k_chain.getNrOfJoints();
+	std::mt19937 gen( _seed );
+	std::uniform_real_distribution<double> unif( 0.0, 1.0 );
+	std::uniform_real_distribution<double> noise( -_ik_seed_noise, _ik_seed_noise );
+
+	_q.assign( _samples, KDL::JntArray(nj) );
+	_q_seed.assign( _samples, KDL::JntArray(nj) );
+	_f.resize( _samples );
+
+	for(int s=0; s<_samples; s++) {
+		for(unsigned int i=0; i<nj; i++) {
+			//Continuous joints: one turn
+			const double lo = std::isfinite( _q_min(i) ) ? _q_min(i) : -M_PI;
+			const double hi = std::isfinite( _q_max(i) ) ? _q_max(i) : M_PI;
+			_q[s](i) = lo + unif(gen)*( hi - lo );
+			_q_seed[s](i) = std::min( hi, std::max( lo, _q[s](i) + noise(gen) ) );
+		}
+		_fksolver->JntToCart( _q[s], _f[s] );
+	}
+}
+
+
+void KUKA_KIN_BENCH::bench_fk() {
+	KDL::Frame f;
+	BenchResult res;
+	for(int s=0; s<_warmup; s++) _fksolver->JntToCart( _q[ s % _samples ], f );
+	for(int s=0; s<_samples; s++) {
+		const int64_t t0 = now_ns();
+		_fksolver->JntToCart( _q[s], f );
+		res.ns.push_back( now_ns() - t0 );
+	}
+	report( "fk_recursive", res );
+}
+
+
+void KUKA_KIN_BENCH::bench_jac() {
+	KDL::ChainJntToJacSolver jac_solver( _k_chain );
+	KDL::Jacobian J( _k_chain.getNrOfJoints() );
+	BenchResult res;
+	for(int s=0; s<_warmup; s++) jac_solver.JntToJac( _q[ s % _samples ], J );
+	for(int s=0; s<_samples; s++) {
+		const int64_t t0 = now_ns();
+		jac_solver.JntToJac( _q[s], J );
+		res.ns.push_back( now_ns() - t0 );
+	}
+	report( "jnt_to_jac", res );
+}
+
+
+void KUKA_KIN_BENCH::bench_ik_pos( const string &kernel, KDL::ChainIkSolverPos &solver, iiwa_kdl::ChainIkSolverPos_RT *rt ) {
+	KDL::JntArray q_out( _k_chain.getNrOfJoints() );
+	BenchResult res;
+	res.has_success = true;
+	for(int s=0; s<_warmup; s++) solver.CartToJnt( _q_seed[ s % _samples ], _f[ s % _samples ], q_out );
+	for(int s=0; s<_samples; s++) {
+		const int64_t t0 = now_ns();
+		const int ret = solver.CartToJnt( _q_seed[s], _f[s], q_out );
+		res.ns.push_back( now_ns() - t0 );
+
+		if( ret >= 0 && pose_reached( *_fksolver, q_out, _f[s], _ik_tol ) ) res.success++;
+		if( rt ) res.iterations.push_back( rt->getIterations() );
+	}
+	report( kernel, res );
+}
+
+
+void KUKA_KIN_BENCH::bench_ik_vel( const string &kernel, KDL::ChainIkSolverVel &solver ) {
+	KDL::JntArray dq_out( _k_chain.getNrOfJoints() );
+	//Same order of magnitude of the circle trajectory velocity
+	const KDL::Twist v( KDL::Vector( 0.05, -0.02, 0.01 ), KDL::Vector( 0.0, 0.1, 0.0 ) );
+	BenchResult res;
+	for(int s=0; s<_warmup; s++) solver.CartToJnt( _q[ s % _samples ], v, dq_out );
+	for(int s=0; s<_samples; s++) {
+		const int64_t t0 = now_ns();
+		solver.CartToJnt( _q[s], v, dq_out );
+		res.ns.push_back( now_ns() - t0 );
+	}
+	report( kernel, res );
+}
+
+
+void KUKA_KIN_BENCH::bench_dyn() {
+	const unsigned int nj = _k_chain.getNrOfJoints();
+	const KDL::Vector gravity( 0, 0, -9.81 );
+	KDL::ChainDynParam dyn_param( _k_chain, gravity );
+	KDL::JntSpaceInertiaMatrix M( nj );
+	KDL::JntArray coriol( nj ), grav( nj ), qdd_ref( nj ), tau( nj );
+
+	//The seed configurations are used as joint velocities
+	BenchResult mass, coriolis, gravity_res;
+	for(int s=0; s<_samples; s++) {
+		int64_t t0 = now_ns();
+		dyn_param.JntToMass( _q[s], M );
+		mass.ns.push_back( now_ns() - t0 );
+
+		t0 = now_ns();
+		dyn_param.JntToCoriolis( _q[s], _q_seed[s], coriol );
+		coriolis.ns.push_back( now_ns() - t0 );
+
+		t0 = now_ns();
+		dyn_param.JntToGravity( _q[s], grav );
+		gravity_res.ns.push_back( now_ns() - t0 );
+	}
+	report( "dyn_param_mass", mass );
+	report( "dyn_param_coriolis", coriolis );
+	report( "dyn_param_gravity", gravity_res );
+
+	//Computed torque engines: tau = M*qdd_ref + C*dq + g
+	const iiwa_kdl::ComputedTorqueSolver::Engine engines[3] = { iiwa_kdl::ComputedTorqueSolver::RNE,
+		iiwa_kdl::ComputedTorqueSolver::DYN_PARAM, iiwa_kdl::ComputedTorqueSolver::FIXED };
+	const char *names[3] = { "computed_torque_rne", "computed_torque_dyn_param", "computed_torque_fixed" };
+	for(int e=0; e<3; e++) {
+		iiwa_kdl::ComputedTorqueSolver ct( _k_chain, gravity, engines[e] );
+		//No fixed kernel for this chain
+		if( ct.engine() != engines[e] ) continue;
+		BenchResult res;
+		for(int s=0; s<_warmup; s++) ct.compute( _q[ s % _samples ], _q_seed[ s % _samples ], qdd_ref, tau );
+		for(int s=0; s<_samples; s++) {
+			for(unsigned int i=0; i<nj; i++) qdd_ref(i) = _q_seed[s](i) - _q[s](i);
+			const int64_t t0 = now_ns();
+			ct.compute( _q[s], _q_seed[s], qdd_ref, tau );
+			res.ns.push_back( now_ns() - t0 );
+		}
+		report( names[e], res );
+	}
+}
+
+
+//Batch kernels: each timing sample is a whole batch call, reported per configuration
+void KUKA_KIN_BENCH::bench_batch() {
+	iiwa_kdl::BatchKinematics batch( _k_chain, _batch_threads );
+	if( !batch.valid() ) {
+		ROS_WARN("Unsupported joints in the kinematic chain: skipping the batch kernels");
+		return;
+	}
+
+	iiwa_kdl::JointBatch q( _k_chain.getNrOfJoints(), _samples );
+	iiwa_kdl::PoseBatch f( _samples );
+	for(int s=0; s<_samples; s++) q.set( s, _q[s] );
+
+	const int runs = 20;
+	BenchResult fk;
+	batch.fk( q, f );
+	for(int r=0; r<runs; r++) {
+		const int64_t t0 = now_ns();
+		batch.fk( q, f );
+		fk.ns.push_back( ( now_ns() - t0 )/_samples );
+	}
+	report( "fk_batch", fk );
+
+	//ik chain on a path: joint space line between two random configurations
+	const unsigned int nj = _k_chain.getNrOfJoints();
+	KDL::JntArray q_s( nj );
+	for(int s=0; s<_samples; s++) {
+		const double a = _samples > 1 ? (double)s/( _samples - 1 ) : 0.0;
+		for(unsigned int i=0; i<nj; i++) q_s(i) = ( 1.0 - a )*_q[0](i) + a*_q[ _samples - 1 ](i);
+		q.set( s, q_s );
+	}
+	batch.fk( q, f );
+
+	iiwa_kdl::JointBatch q_out;
+	BenchResult ik;
+	ik.has_success = true;
+	const int64_t t0 = now_ns();
+	ik.success = batch.ik( f, _q[0], q_out );
+	ik.ns.push_back( ( now_ns() - t0 )/_samples );
+	ik.trials = _samples;
+	report( "ik_batch_path", ik );
+}
+
+
+//Generated iiwa kernels: accuracy against KDL, then fk and jacobian timings
+void KUKA_KIN_BENCH::bench_fixed() {
+	iiwa_kdl::IiwaKernel kernel;
+	const double err = kernel.compare( _k_chain, _samples, _seed );
+	printf("{\"kernel\":\"fixed_check\",\"max_error\":%.3g,\"tolerance\":%.3g,\"match\":%s}\n",
+		err, iiwa_kdl::IIWA_KERNEL_TOLERANCE, err <= iiwa_kdl::IIWA_KERNEL_TOLERANCE ? "true" : "false");
+	fflush(stdout);
+	if( err > iiwa_kdl::IIWA_KERNEL_TOLERANCE ) {
+		ROS_WARN("The fixed iiwa kernel does not match the robot description: skipping its timings");
+		return;
+	}
+
+	vector<iiwa_kdl::Vector7d> q( _samples );
+	for(int s=0; s<_samples; s++) q[s] = _q[s].data;
+
+	KDL::Frame f;
+	BenchResult fk;
+	for(int s=0; s<_warmup; s++) kernel.fk( q[ s % _samples ], f );
+	for(int s=0; s<_samples; s++) {
+		const int64_t t0 = now_ns();
+		kernel.fk( q[s], f );
+		fk.ns.push_back( now_ns() - t0 );
+	}
+	report( "fk_fixed", fk );
+
+	iiwa_kdl::Jacobian7d J;
+	BenchResult jac;
+	for(int s=0; s<_warmup; s++) kernel.jacobian( q[ s % _samples ], J );
+	for(int s=0; s<_samples; s++) {
+		const int64_t t0 = now_ns();
+		kernel.jacobian( q[s], J );
+		jac.ns.push_back( now_ns() - t0 );
+	}
+	report( "jac_fixed", jac );
+}
+
+
+void KUKA_KIN_BENCH::bench_model_load() {
+	const uint64_t hash = iiwa_kdl::modelHash( _model.robot_description, _model.base_link, _model.tip_link );
+	if( _model_cache.empty() || !iiwa_kdl::saveModelCache( _model_cache, hash, _k_chain, _q_min, _q_max ) ) {
+		ROS_WARN("Cannot write the model cache %s: skipping the model load timings", _model_cache.c_str());
+		return;
+	}
+
+	//URDF path of the control nodes without cache: kdl tree, chain and joint limits
+	BenchResult parse;
+	for(int s=0; s<_model_samples; s++) {
+		KDL::Tree tree;
+		KDL::Chain chain;
+		KDL::JntArray q_min, q_max;
+		const int64_t t0 = now_ns();
+		kdl_parser::treeFromString( _model.robot_description, tree );
+		tree.getChain( _model.base_link, _model.tip_link, chain );
+		iiwa_kdl::jointLimitsFromUrdf( _model.robot_description, chain, q_min, q_max );
+		parse.ns.push_back( now_ns() - t0 );
+	}
+	report( "model_parse", parse );
+
+	//The hash of the URDF is part of the cache path
+	BenchResult cache;
+	KDL::Chain chain;
+	KDL::JntArray q_min, q_max;
+	for(int s=0; s<_model_samples; s++) {
+		const int64_t t0 = now_ns();
+		iiwa_kdl::modelHash( _model.robot_description, _model.base_link, _model.tip_link );
+		iiwa_kdl::loadModelCache( _model_cache, hash, chain, q_min, q_max );
+		cache.ns.push_back( now_ns() - t0 );
+	}
+	report( "model_cache", cache );
+
+	//Same fk, jacobian and dynamics of the parsed chain
+	double err = std::numeric_limits<double>::infinity();
+	if( chain.getNrOfJoints() == _k_chain.getNrOfJoints() && chain.getNrOfSegments() == _k_chain.getNrOfSegments() ) {
+		const unsigned int nj = chain.getNrOfJoints();
+		KDL::ChainFkSolverPos_recursive fk( chain );
+		KDL::ChainJntToJacSolver jac( chain ), jac_ref( _k_chain );
+		KDL::ChainDynParam dyn( chain, KDL::Vector( 0, 0, -9.81 ) ), dyn_ref( _k_chain, KDL::Vector( 0, 0, -9.81 ) );
+		KDL::Frame f;
+		KDL::Jacobian J( nj ), J_ref( nj );
+		KDL::JntSpaceInertiaMatrix M( nj ), M_ref( nj );
+		err = max( ( q_min.data - _q_min.data ).cwiseAbs().maxCoeff(), ( q_max.data - _q_max.data ).cwiseAbs().maxCoeff() );
+		for(int s=0; s<_samples; s++) {
+			fk.JntToCart( _q[s], f );
+			jac.JntToJac( _q[s], J );
+			jac_ref.JntToJac( _q[s], J_ref );
+			dyn.JntToMass( _q[s], M );
+			dyn_ref.JntToMass( _q[s], M_ref );
+			for(int k=0; k<9; k++) err = max( err, fabs( f.M.data[k] - _f[s].M.data[k] ) );
+			for(int k=0; k<3; k++) err = max( err, fabs( f.p.data[k] - _f[s].p.data[k] ) );
+			err = max( err, ( J.data - J_ref.data ).cwiseAbs().maxCoeff() );
+			err = max( err, ( M.data - M_ref.data ).cwiseAbs().maxCoeff() );
+		}
+	}
+	printf("{\"kernel\":\"model_cache_check\",\"max_error\":%.3g,\"tolerance\":%.3g,\"match\":%s}\n",
+		err, iiwa_kdl::IIWA_KERNEL_TOLERANCE, err <= iiwa_kdl::IIWA_KERNEL_TOLERANCE ? "true" : "false");
+	fflush(stdout);
+}
+
+
+//Capsule distances of all the link pairs, gradient of the constraint cost and the rt ik with it
+void KUKA_KIN_BENCH::bench_constraints() {
+	iiwa_kdl::IkConstraints constraints( _k_chain, _q_min, _q_max );
+	if( !constraints.collisionModel() ) {
+		ROS_WARN("The kinematic chain does not match the capsule model: skipping the constraint timings");
+		return;
+	}
+
+	vector<iiwa_kdl::Vector7d> q( _samples );
+	for(int s=0; s<_samples; s++) q[s] = _q[s].data;
+
+	iiwa_kdl::CapsuleModel capsules( _k_chain );
+	BenchResult update;
+	for(int s=0; s<_warmup; s++) capsules.update( q[ s % _samples ] );
+	for(int s=0; s<_samples; s++) {
+		const int64_t t0 = now_ns();
+		capsules.update( q[s] );
+		update.ns.push_back( now_ns() - t0 );
+	}
+	report( "capsule_update", update );
+
+	//Activation larger than the arm: every pair contributes to the gradient
+	constraints.setCollisionCost( 10.0, 1.0 );
+	iiwa_kdl::Vector7d grad;
+	BenchResult gradient;
+	for(int s=0; s<_warmup; s++) constraints.gradient( q[ s % _samples ], grad );
+	for(int s=0; s<_samples; s++) {
+		const int64_t t0 = now_ns();
+		constraints.gradient( q[s], grad );
+		gradient.ns.push_back( now_ns() - t0 );
+	}
+	report( "ik_constraints_gradient", gradient );
+
+	//Default settings of the control node
+	constraints.setCollisionCost( 0.03, 10.0 );
+	iiwa_kdl::ChainIkSolverVel_DLS ik_dls( _k_chain );
+	ik_dls.setNullspaceObjective( &constraints, 1.0 );
+	iiwa_kdl::ChainIkSolverPos_RT ik_rt( _k_chain, *_fksolver, ik_dls, 100, 1e-6, 1e-9, 0.0 );
+	bench_ik_pos( "ik_rt_dls_constraints", ik_rt, &ik_rt );
+}
+
+
+void KUKA_KIN_BENCH::run() {
+	bench_fk();
+	bench_jac();
+
+	KDL::ChainIkSolverVel_pinv ik_pinv( _k_chain );
+	iiwa_kdl::ChainIkSolverVel_DLS ik_dls( _k_chain );
+	bench_ik_vel( "ik_vel_pinv", ik_pinv );
+	bench_ik_vel( "ik_vel_dls", ik_dls );
+
+	//Same settings of the control node
+	KDL::ChainIkSolverPos_NR ik_nr( _k_chain, *_fksolver, ik_pinv, 100, 1e-6 );
+	bench_ik_pos( "ik_nr", ik_nr, 0 );
+
+	iiwa_kdl::ChainIkSolverPos_RT ik_rt( _k_chain, *_fksolver, ik_pinv, 100, 1e-6, 1e-9, 0.0 );
+	bench_ik_pos( "ik_rt", ik_rt, &ik_rt );
+
+	iiwa_kdl::ChainIkSolverPos_RT ik_rt_dls( _k_chain, *_fksolver, ik_dls, 100, 1e-6, 1e-9, 0.0 );
+	bench_ik_pos( "ik_rt_dls", ik_rt_dls, &ik_rt_dls );
+
+	//Seeds of the control node: the sample seed is both the current and the previous joints
+	iiwa_kdl::ChainIkSolverPos_MultiSeed ik_ms( _k_chain, _q_min, _q_max, new_ik_vel_pinv, 4, 100, 1e-6, 0.0, _seed );
+	bench_ik_pos( "ik_multiseed", ik_ms, 0 );
+
+	//Closed form solver only: no fallback, the success rate is the one of the analytic solution
+	iiwa_kdl::ChainIkSolverPos_SRS ik_srs( _k_chain, _q_min, _q_max, 0, iiwa_kdl::ChainIkSolverPos_SRS::KEEP_CURRENT );
+	if( ik_srs.geometryValid() ) {
+		bench_ik_pos( "ik_srs_keep", ik_srs, 0 );
+		ik_srs.setArmAnglePolicy( iiwa_kdl::ChainIkSolverPos_SRS::MIN_CHANGE );
+		bench_ik_pos( "ik_srs_min_change", ik_srs, 0 );
+	}
+	else
+		ROS_WARN("The kinematic chain is not a SRS arm: skipping the analytic ik");
+
+	bench_dyn();
+	bench_batch();
+	bench_fixed();
+	bench_model_load();
+	bench_constraints();
+}
+
+
+int main(int argc, char** argv) {
+
+	ros::init(argc, argv, "kuka_kin_bench");
+	KUKA_KIN_BENCH bench;
+	bench.run();
+
+	return 0;
+}
@@ -0,0 +1,183 @@
+#include "iiwa_kdl/model_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace iiwa_kdl {
+
+//File header, followed by the segments and the joint limits (doubles)
+static const char MODEL_MAGIC[8] = { 'I', 'I', 'W', 'A', 'K', 'D', 'L', '1' };
+//Bound of the header counts: a corrupted file is rejected before anything is read
+static const uint32_t MAX_SEGMENTS = 1024;
+
+struct ModelFileHeader {
+	char magic[8];
+	uint64_t hash;
+	uint32_t n_segments;
+	uint32_t n_joints;
+};
+
+//Fixed size part of a segment, followed by the segment and joint names
+struct SegmentRecord {
+	int32_t joint_type;
+	uint32_t name_size;
+	uint32_t joint_name_size;
+	uint32_t pad;
+	double origin[3];
+	double axis[3];
+	//Frame to the tip at q = 0: rotation (row major) and position
+	double f_tip[12];
+	//Mass, center of mass and rotational inertia about the center of mass
+	double mass;
+	double cog[3];
+	double inertia[9];
+};
+
+
+uint64_t modelHash( const std::string &robot_description, const std::string &base_link, const std::string &tip_link ) {
+	uint64_t h = 14695981039346656037ULL;
+	const std::string *parts[3] = { &robot_description, &base_link, &tip_link };
+	for(int k=0; k<3; k++) {
+		const std::string &s = *parts[k];
+		for(size_t i=0; i<s.size(); i++) {
+			h ^= (unsigned char)s[i];
+			h *= 1099511628211ULL;
+		}
+		//Separator: ("ab", "c") and ("a", "bc") differ
+		h ^= 0xff;
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+
+bool saveModelCache( const std::string &file, uint64_t hash, const KDL::Chain &chain,
+		const KDL::JntArray &q_min, const KDL::JntArray &q_max ) {
+
+	const unsigned int nj = chain.getNrOfJoints();
+	if( q_min.rows() != nj || q_max.rows() != nj ) return false;
+
+	//Write a temporary file, then rename: the other nodes never read a partial cache
+	const std::string tmp = file + ".tmp";
+	FILE *f = fopen( tmp.c_str(), "wb" );
+	if( !f ) return false;
+
+	ModelFileHeader hdr;
+	memcpy( hdr.magic, MODEL_MAGIC, sizeof(MODEL_MAGIC) );
+	hdr.hash = hash;
+	hdr.n_segments = chain.getNrOfSegments();
+	hdr.n_joints = nj;
+	bool ok = fwrite( &hdr, sizeof(hdr), 1, f ) == 1;
+
+	for(unsigned int s=0; ok && s<chain.getNrOfSegments(); s++) {
+		const KDL::Segment &seg = chain.getSegment(s);
+		const KDL::Joint &joint = seg.getJoint();
+		const KDL::Frame f_tip = seg.getFrameToTip();
+		const KDL::RigidBodyInertia &I = seg.getInertia();
+
+		SegmentRecord rec;
+		memset( &rec, 0, sizeof(rec) );
+		rec.joint_type = joint.getType();
+		rec.name_size = seg.getName().size();
+		rec.joint_name_size = joint.getName().size();
+		const KDL::Vector origin = joint.JointOrigin();
+		const KDL::Vector axis = joint.JointAxis();
+		for(int k=0; k<3; k++) {
+			rec.origin[k] = origin(k);
+			rec.axis[k] = axis(k);
+		}
+		memcpy( rec.f_tip, f_tip.M.data, 9*sizeof(double) );
+		memcpy( rec.f_tip + 9, f_tip.p.data, 3*sizeof(double) );
+
+		//KDL keeps the rotational inertia about the segment frame: store the one about the
+		//	center of mass, the argument of the RigidBodyInertia constructor
+		const double m = I.getMass();
+		const KDL::Vector c = I.getCOG();
+		const KDL::RotationalInertia Io = I.getRotationalInertia();
+		const double cc = KDL::dot( c, c );
+		rec.mass = m;
+		for(int i=0; i<3; i++) {
+			rec.cog[i] = c(i);
+			for(int j=0; j<3; j++)
+				rec.inertia[3*i + j] = Io.data[3*i + j] - m*( ( i == j ? cc : 0.0 ) - c(i)*c(j) );
+		}
+
+		ok = fwrite( &rec, sizeof(rec), 1, f ) == 1 &&
+			fwrite( seg.getName().data(), 1, rec.name_size, f ) == rec.name_size &&
+			fwrite( joint.getName().data(), 1, rec.joint_name_size, f ) == rec.joint_name_size;
+	}
+
+	if( ok ) ok = fwrite( q_min.data.data(), sizeof(double), nj, f ) == nj &&
+		fwrite( q_max.data.data(), sizeof(double), nj, f ) == nj;
+
+	ok = fclose( f ) == 0 && ok;
+	if( ok ) ok = rename( tmp.c_str(), file.c_str() ) == 0;
+	if( !ok ) remove( tmp.c_str() );
+	return ok;
+}
+
+
+static bool readString( FILE *f, uint32_t size, std::string &s ) {
+	if( size > 4096 ) return false;
+	std::vector<char> buf( size );
+	if( size && fread( &buf[0], 1, size, f ) != size ) return false;
+	s.assign( buf.begin(), buf.end() );
+	return true;
+}
+
+
+bool loadModelCache( const std::string &file, uint64_t hash, KDL::Chain &chain,
+		KDL::JntArray &q_min, KDL::JntArray &q_max ) {
+
+	FILE *f = fopen( file.c_str(), "rb" );
+	if( !f ) return false;
+
+	ModelFileHeader hdr;
+	bool ok = fread( &hdr, sizeof(hdr), 1, f ) == 1 && memcmp( hdr.magic, MODEL_MAGIC, sizeof(MODEL_MAGIC) ) == 0 &&
+		( hash == 0 || hdr.hash == hash ) && hdr.n_segments <= MAX_SEGMENTS && hdr.n_joints <= hdr.n_segments;
+
+	KDL::Chain c;
+	for(uint32_t s=0; ok && s<hdr.n_segments; s++) {
+		SegmentRecord rec;
+		std::string name, joint_name;
+		ok = fread( &rec, sizeof(rec), 1, f ) == 1 &&
+			readString( f, rec.name_size, name ) && readString( f, rec.joint_name_size, joint_name );
+		if( !ok ) break;
+
+		const KDL::Joint::JointType type = (KDL::Joint::JointType)rec.joint_type;
+		KDL::Joint joint = ( type == KDL::Joint::RotAxis || type == KDL::Joint::TransAxis ) ?
+			KDL::Joint( joint_name, KDL::Vector( rec.origin[0], rec.origin[1], rec.origin[2] ),
+				KDL::Vector( rec.axis[0], rec.axis[1], rec.axis[2] ), type ) :
+			KDL::Joint( joint_name, type );
+
+		KDL::Frame f_tip;
+		memcpy( f_tip.M.data, rec.f_tip, 9*sizeof(double) );
+		memcpy( f_tip.p.data, rec.f_tip + 9, 3*sizeof(double) );
+
+		KDL::RotationalInertia Ic;
+		memcpy( Ic.data, rec.inertia, 9*sizeof(double) );
+		const KDL::RigidBodyInertia I( rec.mass, KDL::Vector( rec.cog[0], rec.cog[1], rec.cog[2] ), Ic );
+
+		c.addSegment( KDL::Segment( name, joint, f_tip, I ) );
+	}
+
+	//The limits are sized only once the segments are read and match the header
+	ok = ok && c.getNrOfJoints() == hdr.n_joints;
+	KDL::JntArray lo, hi;
+	if( ok ) {
+		lo.resize( hdr.n_joints );
+		hi.resize( hdr.n_joints );
+		ok = fread( lo.data.data(), sizeof(double), hdr.n_joints, f ) == hdr.n_joints &&
+			fread( hi.data.data(), sizeof(double), hdr.n_joints, f ) == hdr.n_joints;
+	}
+	fclose( f );
+	if( !ok ) return false;
+
+	chain = c;
+	q_min = lo;
+	q_max = hi;
+	return true;
+}
+
+}
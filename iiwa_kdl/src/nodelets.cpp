@@ -0,0 +1,72 @@
+#include <vector>
+
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include "iiwa_kdl/kuka_invkin_ctrl.h"
+#include "iiwa_kdl/kuka_invdyn_ctrl.h"
+#include "iiwa_kdl/rt_thread.h"
+
+namespace iiwa_kdl {
+
+//Controllers loaded in a nodelet manager (launch/iiwa_nodelets.launch)
+//	The subscriptions run on the multi-threaded queue of the manager, the control loops keep
+//	their own threads (rt/ctrl). With zero_copy = true the published messages reach the
+//	nodelets of the same manager as shared pointers, without serialization.
+//	The private parameters are the ones of the executables
+
+//kuka_invkin_ctrl: one or more arms (~robots), started by ~start or ~autostart
+class KukaInvKinNodelet : public nodelet::Nodelet {
+	public:
+		virtual ~KukaInvKinNodelet() {
+			for(size_t i=0; i<_arms.size(); i++) {
+				_arms[i]->stop();
+				delete _arms[i];
+			}
+		}
+
+	private:
+		virtual void onInit() {
+			ros::NodeHandle &nh_priv = getMTPrivateNodeHandle();
+
+			bool autostart;
+			nh_priv.param("autostart", autostart, false);
+			_start.init( nh_priv, autostart );
+
+			KUKA_INVKIN::create_arms( getMTNodeHandle(), nh_priv, _models, _start, _arms );
+			iiwa_kdl::lockProcessMemory( nh_priv );
+			for(size_t i=0; i<_arms.size(); i++) _arms[i]->start();
+			NODELET_INFO("%zu arms started", _arms.size());
+		}
+
+		iiwa_kdl::RobotModelRegistry _models;
+		iiwa_kdl::StartSignal _start;
+		std::vector<KUKA_INVKIN *> _arms;
+};
+
+
+//kuka_invdyn_ctrl: computed torque of the /lbr_iiwa arm
+class KukaInvDynNodelet : public nodelet::Nodelet {
+	public:
+		KukaInvDynNodelet() : _ctrl( 0 ) {}
+
+		virtual ~KukaInvDynNodelet() {
+			if( !_ctrl ) return;
+			_ctrl->stop();
+			delete _ctrl;
+		}
+
+	private:
+		virtual void onInit() {
+			_ctrl = new KUKA_INVDYN( getMTNodeHandle(), getMTPrivateNodeHandle() );
+			iiwa_kdl::lockProcessMemory( getMTPrivateNodeHandle() );
+			_ctrl->start();
+		}
+
+		KUKA_INVDYN *_ctrl;
+};
+
+}
+
+PLUGINLIB_EXPORT_CLASS( iiwa_kdl::KukaInvKinNodelet, nodelet::Nodelet )
+PLUGINLIB_EXPORT_CLASS( iiwa_kdl::KukaInvDynNodelet, nodelet::Nodelet )
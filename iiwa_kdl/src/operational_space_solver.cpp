@@ -0,0 +1,113 @@
+#include "iiwa_kdl/operational_space_solver.h"
+#include "iiwa_kdl/param_utils.h"
+
+#include <math.h>
+
+namespace iiwa_kdl {
+
+//Step of the directional derivative of the jacobian (s)
+static const double JDOT_STEP = 1e-3;
+
+OperationalSpaceSolver::OperationalSpaceSolver( const KDL::Chain &chain, const KDL::Vector &gravity ) :
+	_nj( chain.getNrOfJoints() ),
+	_fksolver( chain ),
+	_jac_solver( chain ),
+	_dyn_param( chain, gravity ),
+	_M( chain.getNrOfJoints() ),
+	_J_kdl( chain.getNrOfJoints() ),
+	_q_h( chain.getNrOfJoints() ) {
+
+	_gains.kp << 400.0, 400.0, 400.0, 200.0, 200.0, 200.0;
+	for(int i=0; i<6; i++) _gains.kd(i) = 2.0*sqrt( _gains.kp(i) );
+	_gains.kp_null.setConstant( 20.0 );
+	_gains.kd_null.setConstant( 2.0*sqrt( 20.0 ) );
+	_gains.damping = 1e-4;
+	_lambda.setZero();
+}
+
+
+int OperationalSpaceSolver::compute( const KDL::JntArray &q, const KDL::JntArray &dq, const KDL::Frame &F_des,
+		const KDL::Twist &V_des, const KDL::Twist &A_des, const double *q_null, KDL::JntArray &qdd_ref ) {
+
+	if( _nj != IIWA_NJ ) return E_NOT_IIWA;
+
+	int ret;
+	if( (ret = _fksolver.JntToCart( q, _F )) < 0 ) return ret;
+	if( (ret = _jac_solver.JntToJac( q, _J_kdl )) < 0 ) return ret;
+	_J = _J_kdl.data;
+
+	//dJ*dq = ( J(q + h*dq) - J(q) )*dq/h
+	_q_h.data = q.data + JDOT_STEP*dq.data;
+	if( (ret = _jac_solver.JntToJac( _q_h, _J_kdl )) < 0 ) return ret;
+	_J_h = _J_kdl.data;
+
+	//One factorization of M for each cycle: M^-1 J^T by substitution
+	if( (ret = _dyn_param.JntToMass( q, _M )) < 0 ) return ret;
+	_M_ldlt.compute( _M.data );
+	if( _M_ldlt.info() != Eigen::Success ) return KDL::SolverI::E_UNDEFINED;
+	_MinvJt = _M_ldlt.solve( _J.transpose() );
+
+	//Lambda = (J M^-1 J^T)^-1, damped close to singularities
+	Matrix6d lambda_inv = _J*_MinvJt;
+	lambda_inv.diagonal().array() += _gains.damping;
+	_lambda_ldlt.compute( lambda_inv );
+	_lambda = _lambda_ldlt.solve( Matrix6d::Identity() );
+	_Jbar.noalias() = _MinvJt*_lambda;
+
+	Eigen::Map<const Vector7d> q_e( q.data.data() );
+	Eigen::Map<const Vector7d> dq_e( dq.data.data() );
+	Eigen::Map<const Vector7d> q_n( q_null );
+
+	//Pose error (linear, rotation vector) and velocity of the tip, base frame
+	const KDL::Twist e_kdl = KDL::diff( _F, F_des );
+	Vector6d e, v_des, a_des;
+	for(int i=0; i<6; i++) {
+		e(i) = e_kdl(i);
+		v_des(i) = V_des(i);
+		a_des(i) = A_des(i);
+	}
+	const Vector6d v = _J*dq_e;
+	const Vector6d jdot_dq = ( _J_h - _J )*dq_e/JDOT_STEP;
+
+	Vector6d a = a_des - jdot_dq;
+	a.array() += _gains.kd.array()*( v_des - v ).array() + _gains.kp.array()*e.array();
+
+	Vector7d a0 = ( _gains.kp_null.array()*( q_n - q_e ).array() - _gains.kd_null.array()*dq_e.array() ).matrix();
+
+	//qdd_ref = Jbar*a + (I - Jbar*J)*a0
+	Eigen::Map<Vector7d> qdd( qdd_ref.data.data() );
+	qdd.noalias() = _Jbar*a;
+	qdd.noalias() += a0;
+	qdd.noalias() -= _Jbar*( _J*a0 );
+
+	return KDL::SolverI::E_NOERROR;
+}
+
+
+void loadOscGains( const ros::NodeHandle &nh, OperationalSpaceSolver::Gains &gains ) {
+	double kp_t, kp_r, kd_t, kd_r;
+	nh.param( "osc/kp_translation", kp_t, gains.kp(0) );
+	nh.param( "osc/kp_rotation", kp_r, gains.kp(3) );
+	nh.param( "osc/kd_translation", kd_t, 2.0*sqrt( kp_t ) );
+	nh.param( "osc/kd_rotation", kd_r, 2.0*sqrt( kp_r ) );
+	for(int i=0; i<3; i++) {
+		gains.kp(i) = kp_t;
+		gains.kp(3+i) = kp_r;
+		gains.kd(i) = kd_t;
+		gains.kd(3+i) = kd_r;
+	}
+
+	double kp_null[IIWA_NJ], kd_null[IIWA_NJ];
+	for(unsigned int i=0; i<IIWA_NJ; i++) kp_null[i] = gains.kp_null(i);
+	loadJointParam( nh, "osc/kp_null", kp_null );
+	for(unsigned int i=0; i<IIWA_NJ; i++) kd_null[i] = 2.0*sqrt( kp_null[i] );
+	loadJointParam( nh, "osc/kd_null", kd_null );
+	for(unsigned int i=0; i<IIWA_NJ; i++) {
+		gains.kp_null(i) = kp_null[i];
+		gains.kd_null(i) = kd_null[i];
+	}
+
+	nh.param( "osc/damping", gains.damping, gains.damping );
+}
+
+}
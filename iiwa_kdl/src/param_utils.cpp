@@ -0,0 +1,25 @@
+#include "iiwa_kdl/param_utils.h"
+
+#include <vector>
+
+namespace iiwa_kdl {
+
+bool loadJointParam( const ros::NodeHandle &nh, const std::string &name, double *values ) {
+	std::vector<double> list;
+	double value;
+	if( nh.getParam( name, list ) ) {
+		if( list.size() != IIWA_NJ ) {
+			ROS_WARN("%s: %d values instead of %d, using the defaults", name.c_str(), (int)list.size(), (int)IIWA_NJ);
+			return false;
+		}
+		for(unsigned int i=0; i<IIWA_NJ; i++) values[i] = list[i];
+		return true;
+	}
+	if( nh.getParam( name, value ) ) {
+		for(unsigned int i=0; i<IIWA_NJ; i++) values[i] = value;
+		return true;
+	}
+	return false;
+}
+
+}
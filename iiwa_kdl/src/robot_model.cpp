@@ -0,0 +1,113 @@
+#include "iiwa_kdl/robot_model.h"
+
+#include <kdl_parser/kdl_parser.hpp>
+
+#include "iiwa_kdl/joint_limits.h"
+#include "iiwa_kdl/model_cache.h"
+
+namespace iiwa_kdl {
+
+//robot_description of the namespace of nh, false if there is none
+static bool robotDescription( const ros::NodeHandle &nh, std::string &urdf ) {
+	std::string key;
+	if( !nh.searchParam( "robot_description", key ) ) key = "robot_description";
+	return nh.getParam( key, urdf ) && !urdf.empty();
+}
+
+
+//Fill model from the cache or from the URDF (model.robot_description, empty if not available)
+static bool buildRobotModel( RobotModel &model, const std::string &model_cache ) {
+
+	if( model.robot_description.empty() ) {
+		if( model_cache.empty() || !loadModelCache( model_cache, 0, model.chain, model.q_min, model.q_max ) ) {
+			ROS_ERROR("No robot_description and no model cache to load");
+			return false;
+		}
+		ROS_WARN("No robot_description: using the model cache %s without checking it", model_cache.c_str());
+		return true;
+	}
+
+	const uint64_t hash = modelHash( model.robot_description, model.base_link, model.tip_link );
+	if( !model_cache.empty() && loadModelCache( model_cache, hash, model.chain, model.q_min, model.q_max ) ) {
+		ROS_INFO("Robot model loaded from the cache %s", model_cache.c_str());
+		return true;
+	}
+
+	//Use the treeFromString function to convert the robot model into a kinematic tree
+	if( !kdl_parser::treeFromString( model.robot_description, model.tree ) ) {
+		ROS_ERROR("Failed to construct kdl tree");
+		return false;
+	}
+	if( !model.tree.getChain( model.base_link, model.tip_link, model.chain ) ) {
+		ROS_ERROR("Failed to extract the chain %s -> %s", model.base_link.c_str(), model.tip_link.c_str());
+		return false;
+	}
+	if( !jointLimitsFromUrdf( model.robot_description, model.chain, model.q_min, model.q_max ) ) {
+		ROS_ERROR("Failed to read the joint limits from the robot description");
+		return false;
+	}
+
+	if( !model_cache.empty() ) {
+		if( saveModelCache( model_cache, hash, model.chain, model.q_min, model.q_max ) )
+			ROS_INFO("Robot model saved in the cache %s", model_cache.c_str());
+		else
+			ROS_WARN("Cannot write the model cache %s", model_cache.c_str());
+	}
+	return true;
+}
+
+
+bool loadRobotModel( const ros::NodeHandle &nh, RobotModel &model, const std::string &model_cache,
+		const std::string &base_link, const std::string &tip_link ) {
+
+	model.robot_description.clear();
+	robotDescription( nh, model.robot_description );
+	model.base_link = base_link;
+	model.tip_link = tip_link;
+	return buildRobotModel( model, model_cache );
+}
+
+
+boost::shared_ptr<const RobotModel> RobotModelRegistry::load( const ros::NodeHandle &nh, const std::string &model_cache,
+		const std::string &base_link, const std::string &tip_link ) {
+
+	std::string urdf;
+	robotDescription( nh, urdf );
+
+	boost::mutex::scoped_lock lock( _mutex );
+	const std::string model_key = urdf.empty() ? "cache:" + model_cache : urdf + '\n' + base_link + '\n' + tip_link;
+	std::map< std::string, boost::shared_ptr<const RobotModel> >::const_iterator it = _models.find( model_key );
+	if( it != _models.end() ) return it->second;
+
+	boost::shared_ptr<RobotModel> model( new RobotModel );
+	model->robot_description = urdf;
+	model->base_link = base_link;
+	model->tip_link = tip_link;
+	if( !buildRobotModel( *model, model_cache ) ) return boost::shared_ptr<const RobotModel>();
+
+	_models[ model_key ] = model;
+	return model;
+}
+
+
+boost::shared_ptr<const JointTrajectoryCache> RobotModelRegistry::trajectory( const RobotModel *model, const std::vector<double> &signature ) {
+	boost::mutex::scoped_lock lock( _mutex );
+	std::map< TrajectoryKey, boost::shared_ptr<const JointTrajectoryCache> >::const_iterator it =
+		_trajectories.find( TrajectoryKey( model, signature ) );
+	return it != _trajectories.end() ? it->second : boost::shared_ptr<const JointTrajectoryCache>();
+}
+
+
+void RobotModelRegistry::addTrajectory( const RobotModel *model, const std::vector<double> &signature,
+		const boost::shared_ptr<const JointTrajectoryCache> &table ) {
+	boost::mutex::scoped_lock lock( _mutex );
+	_trajectories[ TrajectoryKey( model, signature ) ] = table;
+}
+
+
+size_t RobotModelRegistry::size() {
+	boost::mutex::scoped_lock lock( _mutex );
+	return _models.size();
+}
+
+}
@@ -0,0 +1,80 @@
+#include "iiwa_kdl/rt_thread.h"
+
+#include <alloca.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+
+namespace iiwa_kdl {
+
+ThreadRtConfig loadThreadRtConfig( const ros::NodeHandle &nh, const std::string &name ) {
+	ThreadRtConfig cfg;
+	cfg.name = name;
+	nh.param( "rt/" + name + "/policy", cfg.policy, std::string("other") );
+	nh.param( "rt/" + name + "/priority", cfg.priority, 0 );
+	nh.param( "rt/" + name + "/cpu", cfg.cpu, -1 );
+	nh.param( "rt/stack_prefault", cfg.stack_prefault, 64*1024 );
+	return cfg;
+}
+
+
+//Touch the stack pages, so that they are already mapped (and locked) when the loop runs
+static void prefault_stack( int bytes ) {
+	if( bytes <= 0 ) return;
+	volatile unsigned char *buf = (volatile unsigned char *)alloca( bytes );
+	for(int i=0; i<bytes; i+=4096) buf[i] = 0;
+}
+
+
+bool configureCurrentThread( const ThreadRtConfig &cfg ) {
+	bool ok = true;
+
+	int policy = SCHED_OTHER;
+	if( cfg.policy == "fifo" ) policy = SCHED_FIFO;
+	else if( cfg.policy == "rr" ) policy = SCHED_RR;
+	else if( cfg.policy != "other" ) {
+		ROS_WARN("Thread %s: unknown scheduling policy %s", cfg.name.c_str(), cfg.policy.c_str());
+		ok = false;
+	}
+
+	if( policy != SCHED_OTHER ) {
+		sched_param param;
+		param.sched_priority = cfg.priority;
+		const int ret = pthread_setschedparam( pthread_self(), policy, &param );
+		if( ret != 0 ) {
+			ROS_WARN("Thread %s: cannot set %s priority %d (%s)", cfg.name.c_str(), cfg.policy.c_str(), cfg.priority, strerror(ret));
+			ok = false;
+		}
+	}
+
+	if( cfg.cpu >= 0 ) {
+		cpu_set_t set;
+		CPU_ZERO( &set );
+		CPU_SET( cfg.cpu, &set );
+		const int ret = pthread_setaffinity_np( pthread_self(), sizeof(set), &set );
+		if( ret != 0 ) {
+			ROS_WARN("Thread %s: cannot pin to cpu %d (%s)", cfg.name.c_str(), cfg.cpu, strerror(ret));
+			ok = false;
+		}
+	}
+
+	prefault_stack( cfg.stack_prefault );
+	return ok;
+}
+
+
+bool lockProcessMemory( const ros::NodeHandle &nh ) {
+	bool lock;
+	nh.param( "rt/mlockall", lock, false );
+	if( !lock ) return true;
+
+	if( mlockall( MCL_CURRENT | MCL_FUTURE ) != 0 ) {
+		ROS_WARN("mlockall failed (%s)", strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+}
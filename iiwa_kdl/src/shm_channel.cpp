@@ -0,0 +1,201 @@
+#include "iiwa_kdl/shm_channel.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <chrono>
+#include <cstdio>
+
+namespace iiwa_kdl {
+
+//Format of the shared memory object: "IIWASHM1", then the version of the layout
+static const uint64_t SHM_MAGIC = 0x314d485341574949ull;
+static const uint32_t SHM_VERSION = 2;
+
+struct ShmChannel::Layout {
+	//Written last by the creator (release): the rings are initialized when it matches
+	std::atomic<uint64_t> magic;
+	uint32_t version;
+	uint32_t joints;
+	//Physics step of the simulator (ns), 0 until the simulator side sets it
+	std::atomic<uint64_t> step_ns;
+	SpscRing<ShmJointState, RING_SIZE> state;
+	SpscRing<ShmJointCommand, RING_SIZE> command;
+};
+
+
+ShmChannel::ShmChannel() : _layout( 0 ), _role( CONTROLLER ) {
+}
+
+
+ShmChannel::~ShmChannel() {
+	close();
+}
+
+
+static void sleep_us( int us ) {
+	timespec ts;
+	ts.tv_sec = us / 1000000;
+	ts.tv_nsec = ( us % 1000000 )*1000L;
+	nanosleep( &ts, 0 );
+}
+
+
+bool ShmChannel::open( const std::string &name, Role role, double timeout ) {
+	close();
+	_role = role;
+
+	typedef std::chrono::steady_clock clock;
+	const clock::time_point t_end = clock::now() + std::chrono::duration_cast<clock::duration>( std::chrono::duration<double>( timeout ) );
+
+	//The creator sizes and initializes the object, the other side maps it when it is ready
+	bool creator = true;
+	int fd = shm_open( name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0660 );
+	if( fd < 0 && errno == EEXIST ) {
+		creator = false;
+		fd = shm_open( name.c_str(), O_RDWR, 0660 );
+	}
+	if( fd < 0 ) {
+		perror( "shm_open" );
+		return false;
+	}
+
+	if( creator && ftruncate( fd, sizeof(Layout) ) < 0 ) {
+		perror( "ftruncate" );
+		::close( fd );
+		shm_unlink( name.c_str() );
+		return false;
+	}
+
+	//Existing object: wait for the size set by the creator
+	struct stat st;
+	while( !creator && ( fstat( fd, &st ) < 0 || st.st_size < (off_t)sizeof(Layout) ) ) {
+		if( clock::now() >= t_end ) {
+			::close( fd );
+			return false;
+		}
+		sleep_us( 1000 );
+	}
+
+	void *mem = mmap( 0, sizeof(Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+	::close( fd );
+	if( mem == MAP_FAILED ) {
+		perror( "mmap" );
+		return false;
+	}
+	Layout *layout = static_cast<Layout*>( mem );
+
+	if( creator ) {
+		layout->version = SHM_VERSION;
+		layout->joints = IIWA_NJ;
+		layout->step_ns.store( 0, std::memory_order_relaxed );
+		layout->state.reset();
+		layout->command.reset();
+		layout->magic.store( SHM_MAGIC, std::memory_order_release );
+	}
+	else {
+		while( layout->magic.load( std::memory_order_acquire ) != SHM_MAGIC ) {
+			if( clock::now() >= t_end ) {
+				munmap( mem, sizeof(Layout) );
+				return false;
+			}
+			sleep_us( 1000 );
+		}
+		if( layout->version != SHM_VERSION || layout->joints != IIWA_NJ ) {
+			munmap( mem, sizeof(Layout) );
+			return false;
+		}
+	}
+
+	//Records written while this side was not running are stale: drop them
+	if( role == CONTROLLER ) {
+		ShmJointState s;
+		while( layout->state.pop( s ) );
+	}
+	else {
+		ShmJointCommand c;
+		while( layout->command.pop( c ) );
+	}
+
+	//Pages of the rings resident before the control loop
+	mlock( mem, sizeof(Layout) );
+	_layout = layout;
+	return true;
+}
+
+
+void ShmChannel::close() {
+	if( !_layout ) return;
+	munmap( _layout, sizeof(Layout) );
+	_layout = 0;
+}
+
+
+void ShmChannel::unlink( const std::string &name ) {
+	shm_unlink( name.c_str() );
+}
+
+
+void ShmChannel::setStep( double step ) {
+	if( _layout && _role == SIMULATOR && step > 0.0 )
+		_layout->step_ns.store( (uint64_t)( step*1e9 + 0.5 ), std::memory_order_release );
+}
+
+
+bool ShmChannel::writeState( const ShmJointState &s ) {
+	return _layout && _role == SIMULATOR && _layout->state.push( s );
+}
+
+
+bool ShmChannel::readCommand( ShmJointCommand &c ) {
+	return _layout && _role == SIMULATOR && _layout->command.popLatest( c );
+}
+
+
+bool ShmChannel::writeCommand( const ShmJointCommand &c ) {
+	return _layout && _role == CONTROLLER && _layout->command.push( c );
+}
+
+
+bool ShmChannel::readState( ShmJointState &s ) {
+	return _layout && _role == CONTROLLER && _layout->state.popLatest( s );
+}
+
+
+bool ShmChannel::waitState( ShmJointState &s, double timeout, int poll_us ) {
+	typedef std::chrono::steady_clock clock;
+	const clock::time_point t_end = clock::now() + std::chrono::duration_cast<clock::duration>( std::chrono::duration<double>( timeout ) );
+	while( !readState( s ) ) {
+		if( !_layout || clock::now() >= t_end ) return false;
+		sleep_us( poll_us );
+	}
+	return true;
+}
+
+
+double ShmChannel::step() const {
+	return _layout ? _layout->step_ns.load( std::memory_order_acquire )*1e-9 : 0.0;
+}
+
+
+bool ShmChannel::waitStep( double timeout ) {
+	typedef std::chrono::steady_clock clock;
+	const clock::time_point t_end = clock::now() + std::chrono::duration_cast<clock::duration>( std::chrono::duration<double>( timeout ) );
+	while( step() <= 0.0 ) {
+		if( !_layout || clock::now() >= t_end ) return false;
+		sleep_us( 1000 );
+	}
+	return true;
+}
+
+
+uint64_t ShmChannel::dropped() const {
+	if( !_layout ) return 0;
+	return _role == SIMULATOR ? _layout->state.dropped() : _layout->command.dropped();
+}
+
+}
@@ -0,0 +1,35 @@
+#include "iiwa_kdl/start_signal.h"
+
+namespace iiwa_kdl {
+
+StartSignal::StartSignal() : _started( false ) {
+}
+
+
+void StartSignal::init( ros::NodeHandle &nh, bool autostart ) {
+	_started = autostart;
+	if( autostart ) return;
+	_srv = nh.advertiseService( "start", &StartSignal::start_cb, this );
+	ROS_INFO("Call %s/start to start the trajectory execution", nh.getNamespace().c_str());
+}
+
+
+bool StartSignal::start_cb( std_srvs::Trigger::Request &, std_srvs::Trigger::Response &res ) {
+	boost::unique_lock<boost::mutex> lock( _mutex );
+	res.success = !_started;
+	res.message = _started ? "already started" : "started";
+	_started = true;
+	_cond.notify_all();
+	return true;
+}
+
+
+bool StartSignal::wait( const std::atomic<bool> &running ) {
+	boost::unique_lock<boost::mutex> lock( _mutex );
+	//Periodic check of running: stop() does not notify the condition
+	while( !_started && running )
+		_cond.wait_for( lock, boost::chrono::milliseconds( 100 ) );
+	return _started;
+}
+
+}
@@ -0,0 +1,83 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "iiwa_kdl/state_recorder.h"
+
+//Convert a log of the StateRecorder into CSV, oldest record first
+//	state_log_to_csv <log file> [<csv file>]  (default: stdout)
+int main(int argc, char** argv) {
+
+	if( argc < 2 ) {
+		fprintf(stderr, "Usage: %s <log file> [<csv file>]\n", argv[0]);
+		return 1;
+	}
+
+	FILE *in = fopen( argv[1], "rb" );
+	if( !in ) {
+		fprintf(stderr, "Cannot open %s\n", argv[1]);
+		return 1;
+	}
+
+	iiwa_kdl::StateLogHeader hdr;
+	if( fread( &hdr, sizeof(hdr), 1, in ) != 1 || memcmp( hdr.magic, iiwa_kdl::STATE_LOG_MAGIC, sizeof(hdr.magic) ) != 0 ||
+		hdr.record_size != sizeof(iiwa_kdl::StateRecord) || hdr.nj != iiwa_kdl::IIWA_NJ || hdr.capacity == 0 ) {
+		fprintf(stderr, "%s is not a compatible state log\n", argv[1]);
+		fclose( in );
+		return 1;
+	}
+
+	const size_t header_size = ( sizeof(iiwa_kdl::StateLogHeader) + 63 ) & ~(size_t)63;
+	const uint64_t count = hdr.count.load();
+	const uint64_t n = count < hdr.capacity ? count : hdr.capacity;
+	//When the ring has wrapped, the oldest record is the next to be overwritten
+	const uint64_t first = count - n;
+
+	//The recorder sizes the file for its capacity: check it before allocating the records
+	//	(the division keeps capacity*record_size from overflowing)
+	long file_size = -1;
+	if( fseek( in, 0, SEEK_END ) == 0 ) file_size = ftell( in );
+	if( file_size < (long)header_size || hdr.capacity > ( file_size - header_size )/sizeof(iiwa_kdl::StateRecord) ||
+		header_size + hdr.capacity*sizeof(iiwa_kdl::StateRecord) != (uint64_t)file_size ) {
+		fprintf(stderr, "The size of %s does not match its capacity\n", argv[1]);
+		fclose( in );
+		return 1;
+	}
+
+	std::vector<iiwa_kdl::StateRecord> records( hdr.capacity );
+	if( fseek( in, header_size, SEEK_SET ) != 0 ||
+		fread( &records[0], sizeof(iiwa_kdl::StateRecord), hdr.capacity, in ) != hdr.capacity ) {
+		fprintf(stderr, "Truncated log file\n");
+		fclose( in );
+		return 1;
+	}
+	fclose( in );
+
+	FILE *out = argc > 2 ? fopen( argv[2], "w" ) : stdout;
+	if( !out ) {
+		fprintf(stderr, "Cannot open %s\n", argv[2]);
+		return 1;
+	}
+
+	const char *cmd = hdr.command == iiwa_kdl::StateLogHeader::EFFORT ? "tau" : "q_cmd";
+	fprintf(out, "stamp,t_cmd");
+	for(int j=0; j<iiwa_kdl::IIWA_NJ; j++) fprintf(out, ",q%d", j+1);
+	for(int j=0; j<iiwa_kdl::IIWA_NJ; j++) fprintf(out, ",dq%d", j+1);
+	for(int j=0; j<iiwa_kdl::IIWA_NJ; j++) fprintf(out, ",%s%d", cmd, j+1);
+	fprintf(out, ",x,y,z,qx,qy,qz,qw,status\n");
+
+	for(uint64_t i=first; i<count; i++) {
+		const iiwa_kdl::StateRecord &r = records[ i % hdr.capacity ];
+		fprintf(out, "%.6f,%.6f", r.stamp, r.t_cmd);
+		for(int j=0; j<iiwa_kdl::IIWA_NJ; j++) fprintf(out, ",%.9g", r.q[j]);
+		for(int j=0; j<iiwa_kdl::IIWA_NJ; j++) fprintf(out, ",%.9g", r.dq[j]);
+		for(int j=0; j<iiwa_kdl::IIWA_NJ; j++) fprintf(out, ",%.9g", r.cmd[j]);
+		for(int k=0; k<3; k++) fprintf(out, ",%.9g", r.eef_p[k]);
+		for(int k=0; k<4; k++) fprintf(out, ",%.9g", r.eef_quat[k]);
+		fprintf(out, ",%d\n", r.status);
+	}
+
+	if( out != stdout ) fclose( out );
+	return 0;
+}
@@ -0,0 +1,95 @@
+#include "iiwa_kdl/state_recorder.h"
+
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "boost/bind.hpp"
+
+namespace iiwa_kdl {
+
+StateRecorder::StateRecorder() : _fd( -1 ), _map( 0 ), _map_size( 0 ), _header( 0 ), _records( 0 ),
+	_capacity( 0 ), _flush_period( 1.0 ), _stop( false ) {
+}
+
+
+StateRecorder::~StateRecorder() {
+	close();
+}
+
+
+bool StateRecorder::open( const std::string &file, uint64_t capacity, StateLogHeader::Command command, double flush_period ) {
+	close();
+	if( capacity == 0 ) return false;
+
+	//Records start on a cache line
+	const size_t header_size = ( sizeof(StateLogHeader) + 63 ) & ~(size_t)63;
+	const size_t size = header_size + capacity*sizeof(StateRecord);
+
+	_fd = ::open( file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+	if( _fd < 0 ) return false;
+	if( ftruncate( _fd, size ) != 0 ) {
+		::close( _fd );
+		_fd = -1;
+		return false;
+	}
+
+	_map = mmap( 0, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0 );
+	if( _map == MAP_FAILED ) {
+		_map = 0;
+		::close( _fd );
+		_fd = -1;
+		return false;
+	}
+	_map_size = size;
+
+	//Touch all the pages now: no page faults in the control loop
+	memset( _map, 0, size );
+
+	_header = new( _map ) StateLogHeader;
+	memcpy( _header->magic, STATE_LOG_MAGIC, sizeof(STATE_LOG_MAGIC) );
+	_header->record_size = sizeof(StateRecord);
+	_header->nj = IIWA_NJ;
+	_header->capacity = capacity;
+	_header->command = command;
+	_header->count.store( 0, std::memory_order_relaxed );
+
+	_records = (StateRecord *)( (char *)_map + header_size );
+	_capacity = capacity;
+
+	_flush_period = flush_period > 0.0 ? flush_period : 1.0;
+	_stop = false;
+	_flush_thread = boost::thread( boost::bind( &StateRecorder::flush_loop, this ) );
+	return true;
+}
+
+
+void StateRecorder::flush_loop() {
+	while( !_stop.load() ) {
+		boost::this_thread::sleep_for( boost::chrono::microseconds( (int64_t)( _flush_period*1e6 ) ) );
+		//Asynchronous write back of the dirty pages: the writer is never blocked
+		msync( _map, _map_size, MS_ASYNC );
+	}
+}
+
+
+void StateRecorder::close() {
+	if( !_header ) return;
+
+	_stop = true;
+	_flush_thread.join();
+
+	msync( _map, _map_size, MS_SYNC );
+	munmap( _map, _map_size );
+	::close( _fd );
+
+	_fd = -1;
+	_map = 0;
+	_header = 0;
+	_records = 0;
+	_capacity = 0;
+}
+
+}
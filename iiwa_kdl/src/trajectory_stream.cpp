@@ -0,0 +1,338 @@
+#include "iiwa_kdl/trajectory_stream.h"
+
+#include <string.h>
+
+#include <cmath>
+
+namespace iiwa_kdl {
+
+TrajectoryStream::TrajectoryStream() :
+	_gen( 0 ),
+	_lookahead( 0.1 ),
+	_push_gen( 0 ),
+	_push_kind( TrajectoryPoint::HOLD ),
+	_push_last_t( 0.0 ),
+	_win_gen( 0 ),
+	_win_mode( NONE ),
+	_n( 0 ),
+	_holding( true ) {
+
+	_ring.reset();
+	memset( &_sp.q, 0, sizeof(_sp.q) );
+	memset( &_sp.qd, 0, sizeof(_sp.qd) );
+	memset( &_sp.qdd, 0, sizeof(_sp.qdd) );
+	_sp.mode = NONE;
+	_sp.F = KDL::Frame::Identity();
+	_sp.V = KDL::Twist::Zero();
+	_sp.A = KDL::Twist::Zero();
+}
+
+
+void TrajectoryStream::init( ros::NodeHandle &nh, const std::vector<std::string> &joint_names, double lookahead ) {
+	_joint_names = joint_names;
+	_lookahead = lookahead > 0.0 ? lookahead : 0.0;
+	_joint_sub = nh.subscribe("trajectory", 4, &TrajectoryStream::joint_cb, this);
+	_cart_sub = nh.subscribe("cartesian_trajectory", 4, &TrajectoryStream::cartesian_cb, this);
+}
+
+
+void TrajectoryStream::joint_cb( const trajectory_msgs::JointTrajectory::ConstPtr &traj ) {
+	if( !pushJoint( *traj ) ) ROS_WARN_THROTTLE(1.0, "Joint trajectory not accepted or truncated");
+}
+
+
+void TrajectoryStream::cartesian_cb( const trajectory_msgs::MultiDOFJointTrajectory::ConstPtr &traj ) {
+	if( !pushCartesian( *traj ) ) ROS_WARN_THROTTLE(1.0, "Cartesian trajectory not accepted or truncated");
+}
+
+
+bool TrajectoryStream::begin_batch( uint32_t kind, double t0 ) {
+	//Continuation of the current batch: same kind, after its last point
+	if( _push_gen != 0 && kind != TrajectoryPoint::HOLD && kind == _push_kind && t0 > _push_last_t )
+		return false;
+
+	//Preemption: published before the points, the reader drops the older ones from now on
+	if( ++_push_gen == 0 ) _push_gen = 1;
+	_push_kind = kind;
+	_gen.store( _push_gen, std::memory_order_release );
+	return true;
+}
+
+
+bool TrajectoryStream::push( const TrajectoryPoint &p ) {
+	//Never wait in the callback (it can share the thread of the joint states): a full ring
+	//	fails now, the control loop drops the points of a preempted batch at its next update
+	if( !_ring.push( p ) ) return false;
+	_push_last_t = p.t;
+	return true;
+}
+
+
+bool TrajectoryStream::pushJoint( const trajectory_msgs::JointTrajectory &traj ) {
+	boost::unique_lock<boost::mutex> lock( _push_mutex );
+
+	//Message joint of each chain joint
+	unsigned int idx[IIWA_NJ];
+	if( _joint_names.size() != IIWA_NJ ) return false;
+	for(unsigned int i=0; i<IIWA_NJ; i++) {
+		unsigned int k=0;
+		while( k < traj.joint_names.size() && traj.joint_names[k] != _joint_names[i] ) k++;
+		if( k == traj.joint_names.size() ) return false;
+		idx[i] = k;
+	}
+
+	const double t_base = traj.header.stamp.isZero() ? ros::Time::now().toSec() : traj.header.stamp.toSec();
+	TrajectoryPoint p;
+	memset( &p, 0, sizeof(p) );
+
+	if( traj.points.empty() ) {
+		begin_batch( TrajectoryPoint::HOLD, t_base );
+		p.gen = _push_gen;
+		p.kind = TrajectoryPoint::HOLD;
+		p.t = t_base;
+		return push( p );
+	}
+
+	begin_batch( TrajectoryPoint::JOINT, t_base + traj.points[0].time_from_start.toSec() );
+	p.gen = _push_gen;
+	p.kind = TrajectoryPoint::JOINT;
+	for(size_t k=0; k<traj.points.size(); k++) {
+		const trajectory_msgs::JointTrajectoryPoint &pt = traj.points[k];
+		if( pt.positions.size() != traj.joint_names.size() ) return false;
+		p.has_vel = pt.velocities.size() == pt.positions.size();
+		p.t = t_base + pt.time_from_start.toSec();
+		for(unsigned int i=0; i<IIWA_NJ; i++) {
+			p.pos[i] = pt.positions[idx[i]];
+			p.vel[i] = p.has_vel ? pt.velocities[idx[i]] : 0.0;
+		}
+		if( !push( p ) ) return false;
+	}
+	return true;
+}
+
+
+bool TrajectoryStream::pushCartesian( const trajectory_msgs::MultiDOFJointTrajectory &traj ) {
+	boost::unique_lock<boost::mutex> lock( _push_mutex );
+
+	const double t_base = traj.header.stamp.isZero() ? ros::Time::now().toSec() : traj.header.stamp.toSec();
+	TrajectoryPoint p;
+	memset( &p, 0, sizeof(p) );
+
+	if( traj.points.empty() ) {
+		begin_batch( TrajectoryPoint::HOLD, t_base );
+		p.gen = _push_gen;
+		p.kind = TrajectoryPoint::HOLD;
+		p.t = t_base;
+		return push( p );
+	}
+
+	begin_batch( TrajectoryPoint::CARTESIAN, t_base + traj.points[0].time_from_start.toSec() );
+	p.gen = _push_gen;
+	p.kind = TrajectoryPoint::CARTESIAN;
+	for(size_t k=0; k<traj.points.size(); k++) {
+		//End effector: first transform of the point
+		const trajectory_msgs::MultiDOFJointTrajectoryPoint &pt = traj.points[k];
+		if( pt.transforms.empty() ) return false;
+		const geometry_msgs::Transform &tf = pt.transforms[0];
+		p.t = t_base + pt.time_from_start.toSec();
+		p.pos[0] = tf.translation.x;
+		p.pos[1] = tf.translation.y;
+		p.pos[2] = tf.translation.z;
+		p.pos[3] = tf.rotation.x;
+		p.pos[4] = tf.rotation.y;
+		p.pos[5] = tf.rotation.z;
+		p.pos[6] = tf.rotation.w;
+		p.has_vel = !pt.velocities.empty();
+		if( p.has_vel ) {
+			const geometry_msgs::Twist &v = pt.velocities[0];
+			p.vel[0] = v.linear.x;
+			p.vel[1] = v.linear.y;
+			p.vel[2] = v.linear.z;
+			p.vel[3] = v.angular.x;
+			p.vel[4] = v.angular.y;
+			p.vel[5] = v.angular.z;
+		}
+		if( !push( p ) ) return false;
+	}
+	return true;
+}
+
+
+TrajectoryStream::Mode TrajectoryStream::update( double t, const double *q_cmd, const KDL::Frame &F_cmd ) {
+
+	//New batch: the points of the older ones are dropped (serial number arithmetic, no wrap issue)
+	const uint32_t g = _gen.load( std::memory_order_acquire );
+	const TrajectoryPoint *p;
+	if( g != _win_gen ) {
+		while( ( p = _ring.peek() ) && (int32_t)( p->gen - g ) < 0 ) _ring.drop();
+		//The first point can still be on its way: the current window is kept until then
+		if( p && p->gen == g ) {
+			start_batch( *p, t, q_cmd, F_cmd );
+			if( p->kind == TrajectoryPoint::HOLD ) _ring.drop();
+		}
+	}
+
+	//Current segment: [_win[0], _win[1]]
+	//	The knots got their velocity when their successor was appended: only a knot left
+	//	without a successor (underrun) reaches _win[0] unfixed, it stops there
+	while( _n >= 2 && _win[1].t <= t ) {
+		memmove( _win, _win + 1, ( _n - 1 )*sizeof(Knot) );
+		_n--;
+	}
+	if( _n >= 1 && !_win[0].vel_fixed ) {
+		memset( _win[0].vel, 0, sizeof(_win[0].vel) );
+		_win[0].vel_fixed = true;
+	}
+
+	//Window: the next points while they are within the lookahead, at least two after the current one
+	while( _win_mode != NONE && _n < WINDOW && ( p = _ring.peek() ) && p->gen == _win_gen && ( _n < 3 || p->t <= t + _lookahead ) ) {
+		append( *p );
+		_ring.drop();
+	}
+
+	if( _win_mode != NONE ) sample( t );
+	return _sp.mode;
+}
+
+
+void TrajectoryStream::start_batch( const TrajectoryPoint &first, double t, const double *q_cmd, const KDL::Frame &F_cmd ) {
+	_win_gen = first.gen;
+
+	//Hold: the current setpoint, at rest
+	Mode mode = first.kind == TrajectoryPoint::JOINT ? JOINT : first.kind == TrajectoryPoint::CARTESIAN ? CARTESIAN : _win_mode;
+	if( mode == NONE ) return;
+	const bool rest = first.kind == TrajectoryPoint::HOLD;
+	//Same kind: the batch starts from the setpoint and its velocity, else from the current command
+	const bool cont = mode == _sp.mode;
+
+	Knot &a = _win[0];
+	a.t = t;
+	a.vel_fixed = true;
+	memset( a.vel, 0, sizeof(a.vel) );
+	if( mode == JOINT ) {
+		for(unsigned int i=0; i<IIWA_NJ; i++) {
+			a.pos[i] = cont ? _sp.q[i] : q_cmd[i];
+			if( cont && !rest ) a.vel[i] = _sp.qd[i];
+		}
+	}
+	else {
+		const KDL::Frame &F = cont ? _sp.F : F_cmd;
+		for(int i=0; i<3; i++) a.pos[i] = F.p(i);
+		F.M.GetQuaternion( a.pos[3], a.pos[4], a.pos[5], a.pos[6] );
+		if( cont && !rest ) {
+			for(int i=0; i<3; i++) {
+				a.vel[i] = _sp.V.vel(i);
+				a.vel[3+i] = _sp.V.rot(i);
+			}
+		}
+	}
+	_n = 1;
+	_win_mode = mode;
+}
+
+
+void TrajectoryStream::append( const TrajectoryPoint &p ) {
+	//Times must increase: late points (before the start of the batch) are skipped
+	if( p.t <= _win[_n-1].t ) return;
+	Knot &k = _win[_n++];
+	k.t = p.t;
+	memcpy( k.pos, p.pos, sizeof(k.pos) );
+	memcpy( k.vel, p.vel, sizeof(k.vel) );
+	k.vel_fixed = p.has_vel;
+	//Cartesian: unit quaternion
+	if( _win_mode == CARTESIAN ) {
+		const double n = sqrt( k.pos[3]*k.pos[3] + k.pos[4]*k.pos[4] + k.pos[5]*k.pos[5] + k.pos[6]*k.pos[6] );
+		if( n > 0.0 ) for(int i=3; i<7; i++) k.pos[i] /= n;
+		else k.pos[6] = 1.0;
+	}
+	//The previous knot has both neighbours now
+	if( _n >= 3 && !_win[_n-2].vel_fixed ) finite_difference( _n-2 );
+}
+
+
+static KDL::Rotation knot_rotation( const double *pos ) {
+	return KDL::Rotation::Quaternion( pos[3], pos[4], pos[5], pos[6] );
+}
+
+
+//Velocity of knot k from its neighbours, fixed from now on
+void TrajectoryStream::finite_difference( unsigned int k ) {
+	const Knot &a = _win[k-1];
+	const Knot &b = _win[k+1];
+	const double dt = b.t - a.t;
+	Knot &c = _win[k];
+	if( _win_mode == JOINT ) {
+		for(unsigned int i=0; i<IIWA_NJ; i++) c.vel[i] = ( b.pos[i] - a.pos[i] )/dt;
+	}
+	else {
+		for(int i=0; i<3; i++) c.vel[i] = ( b.pos[i] - a.pos[i] )/dt;
+		const KDL::Vector w = KDL::diff( knot_rotation( a.pos ), knot_rotation( b.pos ), dt );
+		for(int i=0; i<3; i++) c.vel[3+i] = w(i);
+	}
+	c.vel_fixed = true;
+}
+
+
+//Cubic Hermite on [0, h]: value, first and second time derivative at s = t/h
+static inline void hermite( double s, double h, double p0, double v0, double p1, double v1, double &p, double &v, double &a ) {
+	const double s2 = s*s;
+	const double s3 = s2*s;
+	p = ( 2*s3 - 3*s2 + 1 )*p0 + ( s3 - 2*s2 + s )*h*v0 + ( -2*s3 + 3*s2 )*p1 + ( s3 - s2 )*h*v1;
+	v = ( ( 6*s2 - 6*s )*p0 + ( 3*s2 - 4*s + 1 )*h*v0 + ( -6*s2 + 6*s )*p1 + ( 3*s2 - 2*s )*h*v1 )/h;
+	a = ( ( 12*s - 6 )*p0 + ( 6*s - 4 )*h*v0 + ( -12*s + 6 )*p1 + ( 6*s - 2 )*h*v1 )/( h*h );
+}
+
+
+void TrajectoryStream::sample( double t ) {
+
+	_sp.mode = _win_mode;
+	_holding = _n < 2 || t < _win[0].t;
+	if( _holding ) {
+		//Last point (or before the first one): at rest
+		const Knot &k = _win[0];
+		if( _win_mode == JOINT ) {
+			memcpy( _sp.q, k.pos, sizeof(_sp.q) );
+			memset( _sp.qd, 0, sizeof(_sp.qd) );
+			memset( _sp.qdd, 0, sizeof(_sp.qdd) );
+		}
+		else {
+			_sp.F = KDL::Frame( knot_rotation( k.pos ), KDL::Vector( k.pos[0], k.pos[1], k.pos[2] ) );
+			_sp.V = KDL::Twist::Zero();
+			_sp.A = KDL::Twist::Zero();
+		}
+		return;
+	}
+
+	//End of the segment without a successor: the setpoint stops there
+	if( !_win[1].vel_fixed ) {
+		memset( _win[1].vel, 0, sizeof(_win[1].vel) );
+		_win[1].vel_fixed = true;
+	}
+
+	const Knot &k0 = _win[0];
+	const Knot &k1 = _win[1];
+	const double h = k1.t - k0.t;
+	const double s = ( t - k0.t )/h;
+
+	if( _win_mode == JOINT ) {
+		for(unsigned int i=0; i<IIWA_NJ; i++)
+			hermite( s, h, k0.pos[i], k0.vel[i], k1.pos[i], k1.vel[i], _sp.q[i], _sp.qd[i], _sp.qdd[i] );
+		return;
+	}
+
+	//Position, then the rotation vector from the orientation of k0 (base frame)
+	KDL::Vector p, v, a;
+	for(int i=0; i<3; i++)
+		hermite( s, h, k0.pos[i], k0.vel[i], k1.pos[i], k1.vel[i], p(i), v(i), a(i) );
+	const KDL::Rotation R0 = knot_rotation( k0.pos );
+	const KDL::Vector r1 = KDL::diff( R0, knot_rotation( k1.pos ) );
+	KDL::Vector r, w, dw;
+	for(int i=0; i<3; i++)
+		hermite( s, h, 0.0, k0.vel[3+i], r1(i), k1.vel[3+i], r(i), w(i), dw(i) );
+
+	_sp.F = KDL::Frame( KDL::addDelta( R0, r ), p );
+	_sp.V = KDL::Twist( v, w );
+	_sp.A = KDL::Twist( a, dw );
+}
+
+}
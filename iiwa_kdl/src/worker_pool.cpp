@@ -0,0 +1,58 @@
+#include "iiwa_kdl/worker_pool.h"
+
+#include "boost/bind.hpp"
+
+namespace iiwa_kdl {
+
+WorkerPool::WorkerPool( int n_workers ) : _n( n_workers ), _generation( 0 ), _pending( 0 ), _quit( false ) {
+	if( _n <= 0 ) _n = boost::thread::hardware_concurrency();
+	if( _n <= 0 ) _n = 1;
+
+	for(int i=0; i<_n; i++)
+		_threads.create_thread( boost::bind( &WorkerPool::worker, this, i ) );
+}
+
+
+WorkerPool::~WorkerPool() {
+	{
+		boost::mutex::scoped_lock lock( _mutex );
+		_quit = true;
+	}
+	_start_cv.notify_all();
+	_threads.join_all();
+}
+
+
+void WorkerPool::run( const boost::function<void(int)> &job ) {
+	boost::mutex::scoped_lock lock( _mutex );
+	_job = job;
+	_pending = _n;
+	_generation++;
+	_start_cv.notify_all();
+
+	while( _pending > 0 ) _done_cv.wait( lock );
+	_job.clear();
+}
+
+
+void WorkerPool::worker( int index ) {
+	uint64_t generation = 0;
+
+	while( true ) {
+		boost::function<void(int)> job;
+		{
+			boost::mutex::scoped_lock lock( _mutex );
+			while( !_quit && _generation == generation ) _start_cv.wait( lock );
+			if( _quit ) return;
+			generation = _generation;
+			job = _job;
+		}
+
+		job( index );
+
+		boost::mutex::scoped_lock lock( _mutex );
+		if( --_pending == 0 ) _done_cv.notify_one();
+	}
+}
+
+}
@@ -0,0 +1,277 @@
+#!/usr/bin/env python
+#Generate the simplified collision meshes of the iiwa links from the visual STLs
+#	decimate: vertex clustering on a uniform grid, the cell size is the smallest one
+#	that keeps the mesh inside the triangle budget
+#	hull: convex hull of the mesh, its vertices are clustered the same way until the
+#	hull fits the budget. A hull is a single convex body for the contact checking
+#
+#	gen_collision_lod.py --method hull --budget 200 --out meshes/collision/hull meshes/link_*.stl
+#
+#Only the standard library: the script runs in the build of the package
+
+import argparse
+import math
+import os
+import struct
+import sys
+
+#Grid of the hull vertices (m)
+QUANTUM = 1e-6
+
+
+def read_stl( path ):
+	#Triangles as tuples of 3 vertices, binary or ascii STL
+	with open( path, 'rb' ) as f:
+		data = f.read()
+	if len( data ) >= 84:
+		n = struct.unpack( '<I', data[ 80:84 ] )[ 0 ]
+		#Binary files can start with "solid" too: check the size
+		if len( data ) == 84 + 50*n:
+			tris = []
+			for t in range( n ):
+				v = struct.unpack( '<12f', data[ 84 + 50*t : 84 + 50*t + 48 ] )
+				tris.append( ( v[ 3:6 ], v[ 6:9 ], v[ 9:12 ] ) )
+			return tris
+
+	vertices = []
+	for line in data.decode( 'ascii', 'replace' ).splitlines():
+		words = line.split()
+		if len( words ) == 4 and words[ 0 ] == 'vertex':
+			vertices.append( tuple( float( w ) for w in words[ 1: ] ) )
+	return [ tuple( vertices[ i : i + 3 ] ) for i in range( 0, len( vertices ) - 2, 3 ) ]
+
+
+def sub( a, b ): return ( a[ 0 ] - b[ 0 ], a[ 1 ] - b[ 1 ], a[ 2 ] - b[ 2 ] )
+def dot( a, b ): return a[ 0 ]*b[ 0 ] + a[ 1 ]*b[ 1 ] + a[ 2 ]*b[ 2 ]
+def cross( a, b ): return ( a[ 1 ]*b[ 2 ] - a[ 2 ]*b[ 1 ], a[ 2 ]*b[ 0 ] - a[ 0 ]*b[ 2 ], a[ 0 ]*b[ 1 ] - a[ 1 ]*b[ 0 ] )
+def norm( a ): return math.sqrt( dot( a, a ) )
+
+
+def write_stl( path, name, tris ):
+	#Binary STL. The header must not start with "solid": some readers take it for ascii
+	with open( path, 'wb' ) as f:
+		header = ( 'lbr_iiwa collision mesh %s' % name ).encode( 'ascii' )[ :80 ]
+		f.write( header + b' '*( 80 - len( header ) ) )
+		f.write( struct.pack( '<I', len( tris ) ) )
+		for a, b, c in tris:
+			n = cross( sub( b, a ), sub( c, a ) )
+			l = norm( n )
+			n = ( n[ 0 ]/l, n[ 1 ]/l, n[ 2 ]/l ) if l > 0.0 else ( 0.0, 0.0, 0.0 )
+			f.write( struct.pack( '<12fH', *( n + a + b + c + ( 0, ) ) ) )
+
+
+def indexed( tris ):
+	#Shared vertices and triangles of indices
+	index = {}
+	points = []
+	faces = []
+	for t in tris:
+		face = []
+		for v in t:
+			if v not in index:
+				index[ v ] = len( points )
+				points.append( v )
+			face.append( index[ v ] )
+		faces.append( tuple( face ) )
+	return points, faces
+
+
+def bounds( points ):
+	lo = tuple( min( p[ k ] for p in points ) for k in range( 3 ) )
+	hi = tuple( max( p[ k ] for p in points ) for k in range( 3 ) )
+	return lo, hi
+
+
+def cluster( points, cell, keep = None ):
+	#Map each point to the representative of its grid cell
+	#	keep = None: mean of the cell, else the point of the cell with the largest keep(p)
+	cells = {}
+	for i, p in enumerate( points ):
+		key = ( int( math.floor( p[ 0 ]/cell ) ), int( math.floor( p[ 1 ]/cell ) ), int( math.floor( p[ 2 ]/cell ) ) )
+		cells.setdefault( key, [] ).append( i )
+	rep = [ 0 ]*len( points )
+	out = []
+	for members in cells.values():
+		if keep is None:
+			m = len( members )
+			q = tuple( sum( points[ i ][ k ] for i in members )/m for k in range( 3 ) )
+		else:
+			q = points[ max( members, key = lambda i: keep( points[ i ] ) ) ]
+		for i in members: rep[ i ] = len( out )
+		out.append( q )
+	return out, rep
+
+
+def decimate_cell( points, faces, cell ):
+	out, rep = cluster( points, cell )
+	seen = set()
+	tris = []
+	for f in faces:
+		a, b, c = rep[ f[ 0 ] ], rep[ f[ 1 ] ], rep[ f[ 2 ] ]
+		#Collapsed and duplicated triangles (same vertices, any order)
+		if a == b or b == c or a == c: continue
+		key = tuple( sorted( ( a, b, c ) ) )
+		if key in seen: continue
+		seen.add( key )
+		tris.append( ( out[ a ], out[ b ], out[ c ] ) )
+	return tris
+
+
+def smallest_cell( fits, size ):
+	#Bisection of the cell size on a log scale: smallest cell for which fits(cell) holds
+	#	Too large cells can leave a degenerate mesh: start from the largest one that fits
+	lo, hi = size*1e-4, size
+	best = fits( hi )
+	while best is None and hi > 4*lo:
+		hi *= 0.5
+		best = fits( hi )
+	if best is None: return None
+	for it in range( 30 ):
+		mid = math.sqrt( lo*hi )
+		res = fits( mid )
+		if res is None: lo = mid
+		else: hi, best = mid, res
+		if hi/lo < 1.02: break
+	return best
+
+
+def decimate( tris, budget ):
+	points, faces = indexed( tris )
+	if len( faces ) <= budget: return tris
+	lo, hi = bounds( points )
+	size = max( hi[ k ] - lo[ k ] for k in range( 3 ) )
+
+	def fits( cell ):
+		res = decimate_cell( points, faces, cell )
+		return res if len( res ) <= budget else None
+	return smallest_cell( fits, size )
+
+
+def convex_hull( points ):
+	#Quickhull: faces (i, j, k) counter clockwise seen from outside, each face keeps the
+	#	points outside of it not yet assigned to another face (conflict list).
+	#	The points are rounded to QUANTUM and the predicates are exact integer arithmetic:
+	#	the nearly coplanar points of the cylindrical parts cannot make a concave hull
+	points = list( set( tuple( int( round( x/QUANTUM ) ) for x in p ) for p in points ) )
+	if len( points ) < 4: return []
+
+	def normal( i, j, k ):
+		return cross( sub( points[ j ], points[ i ] ), sub( points[ k ], points[ i ] ) )
+
+	#Initial tetrahedron from extreme points
+	a = min( range( len( points ) ), key = lambda i: points[ i ] )
+	b = max( range( len( points ) ), key = lambda i: dot( sub( points[ i ], points[ a ] ), sub( points[ i ], points[ a ] ) ) )
+	ab = sub( points[ b ], points[ a ] )
+	c = max( range( len( points ) ), key = lambda i: dot( cross( ab, sub( points[ i ], points[ a ] ) ), cross( ab, sub( points[ i ], points[ a ] ) ) ) )
+	n = normal( a, b, c )
+	d = max( range( len( points ) ), key = lambda i: abs( dot( n, sub( points[ i ], points[ a ] ) ) ) )
+	if dot( n, sub( points[ d ], points[ a ] ) ) == 0: return []
+	if dot( n, sub( points[ d ], points[ a ] ) ) > 0: b, c = c, b
+
+	#Face: plane (integer normal and offset) and conflict list. Edge (i, j) -> face on its left
+	faces = {}
+	edge_face = {}
+
+	def add( f, candidates ):
+		i, j, k = f
+		nrm = normal( i, j, k )
+		off = dot( nrm, points[ i ] )
+		outside = []
+		rest = []
+		for p in candidates:
+			( outside if dot( nrm, points[ p ] ) > off else rest ).append( p )
+		faces[ f ] = ( nrm, off, outside )
+		for e in ( ( i, j ), ( j, k ), ( k, i ) ): edge_face[ e ] = f
+		return rest
+
+	rest = [ i for i in range( len( points ) ) if i not in ( a, b, c, d ) ]
+	for f in ( ( a, b, c ), ( a, d, b ), ( b, d, c ), ( c, d, a ) ): rest = add( f, rest )
+
+	pending = [ f for f in faces if faces[ f ][ 2 ] ]
+	while pending:
+		f0 = pending.pop()
+		if f0 not in faces or not faces[ f0 ][ 2 ]: continue
+		nrm, off, outside = faces[ f0 ]
+		p = max( outside, key = lambda i: dot( nrm, points[ i ] ) )
+		q = points[ p ]
+
+		#Visible faces: flood fill from f0 through the shared edges
+		visible = set( [ f0 ] )
+		stack = [ f0 ]
+		while stack:
+			i, j, k = stack.pop()
+			for e in ( ( j, i ), ( k, j ), ( i, k ) ):
+				g = edge_face.get( e )
+				if g is not None and g not in visible and dot( faces[ g ][ 0 ], q ) > faces[ g ][ 1 ]:
+					visible.add( g )
+					stack.append( g )
+
+		#Horizon: edges of a visible face whose twin is not visible
+		orphans = []
+		horizon = []
+		for f in visible:
+			i, j, k = f
+			orphans.extend( x for x in faces[ f ][ 2 ] if x != p )
+			for e in ( ( i, j ), ( j, k ), ( k, i ) ):
+				if edge_face.get( ( e[ 1 ], e[ 0 ] ) ) not in visible: horizon.append( e )
+		for f in visible:
+			i, j, k = f
+			del faces[ f ]
+			for e in ( ( i, j ), ( j, k ), ( k, i ) ):
+				if edge_face.get( e ) == f: del edge_face[ e ]
+		for i, j in horizon:
+			f = ( i, j, p )
+			orphans = add( f, orphans )
+			if faces[ f ][ 2 ]: pending.append( f )
+
+	scale = lambda v: ( v[ 0 ]*QUANTUM, v[ 1 ]*QUANTUM, v[ 2 ]*QUANTUM )
+	return [ ( scale( points[ i ] ), scale( points[ j ] ), scale( points[ k ] ) ) for i, j, k in faces ]
+
+
+def hull( tris, budget ):
+	points, faces = indexed( tris )
+	exact = convex_hull( points )
+	if len( exact ) <= budget: return exact
+
+	#Cluster the hull vertices, keeping the outermost one of each cell: the
+	#	simplified hull stays close to the exact one
+	vertices = list( set( v for t in exact for v in t ) )
+	lo, hi = bounds( vertices )
+	center = tuple( 0.5*( lo[ k ] + hi[ k ] ) for k in range( 3 ) )
+	size = max( hi[ k ] - lo[ k ] for k in range( 3 ) )
+	outer = lambda p: norm( sub( p, center ) )
+
+	def fits( cell ):
+		reduced, rep = cluster( vertices, cell, outer )
+		res = convex_hull( reduced )
+		return res if res and len( res ) <= budget else None
+	return smallest_cell( fits, size )
+
+
+def main():
+	parser = argparse.ArgumentParser( description = 'Generate simplified collision meshes from STL meshes' )
+	parser.add_argument( 'meshes', nargs = '+' )
+	parser.add_argument( '--method', choices = [ 'decimate', 'hull' ], default = 'decimate' )
+	parser.add_argument( '--budget', type = int, default = 1000, help = 'Maximum triangles of each mesh' )
+	parser.add_argument( '--out', required = True, help = 'Output directory, same file names of the inputs' )
+	args = parser.parse_args()
+
+	if args.budget < 4:
+		sys.stderr.write( 'The triangle budget must be at least 4\n' )
+		return 1
+	if not os.path.isdir( args.out ): os.makedirs( args.out )
+
+	for path in args.meshes:
+		tris = read_stl( path )
+		out = decimate( tris, args.budget ) if args.method == 'decimate' else hull( tris, args.budget )
+		if not out:
+			sys.stderr.write( '%s: cannot simplify the mesh\n' % path )
+			return 1
+		name = os.path.basename( path )
+		write_stl( os.path.join( args.out, name ), os.path.splitext( name )[ 0 ], out )
+		print( '%s: %d -> %d triangles (%s)' % ( name, len( tris ), len( out ), args.method ) )
+	return 0
+
+
+if __name__ == '__main__':
+	sys.exit( main() )